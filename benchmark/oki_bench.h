@@ -0,0 +1,137 @@
+#ifndef OKI_BENCH_H
+#define OKI_BENCH_H
+
+#include "oki_perf_counters.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+/*
+ * Prevents the optimizer from discarding a value we computed only to
+ * measure how long it took to compute.
+ */
+template <typename Type>
+inline void do_not_optimize(Type&& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = static_cast<const void*>(std::addressof(value));
+#endif
+}
+
+/*
+ * Everything a benchmark learns about one measured region, normalized
+ * per iteration of the region and per item processed by it.
+ */
+struct Result
+{
+    std::string name;
+    std::size_t items = 0;
+    std::size_t iterations = 0;
+    double nsPerIter = 0.;
+    CounterSample counters;
+};
+
+/*
+ * Handed to every benchmark. The benchmark performs its (untimed) setup
+ * and then calls measure() exactly once with the region of interest.
+ */
+class State
+{
+public:
+    State(std::size_t items, PerfCounters* counters)
+        : items_(items)
+        , counters_(counters)
+    {
+    }
+
+    // The problem size this benchmark was asked to run at
+    std::size_t items() const noexcept { return items_; }
+
+    /*
+     * Runs func() repeatedly (after one warm-up call) until the minimum
+     * measurement time has elapsed, sampling the hardware counters around
+     * the timed loop as a whole.
+     */
+    template <typename Function>
+    void measure(Function&& func)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        func();
+
+        std::size_t iters = 0;
+        auto begin = Clock::now(), end = begin;
+
+        if (counters_) {
+            counters_->start();
+        }
+
+        do {
+            func();
+            ++iters;
+            end = Clock::now();
+        } while (end - begin < minTime_);
+
+        if (counters_) {
+            sample_ = counters_->stop();
+        }
+
+        iterations_ = iters;
+        elapsedNs_ = std::chrono::duration<double, std::nano>(end - begin)
+                         .count();
+    }
+
+    std::size_t iterations() const noexcept { return iterations_; }
+    double elapsed_ns() const noexcept { return elapsedNs_; }
+    const CounterSample& sample() const noexcept { return sample_; }
+
+private:
+    static constexpr std::chrono::milliseconds minTime_ { 200 };
+
+    std::size_t items_;
+    PerfCounters* counters_;
+
+    std::size_t iterations_ = 0;
+    double elapsedNs_ = 0.;
+    CounterSample sample_;
+};
+
+using BenchFunction = void (*)(State&);
+
+struct Benchmark
+{
+    std::string name;
+    BenchFunction func;
+    std::vector<std::size_t> sizes;
+};
+
+inline std::vector<Benchmark>& registry()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+/*
+ * Declared at namespace scope in a benchmark source file to add a
+ * benchmark (at each of the given problem sizes) to the suite.
+ */
+struct Register
+{
+    Register(std::string name, BenchFunction func,
+        std::vector<std::size_t> sizes)
+    {
+        registry().push_back({ std::move(name), func, std::move(sizes) });
+    }
+};
+}
+
+#endif // OKI_BENCH_H
@@ -0,0 +1,787 @@
+#include "oki/oki_component.h"
+
+#include "oki_bench.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+struct Position
+{
+    float x, y;
+};
+
+struct Velocity
+{
+    float dx, dy;
+};
+
+// Rarely-touched data that rides along with a Position
+struct Metadata
+{
+    char name[48];
+    std::uint64_t flags;
+};
+
+struct FatBody
+{
+    Position pos;
+    Metadata meta;
+};
+
+using SplitBody = oki::Split<Position, Metadata>;
+
+struct RowBody
+{
+    float velX, velY, accX, accY, posX, posY, mass, drag;
+};
+
+struct ColumnBody
+{
+    float velX, velY, accX, accY, posX, posY, mass, drag;
+};
+}
+
+template <>
+struct oki::StoreAsColumns<ColumnBody> : std::true_type
+{ };
+
+namespace {
+// Configuration that many entities have identical copies of
+struct Palette
+{
+    int id;
+    float weights[15];
+
+    bool operator==(const Palette& that) const
+    {
+        return id == that.id
+            && std::equal(std::begin(weights), std::end(weights),
+                std::begin(that.weights));
+    }
+};
+
+struct SharedPalette : Palette
+{ };
+}
+
+template <>
+struct std::hash<SharedPalette>
+{
+    std::size_t operator()(const SharedPalette& palette) const noexcept
+    {
+        return std::hash<int> {}(palette.id);
+    }
+};
+
+template <>
+struct oki::StoreShared<SharedPalette> : std::true_type
+{ };
+
+namespace {
+// A variable-length payload, e.g. a path or an inventory
+struct Waypoints
+{
+    std::vector<float> points;
+};
+
+struct WaypointTag;
+using WaypointBlob = oki::Blob<float, WaypointTag>;
+
+// An ID from elsewhere (e.g. the network) to be mapped back to an entity
+struct RemoteId
+{
+    std::uint64_t id;
+};
+
+struct IndexedRemoteId
+{
+    std::uint64_t id;
+};
+}
+
+template <>
+struct oki::IndexedBy<IndexedRemoteId>
+    : oki::Indexes<oki::HashIndex<&IndexedRemoteId::id>>
+{ };
+
+namespace {
+
+const std::vector<std::size_t> sizes { 1'000, 100'000, 1'000'000 };
+const std::vector<std::size_t> smallSizes { 1'000, 10'000, 100'000 };
+
+void for_each_one(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        compMan.bind_component(compMan.create_entity(), Position { 1.f, 2.f });
+    }
+
+    state.measure([&] {
+        compMan.for_each<Position>([](oki::Entity, Position& pos) {
+            pos.x += 1.f;
+            pos.y += 1.f;
+        });
+    });
+}
+
+void for_each_two(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, Position { 1.f, 2.f });
+        compMan.bind_component(entity, Velocity { 0.5f, 0.5f });
+    }
+
+    state.measure([&] {
+        compMan.for_each<Position, Velocity>(
+            [](oki::Entity, Position& pos, const Velocity& vel) {
+                pos.x += vel.dx;
+                pos.y += vel.dy;
+            });
+    });
+}
+
+void get_component_all(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    std::vector<oki::Entity> entities;
+
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, Position { 1.f, 2.f });
+        entities.push_back(entity);
+    }
+
+    state.measure([&] {
+        float sum = 0.f;
+        for (auto entity : entities) {
+            sum += compMan.get_component<Position>(entity).x;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+// The same (ascending) lookups as get_component_all(), through a cursor
+void get_component_accessor(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    std::vector<oki::Entity> entities;
+
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, Position { 1.f, 2.f });
+        entities.push_back(entity);
+    }
+
+    state.measure([&] {
+        auto positions = compMan.get_component_accessor<Position>();
+
+        float sum = 0.f;
+        for (auto entity : entities) {
+            sum += positions.get(entity).x;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void get_components_range(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    std::vector<oki::Entity> entities;
+
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, Position { 1.f, 2.f });
+        compMan.bind_component(entity, Velocity { 3.f, 4.f });
+        entities.push_back(entity);
+    }
+
+    std::vector<std::tuple<Position&, Velocity&>> comps;
+    comps.reserve(entities.size());
+
+    state.measure([&] {
+        comps.clear();
+        compMan.get_components<Position, Velocity>(
+            entities.begin(), entities.end(), std::back_inserter(comps));
+
+        bench::do_not_optimize(comps.data());
+    });
+}
+
+// Entities referring to others at random (e.g. targets) are the case
+// get_components_batch() is for, and only hurts once the data is out of cache
+const std::vector<std::size_t> largeSizes { 1'000'000, 4'000'000 };
+
+std::vector<oki::Entity> fill_shuffled(
+    oki::ComponentManager& compMan, std::size_t n)
+{
+    std::vector<oki::Entity> entities;
+    for (std::size_t i = 0; i != n; ++i) {
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, Position { 1.f, 2.f });
+        entities.push_back(entity);
+    }
+
+    std::shuffle(entities.begin(), entities.end(), std::mt19937_64 { 42 });
+    return entities;
+}
+
+void get_component_random(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    auto entities = fill_shuffled(compMan, state.items());
+
+    state.measure([&] {
+        float sum = 0.f;
+        for (auto entity : entities) {
+            sum += compMan.get_component<Position>(entity).x;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void get_components_batch(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    auto entities = fill_shuffled(compMan, state.items());
+
+    std::vector<std::tuple<Position*>> comps;
+    comps.reserve(entities.size());
+
+    state.measure([&] {
+        comps.clear();
+        compMan.get_components_batch<Position>(
+            entities.begin(), entities.end(), std::back_inserter(comps));
+
+        float sum = 0.f;
+        for (auto [pos] : comps) {
+            sum += pos->x;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+// Iterating the hot part of a component, stored whole vs split
+void hot_fields_whole(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        compMan.bind_component(compMan.create_entity(), FatBody {});
+    }
+
+    state.measure([&] {
+        float sum = 0.f;
+        compMan.for_each<FatBody>(
+            [&](auto, const FatBody& body) { sum += body.pos.x; });
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void hot_fields_split(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        compMan.bind_component(compMan.create_entity(), SplitBody {});
+    }
+
+    state.measure([&] {
+        float sum = 0.f;
+        compMan.for_each<oki::Hot<SplitBody>>(
+            [&](auto, const Position& pos) { sum += pos.x; });
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+template <typename Body>
+void bind_bodies(oki::ComponentManager& compMan, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        auto field = static_cast<float>(i);
+        compMan.bind_component(compMan.create_entity(),
+            Body { field, field, 1.f, 1.f, 0.f, 0.f, 1.f, 0.f });
+    }
+}
+
+// The loops below only touch velX and velY (and keep them away from
+// denormals, which are slow)
+void damp_rows(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_bodies<RowBody>(compMan, state.items());
+
+    state.measure([&] {
+        compMan.for_each<RowBody>([](auto, RowBody& body) {
+            body.velX = body.velX * 0.5f + 1.f;
+            body.velY = body.velY * 0.5f + 1.f;
+        });
+    });
+}
+
+void damp_columns(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_bodies<ColumnBody>(compMan, state.items());
+
+    state.measure([&] {
+        compMan.for_each<ColumnBody>([](auto, auto body) {
+            auto [velX, velY, accX, accY, posX, posY, mass, drag] = body;
+            velX = velX * 0.5f + 1.f;
+            velY = velY * 0.5f + 1.f;
+        });
+    });
+}
+
+void damp_column_spans(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_bodies<ColumnBody>(compMan, state.items());
+    auto view = compMan.get_component_view<ColumnBody>();
+
+    state.measure([&] {
+        auto velX = view.column<0>();
+        auto velY = view.column<1>();
+
+        for (std::size_t i = 0; i != velX.size(); ++i) {
+            velX[i] = velX[i] * 0.5f + 1.f;
+            velY[i] = velY[i] * 0.5f + 1.f;
+        }
+
+        bench::do_not_optimize(velX[0]);
+    });
+}
+
+void spawn_one_by_one(bench::State& state)
+{
+    state.measure([&] {
+        oki::ComponentManager compMan;
+        for (std::size_t i = 0; i != state.items(); ++i) {
+            auto entity = compMan.create_entity();
+            compMan.bind_component(entity, Position { 1.f, 2.f });
+            compMan.bind_component(entity, Velocity { 0.5f, 0.5f });
+        }
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+void spawn_bulk(bench::State& state)
+{
+    state.measure([&] {
+        oki::ComponentManager compMan;
+        compMan.spawn<Position, Velocity>(state.items(), [](std::size_t) {
+            return std::make_tuple(
+                Position { 1.f, 2.f }, Velocity { 0.5f, 0.5f });
+        });
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+// Entities often come a couple at a time (like the pipes in the example),
+// where finding the containers is a large part of the cost
+void spawn_pairs(bench::State& state)
+{
+    state.measure([&] {
+        oki::ComponentManager compMan;
+        for (std::size_t i = 0; i < state.items(); i += 2) {
+            compMan.spawn<Position, Velocity>(2, [](std::size_t) {
+                return std::make_tuple(
+                    Position { 1.f, 2.f }, Velocity { 0.5f, 0.5f });
+            });
+        }
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+void instantiate_pairs(bench::State& state)
+{
+    state.measure([&] {
+        oki::ComponentManager compMan;
+        auto prefab = compMan.create_prefab(
+            Position { 1.f, 2.f }, Velocity { 0.5f, 0.5f });
+
+        for (std::size_t i = 0; i < state.items(); i += 2) {
+            compMan.instantiate(prefab, 2);
+        }
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+// Both destroy benchmarks include spawning the entities (in bulk) first,
+// and destroy every other one
+template <typename Destroy>
+void spawn_then_destroy(bench::State& state, Destroy destroy)
+{
+    state.measure([&] {
+        oki::ComponentManager compMan;
+        auto entities = compMan.spawn<Position, Velocity>(
+            state.items(), [](std::size_t) {
+                return std::make_tuple(Position {}, Velocity {});
+            });
+
+        std::vector<oki::Entity> doomed;
+        for (std::size_t i = 0; i < entities.size(); i += 2) {
+            doomed.push_back(entities[i]);
+        }
+
+        destroy(compMan, doomed);
+        bench::do_not_optimize(compMan);
+    });
+}
+
+void destroy_one_by_one(bench::State& state)
+{
+    spawn_then_destroy(state, [](auto& compMan, const auto& doomed) {
+        for (auto entity : doomed) {
+            compMan.destroy_entity(entity);
+        }
+    });
+}
+
+void destroy_bulk(bench::State& state)
+{
+    spawn_then_destroy(state, [](auto& compMan, const auto& doomed) {
+        compMan.destroy_entities(doomed.begin(), doomed.end());
+    });
+}
+
+// Vehicles with three turrets each, where every turret's offset is relative
+// to its vehicle's
+struct Offset
+{
+    float local, world;
+};
+
+struct Attachment
+{
+    oki::Entity parent;
+};
+
+template <typename Attach>
+void bind_vehicles(oki::ComponentManager& compMan, std::size_t n, Attach attach)
+{
+    for (std::size_t i = 0; i < n; i += 4) {
+        auto vehicle = compMan.create_entity();
+        compMan.bind_component(vehicle, Offset { 1.f, 0.f });
+
+        for (int turret = 0; turret != 3; ++turret) {
+            auto entity = compMan.create_entity();
+            compMan.bind_component(entity, Offset { 0.5f, 0.f });
+            attach(entity, vehicle);
+        }
+    }
+}
+
+void propagate_parent_links(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_vehicles(compMan, state.items(), [&](auto turret, auto vehicle) {
+        compMan.bind_component(turret, Attachment { vehicle });
+    });
+
+    state.measure([&] {
+        compMan.for_each<Offset>([&](oki::Entity entity, Offset& offset) {
+            auto* attached = compMan.get_component_checked<Attachment>(entity);
+            offset.world = offset.local
+                + (attached
+                        ? compMan.get_component<Offset>(attached->parent).world
+                        : 0.f);
+        });
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+void propagate_hierarchy(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_vehicles(compMan, state.items(), [&](auto turret, auto vehicle) {
+        compMan.set_parent(turret, vehicle);
+    });
+
+    state.measure([&] {
+        compMan.propagate<Offset>([](oki::Entity, Offset& offset,
+                                      const Offset* parent) {
+            offset.world = offset.local + (parent ? parent->world : 0.f);
+        });
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+// The per-value work: something derived from a palette alone
+float tint_of(const Palette& palette)
+{
+    float tint = 0.f;
+    for (auto weight : palette.weights) {
+        tint += weight * weight;
+    }
+
+    return tint;
+}
+
+template <typename PaletteType>
+void bind_palettes(oki::ComponentManager& compMan, std::size_t n)
+{
+    constexpr int NUM_PALETTES = 16;
+
+    for (std::size_t i = 0; i != n; ++i) {
+        PaletteType palette {};
+        palette.id = static_cast<int>(i % NUM_PALETTES);
+        std::fill(std::begin(palette.weights), std::end(palette.weights),
+            static_cast<float>(palette.id));
+
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, palette);
+        compMan.bind_component(entity, Position { 1.f, 2.f });
+    }
+}
+
+void shade_per_entity(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_palettes<Palette>(compMan, state.items());
+
+    state.measure([&] {
+        compMan.for_each<Palette, Position>(
+            [](oki::Entity, const Palette& palette, Position& pos) {
+                pos.x = pos.y * tint_of(palette);
+            });
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+void shade_grouped(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    bind_palettes<SharedPalette>(compMan, state.items());
+
+    state.measure([&] {
+        compMan.for_each_group<SharedPalette, Position>(
+            [](const SharedPalette& palette, auto& group) {
+                auto tint = tint_of(palette);
+                group.for_each([tint](oki::Entity, Position& pos) {
+                    pos.x = pos.y * tint;
+                });
+            });
+
+        bench::do_not_optimize(compMan);
+    });
+}
+
+std::size_t num_waypoints(std::size_t idx) { return idx % 16 + 1; }
+
+void sum_vector_payloads(bench::State& state)
+{
+    // Allocate the payloads in a scrambled order, as churn over a long
+    // session would
+    std::vector<std::size_t> order(state.items());
+    for (std::size_t i = 0; i != order.size(); ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937_64 { 42 });
+
+    std::vector<Waypoints> payloads(state.items());
+    for (auto idx : order) {
+        payloads[idx].points.assign(num_waypoints(idx), 1.f);
+    }
+
+    oki::ComponentManager compMan;
+    for (auto& payload : payloads) {
+        compMan.bind_component(compMan.create_entity(), std::move(payload));
+    }
+
+    state.measure([&] {
+        float sum = 0.f;
+        compMan.for_each<Waypoints>([&](oki::Entity, const Waypoints& path) {
+            for (auto point : path.points) {
+                sum += point;
+            }
+        });
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void sum_blob_payloads(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        compMan.bind_component(
+            compMan.create_entity(), WaypointBlob(num_waypoints(i), 1.f));
+    }
+
+    state.measure([&] {
+        float sum = 0.f;
+        compMan.for_each<WaypointBlob>([&](oki::Entity, auto path) {
+            for (auto point : path) {
+                sum += point;
+            }
+        });
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+// Looks up a few hundred random IDs per measurement
+constexpr std::size_t NUM_LOOKUPS = 256;
+
+template <typename IdType>
+std::vector<std::uint64_t> fill_remote_ids(
+    oki::ComponentManager& compMan, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        compMan.bind_component(
+            compMan.create_entity(), IdType { i * 7919 });
+    }
+
+    std::vector<std::uint64_t> lookups;
+    std::mt19937_64 rng { 42 };
+    for (std::size_t i = 0; i != NUM_LOOKUPS; ++i) {
+        lookups.push_back((rng() % n) * 7919);
+    }
+
+    return lookups;
+}
+
+void find_by_scan(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    auto lookups = fill_remote_ids<RemoteId>(compMan, state.items());
+
+    state.measure([&] {
+        std::uint64_t found = 0;
+        for (auto id : lookups) {
+            compMan.for_each<RemoteId>([&](oki::Entity, RemoteId& remote) {
+                found += (remote.id == id);
+            });
+        }
+
+        bench::do_not_optimize(found);
+    });
+}
+
+void find_by_index(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    auto lookups = fill_remote_ids<IndexedRemoteId>(compMan, state.items());
+
+    state.measure([&] {
+        std::uint64_t found = 0;
+        for (auto id : lookups) {
+            found += compMan.find_by<&IndexedRemoteId::id>(id).has_value();
+        }
+
+        bench::do_not_optimize(found);
+    });
+}
+
+void sum_for_each(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        compMan.bind_component(compMan.create_entity(), Position { 1.f, 2.f });
+    }
+
+    state.measure([&] {
+        double sum = 0.;
+        compMan.for_each<Position>(
+            [&](oki::Entity, const Position& pos) { sum += pos.x * pos.y; });
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void sum_reduce(bench::State& state)
+{
+    oki::ComponentManager compMan;
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        compMan.bind_component(compMan.create_entity(), Position { 1.f, 2.f });
+    }
+
+    state.measure([&] {
+        double sum = compMan.reduce<Position>(
+            0.,
+            [](oki::Entity, const Position& pos) {
+                return static_cast<double>(pos.x * pos.y);
+            },
+            [](double lhs, double rhs) { return lhs + rhs; });
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+// Just big enough for reduce() to use a few threads, so that what it costs
+// to hand them work (once per frame, say) is a large share of the total
+const std::vector<std::size_t> frameSizes { 20'000, 50'000, 200'000 };
+
+bench::Register r1 { "ComponentManager/for_each<1>", for_each_one, sizes };
+bench::Register r2 { "ComponentManager/for_each<2>", for_each_two, sizes };
+bench::Register r3 { "ComponentManager/get_component", get_component_all,
+    sizes };
+bench::Register r4 { "ComponentManager/get_component_accessor",
+    get_component_accessor, sizes };
+bench::Register r5 { "ComponentManager/get_components_range",
+    get_components_range, sizes };
+bench::Register r6 { "ComponentManager/get_component_random",
+    get_component_random, largeSizes };
+bench::Register r7 { "ComponentManager/get_components_batch",
+    get_components_batch, largeSizes };
+bench::Register r8 { "ComponentManager/hot_fields_whole", hot_fields_whole,
+    sizes };
+bench::Register r9 { "ComponentManager/hot_fields_split", hot_fields_split,
+    sizes };
+bench::Register r10 { "ComponentManager/sum_for_each", sum_for_each, sizes };
+bench::Register r11 { "ComponentManager/sum_reduce", sum_reduce, sizes };
+bench::Register r12 { "ComponentManager/damp_rows", damp_rows, sizes };
+bench::Register r13 { "ComponentManager/damp_columns", damp_columns, sizes };
+bench::Register r14 { "ComponentManager/damp_column_spans", damp_column_spans,
+    sizes };
+bench::Register r15 { "ComponentManager/spawn_one_by_one", spawn_one_by_one,
+    smallSizes };
+bench::Register r16 { "ComponentManager/spawn_bulk", spawn_bulk, smallSizes };
+bench::Register r17 { "ComponentManager/destroy_one_by_one",
+    destroy_one_by_one, smallSizes };
+bench::Register r18 { "ComponentManager/destroy_bulk", destroy_bulk,
+    smallSizes };
+bench::Register r19 { "ComponentManager/spawn_pairs", spawn_pairs,
+    smallSizes };
+bench::Register r20 { "ComponentManager/instantiate_pairs", instantiate_pairs,
+    smallSizes };
+bench::Register r21 { "ComponentManager/propagate_parent_links",
+    propagate_parent_links, sizes };
+bench::Register r22 { "ComponentManager/propagate_hierarchy",
+    propagate_hierarchy, sizes };
+bench::Register r23 { "ComponentManager/shade_per_entity", shade_per_entity,
+    sizes };
+bench::Register r24 { "ComponentManager/shade_grouped", shade_grouped,
+    sizes };
+bench::Register r25 { "ComponentManager/sum_vector_payloads",
+    sum_vector_payloads, sizes };
+bench::Register r26 { "ComponentManager/sum_blob_payloads", sum_blob_payloads,
+    sizes };
+bench::Register r27 { "ComponentManager/find_by_scan", find_by_scan,
+    smallSizes };
+bench::Register r28 { "ComponentManager/find_by_index", find_by_index,
+    smallSizes };
+bench::Register r29 { "ComponentManager/sum_for_each_per_frame",
+    sum_for_each, frameSizes };
+bench::Register r30 { "ComponentManager/sum_reduce_per_frame", sum_reduce,
+    frameSizes };
+}
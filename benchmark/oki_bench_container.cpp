@@ -0,0 +1,113 @@
+#include "oki/oki_handle.h"
+#include "oki/util/oki_container.h"
+
+#include "oki_bench.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+using Container = oki::intl_::AssocSortedVector<oki::Handle, std::uint64_t>;
+
+const std::vector<std::size_t> sizes { 1'000, 100'000, 1'000'000 };
+
+// Builds a container holding keys [1, n] with matching values
+Container make_filled(std::size_t n, std::size_t stride = 1)
+{
+    Container cont;
+    cont.reserve(n);
+
+    for (std::size_t i = 1; i <= n; ++i) {
+        cont.emplace(i * stride, i);
+    }
+
+    return cont;
+}
+
+void append_sorted(bench::State& state)
+{
+    state.measure([&] {
+        Container cont;
+        for (std::size_t i = 1; i <= state.items(); ++i) {
+            cont.emplace(i, i);
+        }
+
+        bench::do_not_optimize(cont.size());
+    });
+}
+
+void find_random(bench::State& state)
+{
+    auto cont = make_filled(state.items());
+
+    std::vector<oki::Handle> keys(state.items());
+    std::iota(keys.begin(), keys.end(), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64 { 42 });
+
+    state.measure([&] {
+        std::uint64_t sum = 0;
+        for (auto key : keys) {
+            sum += cont.find(key)->second;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void find_ascending(bench::State& state)
+{
+    auto cont = make_filled(state.items());
+
+    state.measure([&] {
+        std::uint64_t sum = 0;
+        for (std::size_t key = 1; key <= state.items(); ++key) {
+            sum += cont.find(key)->second;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void intersect_dense(bench::State& state)
+{
+    auto c1 = make_filled(state.items());
+    auto c2 = make_filled(state.items());
+
+    state.measure([&] {
+        std::uint64_t sum = 0;
+        oki::intl_::variadic_set_intersection(
+            [&](auto& p1, auto& p2) { sum += p1.second + p2.second; },
+            std::make_pair(c1.begin(), c1.end()),
+            std::make_pair(c2.begin(), c2.end()));
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+void intersect_sparse(bench::State& state)
+{
+    // Only every third key of the first container has a match
+    auto c1 = make_filled(state.items());
+    auto c2 = make_filled(state.items() / 3, 3);
+
+    state.measure([&] {
+        std::uint64_t sum = 0;
+        oki::intl_::variadic_set_intersection(
+            [&](auto& p1, auto& p2) { sum += p1.second + p2.second; },
+            std::make_pair(c1.begin(), c1.end()),
+            std::make_pair(c2.begin(), c2.end()));
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+bench::Register r1 { "AssocSortedVector/append_sorted", append_sorted, sizes };
+bench::Register r2 { "AssocSortedVector/find_random", find_random, sizes };
+bench::Register r3 { "AssocSortedVector/find_ascending", find_ascending,
+    sizes };
+bench::Register r4 { "intersection/dense", intersect_dense, sizes };
+bench::Register r5 { "intersection/sparse", intersect_sparse, sizes };
+}
@@ -0,0 +1,121 @@
+#include "oki/util/oki_flat_map.h"
+#include "oki/util/oki_type_erasure.h"
+
+#include "oki_bench.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+const std::vector<std::size_t> sizes { 1'000, 100'000, 1'000'000 };
+
+template <std::size_t N>
+struct DistinctType
+{ };
+
+// A registry's worth of distinct component types
+template <std::size_t... Ns>
+auto make_type_indices(std::index_sequence<Ns...>)
+{
+    return std::array<oki::intl_::TypeIndex, sizeof...(Ns)> {
+        oki::intl_::get_type<DistinctType<Ns>>()...
+    };
+}
+
+const auto typeIndices = make_type_indices(std::make_index_sequence<32>());
+
+std::vector<std::uint64_t> make_keys(std::size_t n)
+{
+    std::vector<std::uint64_t> keys(n);
+    std::mt19937_64 rng { 42 };
+    std::generate(keys.begin(), keys.end(), rng);
+
+    return keys;
+}
+
+// Looks up (one of 32) types state.items() times, like ComponentManager
+template <typename Map>
+void registry_lookup(bench::State& state)
+{
+    Map map;
+    for (std::size_t i = 0; i != typeIndices.size(); ++i) {
+        map.emplace(typeIndices[i], i);
+    }
+
+    std::vector<oki::intl_::TypeIndex> lookups;
+    std::mt19937 rng { 42 };
+    for (std::size_t i = 0; i != state.items(); ++i) {
+        lookups.push_back(typeIndices[rng() % typeIndices.size()]);
+    }
+
+    state.measure([&] {
+        std::size_t sum = 0;
+        for (auto type : lookups) {
+            sum += map.find(type)->second;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+template <typename Map>
+void random_lookup(bench::State& state)
+{
+    auto keys = make_keys(state.items());
+
+    Map map;
+    for (auto key : keys) {
+        map.emplace(key, key);
+    }
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64 { 7 });
+
+    state.measure([&] {
+        std::uint64_t sum = 0;
+        for (auto key : keys) {
+            sum += map.find(key)->second;
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+template <typename Map>
+void insert(bench::State& state)
+{
+    auto keys = make_keys(state.items());
+
+    state.measure([&] {
+        Map map;
+        for (auto key : keys) {
+            map.emplace(key, key);
+        }
+
+        bench::do_not_optimize(map.size());
+    });
+}
+
+using TypeFlatMap
+    = oki::intl_::FlatHashMap<oki::intl_::TypeIndex, std::size_t>;
+using TypeStdMap = std::unordered_map<oki::intl_::TypeIndex, std::size_t>;
+using IntFlatMap = oki::intl_::FlatHashMap<std::uint64_t, std::uint64_t>;
+using IntStdMap = std::unordered_map<std::uint64_t, std::uint64_t>;
+
+const std::vector<std::size_t> registrySizes { 1 << 16 };
+
+bench::Register r1 { "FlatHashMap/registry_lookup",
+    registry_lookup<TypeFlatMap>, registrySizes };
+bench::Register r2 { "unordered_map/registry_lookup",
+    registry_lookup<TypeStdMap>, registrySizes };
+bench::Register r3 { "FlatHashMap/random_lookup", random_lookup<IntFlatMap>,
+    sizes };
+bench::Register r4 { "unordered_map/random_lookup", random_lookup<IntStdMap>,
+    sizes };
+bench::Register r5 { "FlatHashMap/insert", insert<IntFlatMap>, sizes };
+bench::Register r6 { "unordered_map/insert", insert<IntStdMap>, sizes };
+}
@@ -0,0 +1,127 @@
+#include "oki_bench.h"
+#include "oki_perf_counters.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace {
+void print_header(bool withCounters)
+{
+    std::printf("%-40s %10s %12s %10s", "benchmark", "items", "ns/iter",
+        "ns/item");
+
+    if (withCounters) {
+        std::printf(" %10s %6s %10s %10s %10s", "cyc/item", "IPC", "L1d/item",
+            "LLC/item", "brm/item");
+    }
+
+    std::printf("\n");
+}
+
+// Prints a per-item counter, or a dash if the counter was unavailable
+void print_per_item(std::optional<std::uint64_t> value, double perItem)
+{
+    if (value) {
+        std::printf(" %10.3f", static_cast<double>(*value) * perItem);
+    } else {
+        std::printf(" %10s", "-");
+    }
+}
+
+void print_result(const bench::Result& result, bool withCounters)
+{
+    double nsPerItem = result.items ? result.nsPerIter / result.items : 0.;
+    std::printf("%-40s %10zu %12.1f %10.3f", result.name.c_str(), result.items,
+        result.nsPerIter, nsPerItem);
+
+    if (withCounters) {
+        // Counters cover every iteration, so normalize by both
+        double perItem = 1.
+            / (static_cast<double>(result.iterations)
+                * static_cast<double>(result.items ? result.items : 1));
+
+        const auto& counters = result.counters;
+        print_per_item(counters.get(bench::Counter::CYCLES), perItem);
+
+        if (auto ipc = counters.ipc()) {
+            std::printf(" %6.2f", *ipc);
+        } else {
+            std::printf(" %6s", "-");
+        }
+
+        print_per_item(counters.get(bench::Counter::L1D_MISSES), perItem);
+        print_per_item(counters.get(bench::Counter::LLC_MISSES), perItem);
+        print_per_item(counters.get(bench::Counter::BRANCH_MISSES), perItem);
+    }
+
+    std::printf("\n");
+}
+}
+
+/*
+ * Usage: oki_bench [--no-counters] [filter]
+ *
+ * Runs every registered benchmark whose name contains <filter>.
+ */
+int main(int argc, char** argv)
+{
+    bool useCounters = true;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--no-counters")) {
+            useCounters = false;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    std::unique_ptr<bench::PerfCounters> counters;
+    if (useCounters) {
+        counters = std::make_unique<bench::PerfCounters>();
+
+        if (!counters->available()) {
+            std::printf("Hardware counters unavailable (no permission, or "
+                        "running virtualized); reporting wall-clock only\n");
+            counters.reset();
+        } else {
+            for (std::size_t i = 0;
+                 i != static_cast<std::size_t>(bench::Counter::COUNT); ++i) {
+                auto counter = static_cast<bench::Counter>(i);
+                if (!counters->available(counter)) {
+                    std::printf("Counter %s unavailable\n",
+                        bench::counter_name(counter));
+                }
+            }
+        }
+    }
+
+    print_header(counters != nullptr);
+
+    for (const auto& benchmark : bench::registry()) {
+        if (benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        for (auto size : benchmark.sizes) {
+            bench::State state { size, counters.get() };
+            benchmark.func(state);
+
+            bench::Result result;
+            result.name = benchmark.name;
+            result.items = size;
+            result.iterations = state.iterations();
+            result.nsPerIter = state.iterations()
+                ? state.elapsed_ns() / state.iterations()
+                : 0.;
+            result.counters = state.sample();
+
+            print_result(result, counters != nullptr);
+        }
+    }
+
+    return 0;
+}
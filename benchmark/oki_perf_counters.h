@@ -0,0 +1,244 @@
+#ifndef OKI_PERF_COUNTERS_H
+#define OKI_PERF_COUNTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+/*
+ * The hardware events we try to sample around each benchmark.
+ * Kept as an enum (rather than a set of flags) because we always attempt
+ * to open all of them and simply report which ones we got.
+ */
+enum class Counter : std::size_t
+{
+    CYCLES = 0,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    COUNT
+};
+
+constexpr const char* counter_name(Counter counter) noexcept
+{
+    constexpr const char* names[] = { "cycles", "instructions", "L1d-misses",
+        "LLC-misses", "branch-misses" };
+
+    return names[static_cast<std::size_t>(counter)];
+}
+
+/*
+ * The result of one sampled region. Any counter that could not be opened
+ * (or could not be scheduled by the kernel) is left empty so that callers
+ * can tell "zero events" apart from "no idea".
+ */
+class CounterSample
+{
+public:
+    std::optional<std::uint64_t> get(Counter counter) const noexcept
+    {
+        return values_[static_cast<std::size_t>(counter)];
+    }
+
+    void set(Counter counter, std::uint64_t value) noexcept
+    {
+        values_[static_cast<std::size_t>(counter)] = value;
+    }
+
+    bool empty() const noexcept
+    {
+        for (const auto& value : values_) {
+            if (value) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Instructions per cycle, if both were measured
+    std::optional<double> ipc() const noexcept
+    {
+        auto cycles = this->get(Counter::CYCLES);
+        auto instrs = this->get(Counter::INSTRUCTIONS);
+
+        if (!cycles || !instrs || !*cycles) {
+            return std::nullopt;
+        }
+
+        return static_cast<double>(*instrs) / static_cast<double>(*cycles);
+    }
+
+private:
+    std::array<std::optional<std::uint64_t>,
+        static_cast<std::size_t>(Counter::COUNT)>
+        values_;
+};
+
+/*
+ * Thin wrapper around Linux's perf_event_open(), counting user-space events
+ * for the calling thread only.
+ *
+ * Every counter is opened independently so that a missing event (very
+ * common in VMs and containers, which tend to hide the cache events) does
+ * not take the others down with it. On other platforms, or when the kernel
+ * refuses us entirely, available() is false and every sample is empty; the
+ * benchmarks still run and report wall-clock numbers.
+ */
+class PerfCounters
+{
+public:
+    PerfCounters()
+    {
+#ifdef __linux__
+        for (std::size_t i = 0; i != fds_.size(); ++i) {
+            fds_[i] = open_counter_(static_cast<Counter>(i));
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    bool available() const noexcept
+    {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool available(Counter counter) const noexcept
+    {
+        return fds_[static_cast<std::size_t>(counter)] >= 0;
+    }
+
+    void start() noexcept
+    {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    CounterSample stop() noexcept
+    {
+        CounterSample sample;
+
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+
+        for (std::size_t i = 0; i != fds_.size(); ++i) {
+            if (fds_[i] < 0) {
+                continue;
+            }
+
+            // { value, time_enabled, time_running }
+            std::uint64_t data[3] = {};
+            if (read(fds_[i], data, sizeof(data)) != sizeof(data)
+                || !data[2]) {
+                // The kernel never scheduled the counter, so we know nothing
+                continue;
+            }
+
+            // Scale up if the PMU was multiplexed between counters
+            double scale = static_cast<double>(data[1])
+                / static_cast<double>(data[2]);
+            auto value = static_cast<double>(data[0]) * scale;
+            sample.set(
+                static_cast<Counter>(i), static_cast<std::uint64_t>(value));
+        }
+#endif
+
+        return sample;
+    }
+
+private:
+    std::array<int, static_cast<std::size_t>(Counter::COUNT)> fds_ {
+        -1, -1, -1, -1, -1
+    };
+
+#ifdef __linux__
+    static int open_counter_(Counter counter) noexcept
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format
+            = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        auto cache_miss = [](std::uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+
+        switch (counter) {
+        case Counter::CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case Counter::INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case Counter::L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case Counter::LLC_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+            break;
+        case Counter::BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            return -1;
+        }
+
+        // Measure this thread on any CPU, without grouping
+        long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        return static_cast<int>(fd);
+    }
+#endif
+};
+}
+
+#endif // OKI_PERF_COUNTERS_H
@@ -124,7 +124,7 @@ public:
     }
 
 private:
-    void step(oki::Engine& engine, oki::SystemOptions&) override
+    void step(oki::Engine& engine, oki::SystemOptions& opts) override
     {
         auto now = std::chrono::steady_clock::now();
         if (pipeSpawn_.count() > 2.f) {
@@ -133,19 +133,16 @@ private:
 
         // Here is one limitation of the library: cleanup
         // We cannot remove components while iterating over them...
-        std::vector<oki::Entity> toDelete;
+        // (the list only lasts this step, so it can live in scratch memory)
+        oki::ScratchVector<oki::Entity> toDelete(opts.scratch());
         engine.for_each<PipeTag, Rect>([&](auto entity, auto, auto rect) {
             if (rect.x2 < -1.1f) {
                 toDelete.push_back(entity);
             }
         });
 
-        // ...and destroying an entity will leak its components
+        // ...so we destroy the entities (and their components) afterwards
         for (auto entity : toDelete) {
-            engine.remove_component<Rect>(entity);
-            engine.remove_component<PhysicsVec>(entity);
-            engine.remove_component<Color>(entity);
-            engine.remove_component<PipeTag>(entity);
             engine.destroy_entity(entity);
         }
     }
@@ -206,14 +203,13 @@ private:
             phys.velY = 0.5f;
         }
 
-        engine.for_each<PipeTag, Rect>(
-            [&rect, &engine](auto, auto, auto pipeRect) {
-                if (pipeRect.overlaps(rect)) {
-                    engine.send(GameOverEvent { engine });
-                }
+        // One collision is enough, so there is no need to check every pipe
+        bool collided = engine.any<PipeTag, Rect>(
+            [&rect](auto, auto, auto pipeRect) {
+                return pipeRect.overlaps(rect);
             });
 
-        if (!screenBox_.contains(rect)) {
+        if (collided || !screenBox_.contains(rect)) {
             engine.send(GameOverEvent { engine });
         }
     }
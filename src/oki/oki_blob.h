@@ -0,0 +1,196 @@
+#ifndef OKI_BLOB_H
+#define OKI_BLOB_H
+
+#include "oki/util/oki_blob_arena.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace oki {
+/*
+ * A variable-length component: a run of Elements, like a std::vector, but
+ * stored in one array per Blob type (an arena) rather than in its own heap
+ * allocation. Iterating over blobs then reads that array instead of
+ * chasing a pointer per entity:
+ *
+ *     struct NameTag;
+ *     using Name = oki::Blob<char, NameTag>;
+ *
+ *     compMan.bind_component(entity, Name(text.begin(), text.end()));
+ *
+ * The Tag distinguishes component types with the same Element. A Blob
+ * itself is only used to bind (or copy out) a component; bound ones are
+ * handed out as BlobRef<Blob> instead of Blob&, and as
+ * std::optional<BlobRef<Blob>> instead of Blob*.
+ *
+ * Blobs can grow in place (see BlobRef), and when growing and removing
+ * them has left the arena mostly holes, it is compacted so that the blobs
+ * are in iteration order again (see ComponentManager::defragment()).
+ */
+template <typename Element, typename Tag = void>
+class Blob
+{
+public:
+    using value_type = Element;
+
+    Blob() = default;
+
+    Blob(std::initializer_list<Element> elements)
+        : elements_(elements)
+    {
+    }
+
+    Blob(std::size_t count, const Element& value)
+        : elements_(count, value)
+    {
+    }
+
+    template <typename InputIt,
+        typename = typename std::iterator_traits<InputIt>::iterator_category>
+    Blob(InputIt first, InputIt last)
+        : elements_(first, last)
+    {
+    }
+
+    explicit Blob(std::vector<Element> elements) noexcept
+        : elements_(std::move(elements))
+    {
+    }
+
+    const Element* data() const noexcept { return elements_.data(); }
+    std::size_t size() const noexcept { return elements_.size(); }
+    bool empty() const noexcept { return elements_.empty(); }
+
+    auto begin() const noexcept { return elements_.begin(); }
+    auto end() const noexcept { return elements_.end(); }
+
+    const Element& operator[](std::size_t idx) const noexcept
+    {
+        return elements_[idx];
+    }
+
+    const std::vector<Element>& elements() const noexcept
+    {
+        return elements_;
+    }
+
+private:
+    std::vector<Element> elements_;
+};
+
+/*
+ * A reference to a bound blob component, which works much like a span:
+ *   - data(), size(), begin(), end() and [] give access to the elements
+ *   - resize(), push_back(), append() and clear() change the size in place
+ *       (for BlobRef<const Blob>, they do not compile)
+ *   - It converts to a (copy of the) whole Blob, and assigning a Blob to it
+ *       replaces the contents
+ *
+ * Changing the size of any blob of the type may move the arena, so
+ * pointers (and iterators) into blobs do not survive it. The BlobRefs
+ * themselves do, as they look the blob up each time.
+ */
+template <typename BlobType>
+class BlobRef
+{
+    static constexpr bool CONST = std::is_const_v<BlobType>;
+
+    using Element = typename std::remove_const_t<BlobType>::value_type;
+    using Value = std::conditional_t<CONST, const Element, Element>;
+
+    using Arena = oki::intl_::BlobArena<Element>;
+    using Extent = typename Arena::Extent;
+
+public:
+    BlobRef(std::conditional_t<CONST, const Arena, Arena>& arena,
+        std::conditional_t<CONST, const Extent, Extent>& extent) noexcept
+        : arena_(&arena)
+        , extent_(&extent)
+    {
+    }
+
+    // Allow BlobRef<Blob> -> BlobRef<const Blob> conversion
+    template <typename ThatType,
+        std::enable_if_t<CONST && std::is_same_v<const ThatType, BlobType>,
+            int> = 0>
+    BlobRef(const BlobRef<ThatType>& that) noexcept
+        : arena_(that.arena_)
+        , extent_(that.extent_)
+    {
+    }
+
+    Value* data() const noexcept { return arena_->data() + extent_->offset; }
+    std::size_t size() const noexcept { return extent_->size; }
+    bool empty() const noexcept { return !extent_->size; }
+
+    // The size the blob can grow to without moving
+    std::size_t capacity() const noexcept { return extent_->capacity; }
+
+    Value* begin() const noexcept { return this->data(); }
+    Value* end() const noexcept { return this->data() + this->size(); }
+
+    Value& operator[](std::size_t idx) const noexcept
+    {
+        return this->data()[idx];
+    }
+
+    void resize(std::size_t n) const
+    {
+        static_assert(!CONST, "Cannot resize a const blob");
+        arena_->resize(*extent_, n);
+    }
+
+    void push_back(Element value) const
+    {
+        this->resize(this->size() + 1);
+        this->data()[this->size() - 1] = std::move(value);
+    }
+
+    // [first, last) must not point into a blob of the same type
+    template <typename InputIt>
+    void append(InputIt first, InputIt last) const
+    {
+        for (; first != last; ++first) {
+            this->push_back(*first);
+        }
+    }
+
+    void clear() const { this->resize(0); }
+
+    operator std::remove_const_t<BlobType>() const
+    {
+        return std::remove_const_t<BlobType>(this->begin(), this->end());
+    }
+
+    const BlobRef& operator=(const std::remove_const_t<BlobType>& value) const
+    {
+        static_assert(!CONST, "Cannot assign to a const blob");
+        arena_->assign(*extent_, value.begin(), value.end());
+
+        return *this;
+    }
+
+private:
+    std::conditional_t<CONST, const Arena, Arena>* arena_;
+    std::conditional_t<CONST, const Extent, Extent>* extent_;
+
+    template <typename ThatType>
+    friend class BlobRef;
+};
+
+namespace intl_ {
+template <typename Type>
+struct IsBlob : std::false_type
+{ };
+
+template <typename Element, typename Tag>
+struct IsBlob<oki::Blob<Element, Tag>> : std::true_type
+{ };
+}
+}
+
+#endif // OKI_BLOB_H
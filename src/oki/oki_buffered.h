@@ -0,0 +1,39 @@
+#ifndef OKI_BUFFERED_H
+#define OKI_BUFFERED_H
+
+#include <type_traits>
+
+namespace oki {
+/*
+ * Opts a component type into being published to another thread (e.g. a
+ * renderer) through a ComponentManager::TripleBuffer:
+ *
+ *     struct Rect { float x, y, w, h; };
+ *
+ *     namespace oki {
+ *     template <>
+ *     struct StoreBuffered<Rect> : std::true_type { };
+ *     }
+ *
+ * The container of such a type remembers which entities' components were
+ * handed out by reference (or added, replaced or removed) since the last
+ * publish, so that a publish copies only those into the buffer's spare
+ * copy before swapping it in. It cannot tell reads from writes, so every
+ * component visited by for_each() (and the like) counts as changed; only
+ * those visited do, though, so iterating over an intersection with a
+ * rarer type counts just the matches.
+ *
+ * A reference counts as a change when it is handed out, so none should be
+ * kept across a publish_components(). Whole-container access that may run
+ * on several threads (reduce(), view iterators) counts every component as
+ * changed, as does erase_components().
+ *
+ * Buffered components cannot also be split, stored as columns, stored
+ * shared, indexed or blobs.
+ */
+template <typename Type>
+struct StoreBuffered : std::false_type
+{ };
+}
+
+#endif // OKI_BUFFERED_H
@@ -0,0 +1,133 @@
+#ifndef OKI_COLUMNS_H
+#define OKI_COLUMNS_H
+
+#include "oki/util/oki_reflect.h"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace oki {
+/*
+ * Opts an aggregate component type into being stored field by field
+ * ("structure of arrays"), one column per field, instead of as an array of
+ * whole components:
+ *
+ *     struct PhysicsVec { float velX, velY, accX, accY; };
+ *
+ *     namespace oki {
+ *     template <>
+ *     struct StoreAsColumns<PhysicsVec> : std::true_type { };
+ *     }
+ *
+ * The fields are found by reflection (see oki_reflect.h), so they must be
+ * public and not aggregates themselves (e.g. scalars). A loop that only
+ * reads velX and velY then only reads those columns, and each column can
+ * be handed to a SIMD kernel as a ColumnSpan.
+ *
+ * Components of such a type are handed out as ColumnRef<Type> instead of
+ * Type&, and as std::optional<ColumnRef<Type>> instead of Type*.
+ */
+template <typename Type>
+struct StoreAsColumns : std::false_type
+{ };
+
+/*
+ * A reference to a component that is stored as columns, made of a
+ * reference to each of its fields:
+ *   - get<I>() returns a reference to field I (in declaration order)
+ *   - It converts to a (copy of the) whole Type, and assigning a Type to it
+ *       assigns every field
+ *   - It supports structured bindings, which bind references:
+ *
+ *       auto [velX, velY, accX, accY] = ref;
+ *       velX += accX;
+ */
+template <typename Type>
+class ColumnRef
+{
+public:
+    using Fields = oki::intl_::FieldRefs<Type>;
+
+    explicit ColumnRef(Fields fields) noexcept
+        : fields_(fields)
+    {
+    }
+
+    template <std::size_t I>
+    auto& get() const noexcept
+    {
+        return std::get<I>(fields_);
+    }
+
+    operator std::remove_const_t<Type>() const
+    {
+        return std::apply(
+            [](const auto&... fields) {
+                return std::remove_const_t<Type> { fields... };
+            },
+            fields_);
+    }
+
+    const ColumnRef& operator=(const std::remove_const_t<Type>& value) const
+    {
+        this->assign_(oki::intl_::tie_fields(value),
+            std::make_index_sequence<std::tuple_size_v<Fields>>());
+
+        return *this;
+    }
+
+private:
+    Fields fields_;
+
+    template <typename Values, std::size_t... Is>
+    void assign_(const Values& values, std::index_sequence<Is...>) const
+    {
+        ((std::get<Is>(fields_) = std::get<Is>(values)), ...);
+    }
+};
+
+/*
+ * A contiguous run of one field of a column-stored component, e.g. every
+ * PhysicsVec::velX, in iteration order.
+ */
+template <typename Type>
+class ColumnSpan
+{
+public:
+    ColumnSpan(Type* data, std::size_t size) noexcept
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    Type* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return !size_; }
+
+    Type* begin() const noexcept { return data_; }
+    Type* end() const noexcept { return data_ + size_; }
+
+    Type& operator[](std::size_t idx) const noexcept { return data_[idx]; }
+
+private:
+    Type* data_;
+    std::size_t size_;
+};
+}
+
+// Lets structured bindings take a ColumnRef apart
+namespace std {
+template <typename Type>
+struct tuple_size<oki::ColumnRef<Type>>
+    : tuple_size<typename oki::ColumnRef<Type>::Fields>
+{ };
+
+template <std::size_t I, typename Type>
+struct tuple_element<I, oki::ColumnRef<Type>>
+    : tuple_element<I, typename oki::ColumnRef<Type>::Fields>
+{ };
+}
+
+#endif // OKI_COLUMNS_H
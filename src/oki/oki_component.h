@@ -1,16 +1,34 @@
 #ifndef OKI_COMPONENT_H
 #define OKI_COMPONENT_H
 
+#include "oki/oki_config.h"
 #include "oki/oki_handle.h"
+#include "oki/oki_split.h"
+#include "oki/util/oki_blob_vector.h"
+#include "oki/util/oki_buffered_vector.h"
+#include "oki/util/oki_column_vector.h"
 #include "oki/util/oki_container.h"
+#include "oki/util/oki_flat_map.h"
 #include "oki/util/oki_handle_gen.h"
+#include "oki/util/oki_hierarchy.h"
+#include "oki/util/oki_indexed_vector.h"
+#include "oki/util/oki_parallel.h"
+#include "oki/util/oki_shared_vector.h"
 #include "oki/util/oki_type_erasure.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <tuple>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace oki {
 /*
@@ -26,6 +44,174 @@ public:
 private:
     HandleType handle_ = oki::intl_::get_invalid_handle_constant();
 
+    friend class ComponentManager;
+    friend class EntityRange;
+    friend class ShardedComponentManager;
+};
+
+/*
+ * A run of entities with consecutive handles, as created in bulk by
+ * ComponentManager::create_entities() and spawn(). Only stores the first
+ * handle and the count, and yields the entities by value.
+ */
+class EntityRange
+{
+    using HandleType = oki::Entity::HandleType;
+
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = oki::Entity;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = oki::Entity;
+
+        iterator() = default;
+
+        oki::Entity operator*() const noexcept
+        {
+            oki::Entity entity;
+            entity.handle_ = handle_;
+
+            return entity;
+        }
+
+        oki::Entity operator[](difference_type n) const noexcept
+        {
+            return *(*this + n);
+        }
+
+        iterator& operator++() noexcept
+        {
+            oki::intl_::advance(handle_);
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        iterator& operator--() noexcept
+        {
+            --handle_;
+            return *this;
+        }
+
+        iterator operator--(int) noexcept
+        {
+            auto old = *this;
+            --*this;
+            return old;
+        }
+
+        iterator& operator+=(difference_type n) noexcept
+        {
+            handle_ = static_cast<HandleType>(handle_ + n);
+            return *this;
+        }
+
+        iterator& operator-=(difference_type n) noexcept
+        {
+            return *this += -n;
+        }
+
+        friend iterator operator+(iterator iter, difference_type n) noexcept
+        {
+            return iter += n;
+        }
+
+        friend iterator operator+(difference_type n, iterator iter) noexcept
+        {
+            return iter += n;
+        }
+
+        friend iterator operator-(iterator iter, difference_type n) noexcept
+        {
+            return iter -= n;
+        }
+
+        friend difference_type operator-(
+            const iterator& lhs, const iterator& rhs) noexcept
+        {
+            return static_cast<difference_type>(lhs.handle_)
+                - static_cast<difference_type>(rhs.handle_);
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.handle_ == rhs.handle_;
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.handle_ != rhs.handle_;
+        }
+
+        friend bool operator<(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.handle_ < rhs.handle_;
+        }
+
+        friend bool operator>(const iterator& lhs, const iterator& rhs)
+        {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const iterator& lhs, const iterator& rhs)
+        {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const iterator& lhs, const iterator& rhs)
+        {
+            return !(lhs < rhs);
+        }
+
+    private:
+        HandleType handle_ = oki::intl_::get_invalid_handle_constant();
+
+        explicit iterator(HandleType handle) noexcept
+            : handle_(handle)
+        {
+        }
+
+        friend class EntityRange;
+    };
+
+    using const_iterator = iterator;
+
+    EntityRange() = default;
+
+    iterator begin() const noexcept { return iterator(first_); }
+
+    iterator end() const noexcept
+    {
+        return iterator(static_cast<HandleType>(first_ + size_));
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return !size_; }
+
+    oki::Entity operator[](std::size_t idx) const noexcept
+    {
+        return this->begin()[static_cast<std::ptrdiff_t>(idx)];
+    }
+
+private:
+    HandleType first_ = oki::intl_::get_invalid_handle_constant();
+    std::size_t size_ = 0;
+
+    EntityRange(HandleType first, std::size_t size) noexcept
+        : first_(first)
+        , size_(size)
+    {
+    }
+
     friend class ComponentManager;
 };
 
@@ -41,10 +227,123 @@ class ComponentManager
     using HandleType = oki::Entity::HandleType;
 
     template <typename Type>
-    using Container
-        = oki::intl_::AssocSortedVector<HandleType, std::decay_t<Type>>;
+    using Traits = oki::intl_::ComponentTraits<std::decay_t<Type>>;
+
+    // What is actually stored for a component type (which differs for the
+    // columns of split components, see oki_split.h)
+    template <typename Type>
+    using Stored = typename Traits<Type>::Stored;
+
+    // What we hand out when asked for a component (or a pointer to one)
+    template <typename Type>
+    using ComponentRef = typename Traits<Type>::Ref;
+
+    template <typename Type>
+    using ComponentPtr = typename Traits<Type>::Ptr;
 
-    using ErasedContainer = oki::intl_::OptimalErasedType<Container<long>>;
+    template <typename Type>
+    static constexpr bool IS_SPLIT_
+        = oki::intl_::IsSplit<std::decay_t<Type>>::value;
+
+    template <typename Type>
+    static constexpr bool IS_COLUMNS_
+        = oki::StoreAsColumns<Stored<Type>>::value;
+
+    template <typename Type>
+    static constexpr bool IS_SHARED_ = oki::StoreShared<Stored<Type>>::value;
+
+    template <typename Type>
+    static constexpr bool IS_BLOB_ = oki::intl_::IsBlob<Stored<Type>>::value;
+
+    template <typename Type>
+    static constexpr bool IS_INDEXED_
+        = oki::intl_::IsIndexed<Stored<Type>>::value;
+
+    template <typename Type>
+    static constexpr bool IS_BUFFERED_
+        = oki::StoreBuffered<Stored<Type>>::value;
+
+    // Whether no two of Types are the same component type
+    template <typename Type, typename... Rest>
+    static constexpr bool are_distinct_() noexcept
+    {
+        if constexpr (sizeof...(Rest) == 0) {
+            return true;
+        } else {
+            return (!std::is_same_v<std::decay_t<Type>, std::decay_t<Rest>>
+                       && ...)
+                && are_distinct_<Rest...>();
+        }
+    }
+
+    // Column-stored components (see oki_columns.h) get a container with a
+    // separate array per field, shared ones (see oki_shared.h) one that
+    // stores each distinct value once, blobs (see oki_blob.h) one that
+    // keeps their elements in an arena, indexed ones (see oki_index.h)
+    // one that keeps their indexes up to date and buffered ones (see
+    // oki_buffered.h) one that logs which values may have changed
+    template <typename Type>
+    using Container = std::conditional_t<IS_COLUMNS_<Type>,
+        oki::intl_::ColumnSortedVector<HandleType, Stored<Type>>,
+        std::conditional_t<IS_SHARED_<Type>,
+            oki::intl_::SharedSortedVector<HandleType, Stored<Type>>,
+            std::conditional_t<IS_BLOB_<Type>,
+                oki::intl_::BlobSortedVector<HandleType, Stored<Type>>,
+                std::conditional_t<IS_INDEXED_<Type>,
+                    oki::intl_::IndexedSortedVector<HandleType, Stored<Type>>,
+                    std::conditional_t<IS_BUFFERED_<Type>,
+                        oki::intl_::BufferedSortedVector<HandleType,
+                            Stored<Type>>,
+                        oki::intl_::AssocSortedVector<HandleType,
+                            Stored<Type>>>>>>>;
+
+    // What we need to do to every container without knowing its type
+    struct ContainerOps
+    {
+        std::size_t (*size)(const void*);
+        bool (*contains)(const void*, HandleType);
+        bool (*erase)(void*, HandleType);
+        void (*clear)(void*);
+        void (*reserve)(void*, std::size_t);
+        std::size_t (*memory_usage)(const void*);
+        void (*shrink_to_fit)(void*);
+        // Takes sorted handles without repeats
+        std::size_t (*erase_sorted)(
+            void*, const HandleType*, const HandleType*);
+
+        template <typename Cont>
+        static constexpr ContainerOps create() noexcept
+        {
+            using oki::intl_::erased_cast;
+
+            return {
+                [](const void* cont) {
+                    return erased_cast<Cont>(cont)->size();
+                },
+                [](const void* cont, HandleType handle) {
+                    return erased_cast<Cont>(cont)->contains(handle);
+                },
+                [](void* cont, HandleType handle) {
+                    return erased_cast<Cont>(cont)->erase(handle);
+                },
+                [](void* cont) { erased_cast<Cont>(cont)->clear(); },
+                [](void* cont, std::size_t n) {
+                    erased_cast<Cont>(cont)->reserve(n);
+                },
+                [](const void* cont) {
+                    return erased_cast<Cont>(cont)->memory_usage();
+                },
+                [](void* cont) { erased_cast<Cont>(cont)->shrink_to_fit(); },
+                [](void* cont, const HandleType* first,
+                    const HandleType* last) {
+                    return erased_cast<Cont>(cont)->erase_sorted(first, last);
+                },
+            };
+        }
+    };
+
+    using ErasedContainer
+        = oki::intl_::OptimalErasedType<Container<long>, ContainerOps>;
 
 public:
     /*
@@ -53,28 +352,100 @@ public:
      *
      * This is how composition is achieved: doing so tells the
      * ComponentManager how different components relate to each other.
+     *
+     * With OKI_CONCURRENT_HANDLES (see oki_config.h), this (like
+     * create_entities()) can be called from several threads at once, each
+     * of which takes handles from (and destroys them into) its own cache.
      */
     oki::Entity create_entity()
     {
         oki::Entity entity;
-        entity.handle_ = handGen_.create_handle();
+        entity.handle_ = this->handle_source_().create_handle();
 
         return entity;
     }
 
     /*
-     * Deletes the entity handle (potentially allowing reuse) but DOES NOT
-     * erase the entities that were associated with this entity.
+     * Creates <n> entities at once, whose handles are consecutive (so
+     * never reuse destroyed ones).
+     */
+    oki::EntityRange create_entities(std::size_t n)
+    {
+        return oki::EntityRange(handGen_.create_handles(n), n);
+    }
+
+    /*
+     * Creates <n> entities, each with a component of every type in Types,
+     * and returns them. For each i in [0, n), init(i) must return the
+     * components of the i-th entity as something std::apply() accepts
+     * (e.g. std::tuple<Types...> or std::pair).
+     *
+     * This is much cheaper than the equivalent loop of create_entity() and
+     * bind_component(): each container is grown once, and since the new
+     * handles are consecutive the components are appended in order. Only
+     * if handles were issued out of order (e.g. when they are reused) is
+     * there a merge per container at the end.
+     */
+    template <typename... Types, typename Initializer>
+    oki::EntityRange spawn(std::size_t n, Initializer init)
+    {
+        static_assert(sizeof...(Types) > 0, "Must spawn at least one type");
+        static_assert(are_distinct_<Types...>(),
+            "An entity can only have one component of each type");
+
+        return this->spawn_into_(
+            std::tie(this->get_or_create_cont_<Types>()...), n, init);
+    }
+
+    /*
+     * Destroys every entity in [first, last) along with its components.
+     * Rather than look up each entity in each container, this sorts the
+     * handles and sweeps every container once.
+     *
+     * Returns how many entities were successfully deleted (see
+     * destroy_entity()).
+     */
+    template <typename InputIt>
+    std::size_t destroy_entities(InputIt first, InputIt last)
+    {
+        std::vector<HandleType> handles;
+        for (; first != last; ++first) {
+            oki::Entity entity = *first;
+            handles.push_back(entity.handle_);
+        }
+
+        return this->destroy_handles_(handles);
+    }
+
+    /*
+     * Erases every component bound to the entity, then deletes the entity
+     * handle (potentially allowing reuse).
      *
-     * (The ability to do so comes with significant cost due to the type
-     * erasure and may be added in the future, but not now.)
+     * This visits each component type once, so costs a lookup per type
+     * that has ever been used, regardless of how many the entity has.
      *
      * Returns whether the deletion was successful (which is a no-op
      * by default).
      */
     bool destroy_entity(oki::Entity entity)
     {
-        return handGen_.destroy_handle(entity.handle_);
+        if constexpr (oki::intl_::CHECKED) {
+            for (const auto& container : containers_) {
+                if (container.invoke(&ContainerOps::contains, entity.handle_)) {
+                    this->check_not_iterating_(container.address());
+                }
+            }
+        }
+
+        for (auto& container : containers_) {
+            container.invoke(&ContainerOps::erase, entity.handle_);
+        }
+
+        if (!hierarchy_.empty()) {
+            hierarchy_.erase(entity.handle_);
+        }
+
+        return this->handle_source_().destroy_handle(entity.handle_);
     }
 
     /*
@@ -86,14 +457,32 @@ public:
      * supplied arguments to the constructor of Type.
      */
     template <typename Type, typename... Args>
-    std::pair<Type&, bool> emplace_component(oki::Entity entity, Args&&... args)
+    std::pair<ComponentRef<Type>, bool> emplace_component(
+        oki::Entity entity, Args&&... args)
     {
-        auto& cont = this->get_or_create_cont_<Type>();
+        if constexpr (IS_SPLIT_<Type>) {
+            if (this->has_component<Type>(entity)) {
+                return { this->get_component<Type>(entity), false };
+            }
+
+            Type value { std::forward<Args>(args)... };
+            auto hot = this->emplace_component<oki::Hot<Type>>(
+                entity, std::move(value.hot));
+            auto cold = this->emplace_component<oki::Cold<Type>>(
+                entity, std::move(value.cold));
 
-        auto [valIter, success]
-            = cont.emplace(entity.handle_, std::forward<Args>(args)...);
+            return { { hot.first, cold.first }, true };
+        } else {
+            this->check_entity_(entity);
 
-        return { valIter->second, success };
+            auto& cont = this->get_or_create_cont_<Type>();
+            this->check_can_insert_(cont, entity.handle_);
+
+            auto [valIter, success]
+                = cont.emplace(entity.handle_, std::forward<Args>(args)...);
+
+            return { (*valIter).second, success };
+        }
     }
 
     /*
@@ -124,12 +513,20 @@ public:
     auto bind_or_assign_component(oki::Entity entity, InsertType&& value)
     {
         using Type = std::decay_t<InsertType>;
-        auto& cont = this->get_or_create_cont_<Type>();
 
-        auto [valIter, success] = cont.insert_or_assign(
-            entity.handle_, std::forward<InsertType>(value));
-
-        return std::pair<Type&, bool> { valIter->second, success };
+        if constexpr (IS_SPLIT_<Type>) {
+            auto hot = this->insert_or_assign_<oki::Hot<Type>>(
+                entity, std::forward<InsertType>(value).hot);
+            auto cold = this->insert_or_assign_<oki::Cold<Type>>(
+                entity, std::forward<InsertType>(value).cold);
+
+            return std::pair<ComponentRef<Type>, bool> {
+                { hot.first, cold.first }, hot.second
+            };
+        } else {
+            return this->insert_or_assign_<Type>(
+                entity, std::forward<InsertType>(value));
+        }
     }
 
     /*
@@ -139,18 +536,37 @@ public:
      *
      * OKI does not support adding multiple components of the same
      * type to one entity and its behavior is not formally supported in
-     * this state.
+     * this state (checked builds throw instead).
      *
      * Forwards the supplied arguments to the constructor of Type.
      */
     template <typename Type, typename... Args>
-    Type& emplace_component_unchecked(oki::Entity entity, Args&&... args)
+    ComponentRef<Type> emplace_component_unchecked(
+        oki::Entity entity, Args&&... args)
     {
-        auto& cont = this->get_or_create_cont_<Type>();
-        auto iter = cont.emplace_unchecked(
-            entity.handle_, std::forward<Args>(args)...);
+        if constexpr (IS_SPLIT_<Type>) {
+            Type value { std::forward<Args>(args)... };
+            auto& hot = this->emplace_component_unchecked<oki::Hot<Type>>(
+                entity, std::move(value.hot));
+            auto& cold = this->emplace_component_unchecked<oki::Cold<Type>>(
+                entity, std::move(value.cold));
+
+            return { hot, cold };
+        } else {
+            this->check_entity_(entity);
+
+            auto& cont = this->get_or_create_cont_<Type>();
+            if constexpr (oki::intl_::CHECKED) {
+                oki::intl_::check(!cont.contains(entity.handle_),
+                    "Entity already has a component of this type");
+                this->check_not_iterating_(&cont);
+            }
+
+            auto iter = cont.emplace_unchecked(
+                entity.handle_, std::forward<Args>(args)...);
 
-        return iter->second;
+            return (*iter).second;
+        }
     }
 
     /*
@@ -164,7 +580,8 @@ public:
      * Deduces the type and forwards the incoming value to the constructor.
      */
     template <typename InsertType>
-    auto& bind_component_unchecked(oki::Entity entity, InsertType&& value)
+    decltype(auto) bind_component_unchecked(
+        oki::Entity entity, InsertType&& value)
     {
         return this->emplace_component_unchecked<std::decay_t<InsertType>>(
             entity, std::forward<InsertType>(value));
@@ -178,9 +595,24 @@ public:
     template <typename Type>
     bool remove_component(oki::Entity entity)
     {
-        return this->call_on_cont_checked_<Type, bool>(
-            [=](auto& container) { return container.erase(entity.handle_); },
-            false);
+        if constexpr (IS_SPLIT_<Type>) {
+            bool removed = this->remove_component<oki::Hot<Type>>(entity);
+            this->remove_component<oki::Cold<Type>>(entity);
+
+            return removed;
+        } else {
+            return this->call_on_cont_checked_<Type, bool>(
+                [=](auto& container) {
+                    if constexpr (oki::intl_::CHECKED) {
+                        if (container.contains(entity.handle_)) {
+                            this->check_not_iterating_(&container);
+                        }
+                    }
+
+                    return container.erase(entity.handle_);
+                },
+                false);
+        }
     }
 
     /*
@@ -189,30 +621,62 @@ public:
     template <typename Type>
     void erase_components()
     {
-        this->call_on_cont_checked_<Type>(
-            [](auto& container) { container.clear(); });
+        if constexpr (IS_SPLIT_<Type>) {
+            this->erase_components<oki::Hot<Type>>();
+            this->erase_components<oki::Cold<Type>>();
+        } else {
+            this->call_on_cont_checked_<Type>([this](auto& container) {
+                this->check_not_iterating_(&container);
+                container.clear();
+            });
+        }
     }
 
     /*
      * Erases all components.
      *
-     * Invalidates any views received from get_component_view().
+     * The (now empty) containers are kept, along with their memory, so
+     * views received from get_component_view() remain valid.
      */
-    void erase_components() { data_.clear(); }
+    void erase_components()
+    {
+        for (auto& container : containers_) {
+            this->check_not_iterating_(container.address());
+            container.invoke(&ContainerOps::clear);
+        }
+    }
 
     /*
      * Retrieves a reference to component of type Type from the provided
-     * entity, assuming (without checking) that this entity has a component
-     * of that type.
+     * entity, assuming (without checking, in unchecked builds) that this
+     * entity has a component of that type.
      *
      * Components are owned by the ComponentManager and this reference is
      * valid only until a new component of this type is added (very likely
      * longer but OKI does not formally support this).
      */
     template <typename Type>
-    Type& get_component(oki::Entity entity)
+    ComponentRef<Type> get_component(oki::Entity entity)
     {
-        return this->get_cont_<Type>().find(entity.handle_)->second;
+        if constexpr (IS_SPLIT_<Type>) {
+            return { this->get_component<oki::Hot<Type>>(entity),
+                this->get_component<oki::Cold<Type>>(entity) };
+        } else {
+            this->check_entity_(entity);
+
+            // Presence is assumed, so there is no need to compare the key we
+            // land on (unless we are checking)
+            auto& cont = this->get_cont_<Type>();
+            auto iter = cont.lower_bound(entity.handle_);
+
+            if constexpr (oki::intl_::CHECKED) {
+                oki::intl_::check(
+                    iter != cont.end() && iter->first == entity.handle_,
+                    "Entity does not have a component of this type");
+            }
+
+            return (*iter).second;
+        }
     }
 
     /*
@@ -224,17 +688,17 @@ public:
      * longer but OKI does not formally support this).
      */
     template <typename Type>
-    Type* get_component_checked(oki::Entity entity)
+    ComponentPtr<Type> get_component_checked(oki::Entity entity)
     {
-        return this->call_on_cont_checked_<Type, Type*>(
+        return this->call_on_cont_checked_<Type, ComponentPtr<Type>>(
             [=](auto& container) {
                 auto compIter = container.find(entity.handle_);
 
                 return (compIter != container.end())
-                    ? std::addressof(compIter->second)
-                    : nullptr;
+                    ? address_of_<Type>((*compIter).second)
+                    : ComponentPtr<Type> {};
             },
-            nullptr);
+            ComponentPtr<Type> {});
     }
 
     /*
@@ -242,9 +706,9 @@ public:
      * (Looks good with structured bindings!)
      */
     template <typename... Types>
-    std::tuple<Types&...> get_components(oki::Entity entity)
+    std::tuple<ComponentRef<Types>...> get_components(oki::Entity entity)
     {
-        return std::tie(this->get_component<Types>(entity)...);
+        return { this->get_component<Types>(entity)... };
     }
 
     /*
@@ -252,7 +716,8 @@ public:
      * an entity.
      */
     template <typename... Types>
-    std::tuple<Types*...> get_components_checked(oki::Entity entity)
+    std::tuple<ComponentPtr<Types>...> get_components_checked(
+        oki::Entity entity)
     {
         return { this->get_component_checked<Types>(entity)... };
     }
@@ -264,9 +729,15 @@ public:
     template <typename Type>
     bool has_component(oki::Entity entity) const noexcept
     {
-        return this->call_on_cont_checked_<Type, bool>(
-            [=](auto& container) { return container.contains(entity.handle_); },
-            false);
+        if constexpr (IS_SPLIT_<Type>) {
+            return this->has_component<oki::Hot<Type>>(entity);
+        } else {
+            return this->call_on_cont_checked_<Type, bool>(
+                [=](auto& container) {
+                    return container.contains(entity.handle_);
+                },
+                false);
+        }
     }
 
     /*
@@ -278,6 +749,9 @@ public:
      *   - An oki::Entity representing the components' owner
      *   - A reference to each of the bound components whose types
      *      are specified in Types..., in the order provided
+     *
+     * If func() returns a bool, returning false stops the iteration
+     * (like a break statement would).
      */
     template <typename... Types, typename Callback>
     Callback for_each(Callback func)
@@ -294,6 +768,7 @@ public:
             }
 
             // Otherwise, proceed as usual
+            IterationGuard guard { iterating_, *contPtrs... };
             this->component_intersection_(func, *contPtrs...);
         }(this->try_get_cont_<Types>()...);
 
@@ -301,124 +776,1476 @@ public:
     }
 
     /*
-     * Allocates enough space for n components of type Type.
+     * Finds the first entity (in iteration order) with all of Types...
+     * for which pred() returns true, then stops. pred() takes the same
+     * parameters as a for_each() callback.
      *
-     * (Internal tip: creates the relevant container if it does not
-     * already exist, which can optimize the first component bind of
-     * type Type.)
+     * Returns an empty std::optional if there is no such entity.
      */
-    template <typename Type>
-    void reserve_components(std::size_t n)
+    template <typename... Types, typename Predicate>
+    std::optional<oki::Entity> find_first(Predicate pred)
     {
-        auto& container = this->get_or_create_cont_<Type>();
-        container.reserve(n);
+        std::optional<oki::Entity> found;
+        this->for_each<Types...>([&](oki::Entity entity, auto&&... comps) {
+            if (pred(entity, comps...)) {
+                found = entity;
+                return false;
+            }
+
+            return true;
+        });
+
+        return found;
     }
 
     /*
-     * Returns the number of components of a given type.
+     * Returns whether any entity with all of Types... satisfies pred(),
+     * stopping as soon as one does.
      */
-    template <typename Type>
-    std::size_t num_components() const
+    template <typename... Types, typename Predicate>
+    bool any(Predicate pred)
     {
-        return this->call_on_cont_checked_<Type, std::size_t>(
-            [](auto& container) { return container.size(); }, 0);
+        return this->find_first<Types...>(pred).has_value();
     }
 
+    /*
+     * Returns the number of entities that have all of Types..., which is
+     * what the equivalent for_each() would visit. Only compares keys and
+     * never touches the components themselves.
+     */
     template <typename... Types>
-    class ComponentView
+    std::size_t count() const
     {
-    public:
-        ComponentView(const ComponentView&) noexcept = default;
-        ComponentView(ComponentView&&) noexcept = default;
-        ~ComponentView() noexcept = default;
+        return [&](auto... contPtrs) -> std::size_t {
+            if ((!contPtrs || ...)) {
+                return 0;
+            }
+
+            return oki::intl_::count_set_intersection(
+                std::make_pair(contPtrs->cbegin(), contPtrs->cend())...);
+        }(this->try_get_cont_<Types>()...);
+    }
+
+    /*
+     * Aggregates a value over every entity with all of Types..., spreading
+     * the work over several threads when there are enough entities.
+     *
+     * map() is called like a for_each() callback and its result is folded
+     * into the total with combine(total, mapped). Each thread folds its own
+     * partial result starting from <identity>, and the partials are then
+     * combined in iteration order. So:
+     *   - combine() must be associative and <identity> neutral for it
+     *   - map() and combine() may be called concurrently (but never on the
+     *      same entity twice)
+     */
+    template <typename... Types, typename ValueType, typename Map,
+        typename Combine>
+    ValueType reduce(ValueType identity, Map map, Combine combine)
+    {
+        return [&](auto... contPtrs) -> ValueType {
+            if ((!contPtrs || ...)) {
+                return identity;
+            }
+
+            IterationGuard guard { iterating_, *contPtrs... };
+            return this->reduce_intersection_(
+                std::move(identity), map, combine, *contPtrs...);
+        }(this->try_get_cont_<Types>()...);
+    }
 
+    /*
+     * The entities that share one value of a shared component, as handed
+     * to for_each_group() callbacks.
+     */
+    template <typename... Types>
+    class EntityGroup
+    {
+    public:
+        /*
+         * Calls func(entity, components...) for each entity of the group
+         * that also has a component of every type in Types..., in
+         * iteration order.
+         */
         template <typename Callback>
-        Callback for_each(Callback func)
+        Callback for_each(Callback func) const
         {
-            std::apply(
-                [&](auto& cont, auto&... containers) {
-                    component_intersection_(func, cont, containers...);
-                },
-                containers_);
-
+            this->for_each_(func, std::index_sequence_for<Types...> {});
             return func;
         }
 
+        // The number of entities sharing the value
+        std::size_t size() const noexcept { return last_ - first_; }
+
     private:
-        std::tuple<Container<Types>&...> containers_;
+        static constexpr std::size_t NO_MATCH
+            = std::numeric_limits<std::size_t>::max();
+
+        // Positions in the shared container, and (indexed by those) the
+        // handles there and the matching positions in the other containers
+        const std::size_t* first_;
+        const std::size_t* last_;
+        const HandleType* handles_;
+        std::array<const std::size_t*, sizeof...(Types)> matches_;
+        std::tuple<Container<Types>*...> containers_;
+
+        EntityGroup(const std::size_t* first, const std::size_t* last,
+            const HandleType* handles,
+            std::array<const std::size_t*, sizeof...(Types)> matches,
+            std::tuple<Container<Types>*...> containers) noexcept
+            : first_(first)
+            , last_(last)
+            , handles_(handles)
+            , matches_(matches)
+            , containers_(containers)
+        {
+        }
 
-        ComponentView(std::tuple<Container<Types>&...> containers)
-            : containers_(containers)
+        template <typename Callback, std::size_t... Is>
+        void for_each_(Callback& func, std::index_sequence<Is...>) const
         {
+            for (auto pos = first_; pos != last_; ++pos) {
+                if (((matches_[Is][*pos] != NO_MATCH) && ...)) {
+                    func(make_entity_(handles_[*pos]),
+                        (*(std::get<Is>(containers_)->begin()
+                             + matches_[Is][*pos]))
+                            .second...);
+                }
+            }
         }
 
         friend class oki::ComponentManager;
     };
 
     /*
-     * Get a reusable way to iterate over a set of components. It is
-     * designed to amortize the cost, so allocates and locates all
-     * relevant containers upfront, and should perform better than
-     * for_each() for each subsequent use.
+     * Visits the entities with a shared component (see oki_shared.h)
+     * grouped by value: calls func(value, group) once per distinct value,
+     * where group is an EntityGroup<Types...> of the entities sharing it.
+     * Per-value work then happens once rather than per entity:
      *
-     * The returned object is unchecked and is only valid if:
-     *  - The object it came from is still alive and in the same location
-     *  - erase_components() [the non-template version] has not been called
+     *     compMan.for_each_group<Material, Mesh>([](auto& mat, auto& group) {
+     *         bind(mat);
+     *         group.for_each([](oki::Entity, Mesh& mesh) { draw(mesh); });
+     *     });
+     *
+     * The entities are matched up with the other components in one sweep
+     * per type (in handle order, where the searches are short), then
+     * grouped with a counting sort, so a group's components are found
+     * without searching.
      */
-    template <typename... Types>
-    ComponentView<Types...> get_component_view()
+    template <typename SharedType, typename... Types, typename Callback>
+    Callback for_each_group(Callback func)
     {
-        auto& c = this->get_or_create_cont_<int>();
+        static_assert(IS_SHARED_<SharedType>,
+            "for_each_group() requires a shared component type");
 
-        // std::unordered_map does not invalidate references so this is ok
-        return ComponentView<Types...>(
-            std::tie(this->get_or_create_cont_<Types>()...));
-    }
+        [&](auto* sharedCont, auto... contPtrs) {
+            if (!sharedCont || (!contPtrs || ...)) {
+                return;
+            }
 
-private:
-    std::unordered_map<oki::intl_::TypeIndex, ErasedContainer> data_;
+            IterationGuard guard { iterating_, *sharedCont, *contPtrs... };
 
-    oki::intl_::DefaultHandleGenerator<oki::Entity::HandleType> handGen_;
+            std::vector<HandleType> handles;
+            handles.reserve(sharedCont->size());
+            for (auto iter = sharedCont->cbegin(); iter != sharedCont->cend();
+                 ++iter) {
+                handles.push_back(iter->first);
+            }
 
-    template <typename Type>
-    Container<Type>& create_cont_()
-    {
-        auto [iter, _]
-            = data_.emplace(oki::intl_::get_type<Type>(), Container<Type>());
+            // (Unused when there are no other types)
+            [[maybe_unused]] std::array<std::vector<std::size_t>,
+                sizeof...(Types)>
+                matches;
+            std::array<const std::size_t*, sizeof...(Types)> matchPtrs {};
+            [[maybe_unused]] std::size_t idx = 0;
 
-        return iter->second;
-    }
+            ((match_positions_(handles, *contPtrs, matches[idx]),
+                 matchPtrs[idx] = matches[idx].data(), ++idx),
+                ...);
+
+            auto conts = std::make_tuple(contPtrs...);
+            auto visit = [&](const auto& value, const std::size_t* first,
+                             const std::size_t* last) {
+                EntityGroup<Types...> group { first, last, handles.data(),
+                    matchPtrs, conts };
+                func(value, group);
+            };
+
+            sharedCont->for_each_group(visit);
+        }(this->try_get_cont_<SharedType>(), this->try_get_cont_<Types>()...);
+
+        return func;
+    }
+
+    /*
+     * Returns the first entity (in iteration order) whose component has its
+     * MEMBER field equal to <value>, found through an index on the field
+     * (see oki_index.h): in O(1) with a HashIndex and O(log n) with an
+     * OrderedIndex.
+     *
+     *     auto owner = compMan.find_by<&NetId::id>(42);
+     *
+     * Returns an empty std::optional if there is no such entity.
+     */
+    template <auto MEMBER>
+    std::optional<oki::Entity> find_by(
+        const oki::intl_::FieldOf<MEMBER>& value)
+    {
+        using Type = oki::intl_::ClassOf<MEMBER>;
+        static_assert(IS_INDEXED_<Type>, "find_by() requires an index");
+
+        auto* container = this->try_get_cont_<Type>();
+        if (!container) {
+            return std::nullopt;
+        }
+
+        if (auto* handle = container->template find_first<MEMBER>(value)) {
+            return make_entity_(*handle);
+        }
+
+        return std::nullopt;
+    }
+
+    /*
+     * Writes every entity whose component has its MEMBER field equal to
+     * <value> to <out>, in iteration order, through an index on the field
+     * (see find_by()). Costs O(1 + k) with a HashIndex and O(log n + k)
+     * with an OrderedIndex for k entities.
+     */
+    template <auto MEMBER, typename OutputIt>
+    OutputIt find_all_by(
+        const oki::intl_::FieldOf<MEMBER>& value, OutputIt out)
+    {
+        using Type = oki::intl_::ClassOf<MEMBER>;
+        static_assert(IS_INDEXED_<Type>, "find_all_by() requires an index");
+
+        if (auto* container = this->try_get_cont_<Type>()) {
+            auto write = [&out](HandleType handle) {
+                *out++ = make_entity_(handle);
+            };
+
+            container->template for_each_equal<MEMBER>(value, write);
+        }
+
+        return out;
+    }
+
+    /*
+     * Writes every entity whose component has its MEMBER field in [lo, hi)
+     * to <out>, in order of field value, through an OrderedIndex on the
+     * field (see oki_index.h). Costs O(log n + k) for k entities.
+     */
+    template <auto MEMBER, typename OutputIt>
+    OutputIt find_range_by(const oki::intl_::FieldOf<MEMBER>& lo,
+        const oki::intl_::FieldOf<MEMBER>& hi, OutputIt out)
+    {
+        using Type = oki::intl_::ClassOf<MEMBER>;
+        static_assert(IS_INDEXED_<Type>, "find_range_by() requires an index");
+
+        if (auto* container = this->try_get_cont_<Type>()) {
+            auto write = [&out](HandleType handle) {
+                *out++ = make_entity_(handle);
+            };
+
+            container->template for_each_in_range<MEMBER>(lo, hi, write);
+        }
+
+        return out;
+    }
+
+    /*
+     * Allocates enough space for n components of type Type.
+     *
+     * (Internal tip: creates the relevant container if it does not
+     * already exist, which can optimize the first component bind of
+     * type Type.)
+     */
+    template <typename Type>
+    void reserve_components(std::size_t n)
+    {
+        if constexpr (IS_SPLIT_<Type>) {
+            this->reserve_components<oki::Hot<Type>>(n);
+            this->reserve_components<oki::Cold<Type>>(n);
+        } else {
+            auto& container = this->get_or_create_cont_<Type>();
+            if (n > container.capacity()) {
+                this->check_not_iterating_(&container);
+            }
+
+            container.reserve(n);
+        }
+    }
+
+    /*
+     * Allocates enough space for n components of every type that has been
+     * used so far.
+     */
+    void reserve_components(std::size_t n)
+    {
+        for (auto& container : containers_) {
+            this->check_not_iterating_(container.address());
+            container.invoke(&ContainerOps::reserve, n);
+        }
+    }
+
+    /*
+     * Returns the number of components of a given type.
+     */
+    template <typename Type>
+    std::size_t num_components() const
+    {
+        if constexpr (IS_SPLIT_<Type>) {
+            return this->num_components<oki::Hot<Type>>();
+        } else {
+            return this->call_on_cont_checked_<Type, std::size_t>(
+                [](auto& container) { return container.size(); }, 0);
+        }
+    }
+
+    /*
+     * Returns the number of components of all types.
+     */
+    std::size_t num_components() const
+    {
+        std::size_t total = 0;
+        for (const auto& container : containers_) {
+            total += container.invoke(&ContainerOps::size);
+        }
+
+        return total;
+    }
+
+    /*
+     * Returns the number of bytes allocated for component storage (used or
+     * not), not counting the bookkeeping for each component type.
+     */
+    std::size_t component_memory_usage() const
+    {
+        std::size_t total = 0;
+        for (const auto& container : containers_) {
+            total += container.invoke(&ContainerOps::memory_usage);
+        }
+
+        return total;
+    }
+
+    /*
+     * Releases the unused memory of every component type, e.g. after a
+     * large number of entities have been destroyed.
+     *
+     * Like any other reallocation, invalidates references to components.
+     */
+    void shrink_components()
+    {
+        for (auto& container : containers_) {
+            this->check_not_iterating_(container.address());
+            container.invoke(&ContainerOps::shrink_to_fit);
+        }
+    }
+
+    /*
+     * Compacts the arena of a blob component type (see oki_blob.h): its
+     * blobs are moved to the front in iteration order, dropping the holes
+     * and spare capacity left behind by growing and removing them. This
+     * also happens on its own when removing components leaves the arena
+     * mostly holes; call it after growing many blobs, say once per frame.
+     *
+     * Invalidates pointers into blobs (but not BlobRefs).
+     */
+    template <typename Type>
+    void defragment()
+    {
+        static_assert(IS_BLOB_<Type>, "defragment() requires a blob type");
+
+        if (auto* container = this->try_get_cont_<Type>()) {
+            this->check_not_iterating_(container);
+            container->compact();
+        }
+    }
+
+    template <typename... Types>
+    class ComponentView
+    {
+        // A lone type needs no intersection, so we can expose its
+        // container's (random-access) iterators almost directly
+        using BaseIterator = std::conditional_t<sizeof...(Types) == 1,
+            typename Container<
+                std::tuple_element_t<0, std::tuple<Types...>>>::iterator,
+            oki::intl_::IntersectionIterator<
+                typename Container<Types>::iterator...>>;
+
+    public:
+        /*
+         * Iterates over every entity that has all of Types..., yielding a
+         * std::tuple<oki::Entity, Types&...> for each (which works well
+         * with structured bindings). Column-stored types are yielded as
+         * oki::ColumnRef<Type> instead.
+         *
+         * The tuple is returned by value, so this is a proxy iterator: it
+         * is random-access for single-type views and forward otherwise,
+         * which is enough for the standard (parallel) algorithms.
+         */
+        class iterator
+        {
+        public:
+            using iterator_category =
+                typename std::iterator_traits<BaseIterator>::iterator_category;
+            using value_type = std::tuple<oki::Entity, ComponentRef<Types>...>;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type;
+            using pointer = void;
+
+            iterator() = default;
+
+            reference operator*() const
+            {
+                if constexpr (sizeof...(Types) == 1) {
+                    auto&& pair = *base_;
+                    return { make_entity_(pair.first), pair.second };
+                } else {
+                    return std::apply(
+                        [](auto&& pair, auto&&... rest) {
+                            return reference { make_entity_(pair.first),
+                                pair.second, rest.second... };
+                        },
+                        *base_);
+                }
+            }
+
+            reference operator[](difference_type n) const
+            {
+                return *(*this + n);
+            }
+
+            iterator& operator++()
+            {
+                ++base_;
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto old = *this;
+                ++base_;
+
+                return old;
+            }
+
+            iterator& operator--()
+            {
+                --base_;
+                return *this;
+            }
+
+            iterator operator--(int)
+            {
+                auto old = *this;
+                --base_;
+
+                return old;
+            }
+
+            iterator& operator+=(difference_type n)
+            {
+                base_ += n;
+                return *this;
+            }
+
+            iterator& operator-=(difference_type n)
+            {
+                base_ -= n;
+                return *this;
+            }
+
+            friend iterator operator+(iterator iter, difference_type n)
+            {
+                return iter += n;
+            }
+
+            friend iterator operator+(difference_type n, iterator iter)
+            {
+                return iter += n;
+            }
+
+            friend iterator operator-(iterator iter, difference_type n)
+            {
+                return iter -= n;
+            }
+
+            friend difference_type operator-(
+                const iterator& lhs, const iterator& rhs)
+            {
+                return lhs.base_ - rhs.base_;
+            }
+
+            bool operator==(const iterator& that) const
+            {
+                return base_ == that.base_;
+            }
+
+            bool operator!=(const iterator& that) const
+            {
+                return base_ != that.base_;
+            }
+
+            bool operator<(const iterator& that) const
+            {
+                return base_ < that.base_;
+            }
+
+            bool operator>(const iterator& that) const
+            {
+                return base_ > that.base_;
+            }
+
+            bool operator<=(const iterator& that) const
+            {
+                return base_ <= that.base_;
+            }
+
+            bool operator>=(const iterator& that) const
+            {
+                return base_ >= that.base_;
+            }
+
+        private:
+            BaseIterator base_;
+
+            explicit iterator(BaseIterator base)
+                : base_(base)
+            {
+            }
+
+            friend class ComponentView;
+        };
+
+        ComponentView(const ComponentView&) noexcept = default;
+        ComponentView(ComponentView&&) noexcept = default;
+        ~ComponentView() noexcept = default;
+
+        iterator begin() const
+        {
+            std::apply([](auto&... conts) { (mark_all_changed_(conts), ...); },
+                containers_);
+
+            if constexpr (sizeof...(Types) == 1) {
+                return iterator { std::get<0>(containers_).begin() };
+            } else {
+                return std::apply(
+                    [](auto&... conts) {
+                        return iterator { BaseIterator {
+                            std::make_pair(conts.begin(), conts.end())... } };
+                    },
+                    containers_);
+            }
+        }
+
+        iterator end() const
+        {
+            if constexpr (sizeof...(Types) == 1) {
+                return iterator { std::get<0>(containers_).end() };
+            } else {
+                return std::apply(
+                    [](auto&... conts) {
+                        return iterator { BaseIterator {
+                            std::make_pair(conts.end(), conts.end())... } };
+                    },
+                    containers_);
+            }
+        }
+
+        /*
+         * For a view of a single column-stored type, returns an
+         * oki::ColumnSpan over its Ith field (in declaration order) for
+         * every entity, in iteration order: i.e. column<I>()[n] is the
+         * field of the nth entity. This is what SIMD kernels want.
+         */
+        template <std::size_t I>
+        auto column() const
+        {
+            static_assert(sizeof...(Types) == 1
+                    && (IS_COLUMNS_<Types> && ...),
+                "Only views of one column-stored type have columns");
+
+            return std::get<0>(containers_).template column<I>();
+        }
+
+        template <typename Callback>
+        Callback for_each(Callback func)
+        {
+            std::apply(
+                [&](auto& cont, auto&... containers) {
+                    IterationGuard guard { *iterating_, cont, containers... };
+                    component_intersection_(func, cont, containers...);
+                },
+                containers_);
+
+            return func;
+        }
+
+        /*
+         * Equivalent to ComponentManager::reduce<Types...>().
+         */
+        template <typename ValueType, typename Map, typename Combine>
+        ValueType reduce(ValueType identity, Map map, Combine combine)
+        {
+            return std::apply(
+                [&](auto&... containers) {
+                    IterationGuard guard { *iterating_, containers... };
+                    return reduce_intersection_(
+                        std::move(identity), map, combine, containers...);
+                },
+                containers_);
+        }
+
+    private:
+        std::tuple<Container<Types>&...> containers_;
+        std::vector<const void*>* iterating_;
+
+        ComponentView(std::tuple<Container<Types>&...> containers,
+            std::vector<const void*>& iterating)
+            : containers_(containers)
+            , iterating_(&iterating)
+        {
+        }
+
+        friend class oki::ComponentManager;
+    };
+
+    /*
+     * Get a reusable way to iterate over a set of components. It is
+     * designed to amortize the cost, so allocates and locates all
+     * relevant containers upfront, and should perform better than
+     * for_each() for each subsequent use.
+     *
+     * The returned object is unchecked and is only valid if:
+     *  - The object it came from is still alive and in the same location
+     */
+    template <typename... Types>
+    ComponentView<Types...> get_component_view()
+    {
+        // Containers never move once created, so this is ok
+        return ComponentView<Types...>(
+            std::tie(this->get_or_create_cont_<Types>()...), iterating_);
+    }
+
+    /*
+     * A cursor over the components of one type which remembers where its
+     * last lookup landed and searches onwards from there (see
+     * AssocSortedVector::lower_bound() with a hint). Looking entities up in
+     * ascending order - e.g. while iterating over another component type -
+     * then costs little more than a linear scan, rather than a full binary
+     * search each.
+     *
+     * Lookups in any other order are still correct, just not faster.
+     *
+     * It is valid for as long as a view from get_component_view() is.
+     */
+    template <typename Type>
+    class ComponentAccessor
+    {
+    public:
+        /*
+         * Equivalent to ComponentManager::get_component().
+         */
+        ComponentRef<Type> get(oki::Entity entity)
+        {
+            auto iter = this->seek_(entity.handle_);
+
+            if constexpr (oki::intl_::CHECKED) {
+                oki::intl_::check(
+                    iter != container_->end() && iter->first == entity.handle_,
+                    "Entity does not have a component of this type");
+            }
+
+            return (*iter).second;
+        }
+
+        /*
+         * Equivalent to ComponentManager::get_component_checked().
+         */
+        ComponentPtr<Type> get_checked(oki::Entity entity)
+        {
+            auto iter = this->seek_(entity.handle_);
+
+            return (iter != container_->end() && iter->first == entity.handle_)
+                ? address_of_<Type>((*iter).second)
+                : ComponentPtr<Type> {};
+        }
+
+        bool has(oki::Entity entity)
+        {
+            auto iter = this->seek_(entity.handle_);
+            return iter != container_->end() && iter->first == entity.handle_;
+        }
+
+    private:
+        Container<Type>* container_;
+        std::size_t cursor_ = 0;
+
+        ComponentAccessor(Container<Type>& container)
+            : container_(&container)
+        {
+        }
+
+        auto seek_(HandleType handle)
+        {
+            // Components may have come and gone since, so the cursor is
+            // kept as an index and is only ever a hint
+            auto begin = container_->cbegin();
+            auto hint = begin + std::min(cursor_, container_->size());
+
+            auto iter = container_->lower_bound(handle, hint);
+            cursor_ = static_cast<std::size_t>(iter - container_->begin());
+
+            return iter;
+        }
+
+        friend class oki::ComponentManager;
+    };
+
+    /*
+     * Get a cursor for looking up many components of one type, which is
+     * fastest when they are looked up in ascending entity order (such as
+     * the order for_each() visits entities in).
+     */
+    template <typename Type>
+    ComponentAccessor<Type> get_component_accessor()
+    {
+        return ComponentAccessor<Type>(this->get_or_create_cont_<Type>());
+    }
+
+    /*
+     * Looks up Types... for every entity in [first, last), assuming
+     * (without checking, in unchecked builds) that each entity has them,
+     * and writes a std::tuple of what get_component<Types>() would return
+     * per entity to <out>.
+     *
+     * Each type shares one ComponentAccessor across the whole range, so
+     * entities sorted in ascending order are the fastest to look up.
+     *
+     * Returns the output iterator one past the last tuple written.
+     */
+    template <typename... Types, typename InputIt, typename OutputIt>
+    OutputIt get_components(InputIt first, InputIt last, OutputIt out)
+    {
+        auto accessors
+            = std::make_tuple(this->get_component_accessor<Types>()...);
+
+        for (; first != last; ++first) {
+            oki::Entity entity = *first;
+            this->check_entity_(entity);
+
+            *out++ = std::apply(
+                [&](auto&... accs) {
+                    return std::tuple<ComponentRef<Types>...> { accs.get(
+                        entity)... };
+                },
+                accessors);
+        }
+
+        return out;
+    }
+
+    /*
+     * Looks up Types... for every entity in [first, last) and writes a
+     * std::tuple<Types*...> per entity to <out>, where each pointer is
+     * nullptr if the entity has no such component (like
+     * get_components_checked()).
+     *
+     * Unlike the get_components() overload above, this is built for
+     * entities in no particular order, e.g. a list of targets: the lookups
+     * for a batch of entities are interleaved and prefetched so that they
+     * wait on memory together rather than one after another.
+     *
+     * Returns the output iterator one past the last tuple written.
+     */
+    template <typename... Types, typename InputIt, typename OutputIt>
+    OutputIt get_components_batch(InputIt first, InputIt last, OutputIt out)
+    {
+        auto conts = std::make_tuple(this->try_get_cont_<Types>()...);
+
+        std::array<HandleType, BATCH_SIZE_> handles;
+        std::array<std::array<std::size_t, BATCH_SIZE_>, sizeof...(Types)>
+            found;
+
+        while (first != last) {
+            std::size_t count = 0;
+            for (; count != BATCH_SIZE_ && first != last; ++count, ++first) {
+                oki::Entity entity = *first;
+                handles[count] = entity.handle_;
+            }
+
+            // One interleaved search per type...
+            this->batch_search_(conts, handles.data(), count, found,
+                std::index_sequence_for<Types...> {});
+
+            // ...then one tuple per entity
+            for (std::size_t i = 0; i != count; ++i) {
+                *out++ = this->batch_gather_(conts, handles[i], found, i,
+                    std::index_sequence_for<Types...> {});
+            }
+        }
+
+        return out;
+    }
+
+    /*
+     * A template for entities that all start with the same component
+     * values, e.g. every pipe in a game: it holds one value per type in
+     * Types, along with the containers they go in (looked up once, when
+     * the prefab is created).
+     *
+     * It is valid for as long as a view from get_component_view() is, and
+     * must only be instantiated by the ComponentManager that created it.
+     */
+    template <typename... Types>
+    class Prefab
+    {
+    public:
+        // The value that instantiate() copies into each new entity
+        template <typename Type>
+        Type& get() noexcept
+        {
+            return std::get<Type>(values_);
+        }
+
+        template <typename Type>
+        const Type& get() const noexcept
+        {
+            return std::get<Type>(values_);
+        }
+
+    private:
+        std::tuple<Container<Types>*...> containers_;
+        std::tuple<Types...> values_;
+
+        Prefab(Container<Types>&... containers, Types... values)
+            : containers_(&containers...)
+            , values_(std::move(values)...)
+        {
+        }
+
+        friend class oki::ComponentManager;
+    };
+
+    /*
+     * Creates a prefab out of the given component values (see Prefab).
+     */
+    template <typename... Types>
+    Prefab<std::decay_t<Types>...> create_prefab(Types&&... values)
+    {
+        static_assert(sizeof...(Types) > 0, "Prefab must have a component");
+        static_assert(are_distinct_<Types...>(),
+            "An entity can only have one component of each type");
+
+        return Prefab<std::decay_t<Types>...>(
+            this->get_or_create_cont_<std::decay_t<Types>>()...,
+            std::forward<Types>(values)...);
+    }
+
+    /*
+     * Creates <n> entities with a copy of each of the prefab's components,
+     * like spawn() but without finding any containers.
+     */
+    template <typename... Types>
+    oki::EntityRange instantiate(
+        const Prefab<Types...>& prefab, std::size_t n = 1)
+    {
+        auto values = [&prefab](std::size_t) -> const auto& {
+            return prefab.values_;
+        };
+
+        return std::apply(
+            [&](auto*... conts) {
+                return this->spawn_into_(std::tie(*conts...), n, values);
+            },
+            prefab.containers_);
+    }
+
+    /*
+     * Lets one other thread (e.g. a renderer) read the components of a
+     * buffered type Type (see oki_buffered.h) as of the last
+     * publish_components(), without locks, while the ComponentManager goes
+     * on changing them.
+     *
+     * It holds three copies of the components: the one being read, the
+     * latest published one and a spare that the next publish brings up to
+     * date. Both publishing and acquire() swap which copy plays which role
+     * with a single atomic exchange, so the reader never waits and never
+     * sees a copy that is being written.
+     *
+     * The reader must be the only thread calling acquire(); whatever it
+     * acquired stays valid (and unchanged) until its next acquire().
+     */
+    template <typename Type>
+    class TripleBuffer
+    {
+        static_assert(IS_BUFFERED_<Type>,
+            "Only buffered components (see oki_buffered.h) can be published");
+
+        using Snapshot
+            = oki::intl_::AssocSortedVector<HandleType, Stored<Type>>;
+
+    public:
+        // A consistent, read-only snapshot of the components
+        class FrontBuffer
+        {
+        public:
+            /*
+             * Calls func(entity, component) for each component, in the
+             * same order for_each() would. Components are passed as const
+             * references.
+             */
+            template <typename Callback>
+            Callback for_each(Callback func) const
+            {
+                for (auto iter = container_->cbegin();
+                     iter != container_->cend(); ++iter) {
+                    func(make_entity_(iter->first), iter->second);
+                }
+
+                return func;
+            }
+
+            bool contains(oki::Entity entity) const
+            {
+                return container_->contains(entity.handle_);
+            }
+
+            // The entity's component, which must be present
+            const Type& get(oki::Entity entity) const
+            {
+                auto iter = container_->find(entity.handle_);
+                oki::intl_::check(iter != container_->cend(),
+                    "Entity does not have a component of this type");
+
+                return iter->second;
+            }
+
+            std::size_t size() const noexcept { return container_->size(); }
+            bool empty() const noexcept { return !container_->size(); }
+
+        private:
+            const Snapshot* container_;
+
+            explicit FrontBuffer(const Snapshot& container) noexcept
+                : container_(&container)
+            {
+            }
+
+            friend class TripleBuffer;
+        };
+
+        TripleBuffer() = default;
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        /*
+         * Returns the latest published components (which are empty until
+         * the first publish).
+         */
+        FrontBuffer acquire()
+        {
+            if (ready_.load(std::memory_order_acquire) & FRESH_) {
+                auto ready
+                    = ready_.exchange(reading_, std::memory_order_acq_rel);
+                reading_ = ready & ~FRESH_;
+            }
+
+            return FrontBuffer(buffers_[reading_]);
+        }
+
+    private:
+        static constexpr unsigned FRESH_ = 4;
+
+        // The keys that changed since a copy was last brought up to date
+        // (or, if all_, possibly every key)
+        struct Stale
+        {
+            std::vector<HandleType> keys;
+            bool all = true;
+        };
+
+        std::array<Snapshot, 3> buffers_;
+
+        // Owned by the writer, like the scratch space below
+        std::array<Stale, 3> stale_;
+
+        // Owned by the writer and reader respectively
+        unsigned writing_ = 0;
+        unsigned reading_ = 1;
+
+        // The latest published buffer, flagged FRESH_ until acquired
+        std::atomic<unsigned> ready_ { 2 };
+
+        std::vector<HandleType> changed_, merged_, added_, removed_;
+
+        // Adds the keys changed since the last publish to every copy's
+        // stale keys, giving up on any that would outgrow <size>
+        void add_stale_(bool allChanged, std::size_t size)
+        {
+            for (auto& stale : stale_) {
+                if (stale.all) {
+                    continue;
+                }
+
+                if (allChanged || stale.keys.size() + changed_.size() > size) {
+                    stale.all = true;
+                    stale.keys.clear();
+                    continue;
+                }
+
+                merged_.clear();
+                std::set_union(stale.keys.begin(), stale.keys.end(),
+                    changed_.begin(), changed_.end(),
+                    std::back_inserter(merged_));
+                stale.keys.swap(merged_);
+            }
+        }
+
+        // Brings the spare copy up to date with <source>
+        void refresh_(const Container<Type>& source)
+        {
+            auto& back = buffers_[writing_];
+            auto& stale = stale_[writing_];
+
+            if (stale.all) {
+                back.clear();
+                back.reserve(source.size());
+
+                for (auto iter = source.cbegin(); iter != source.cend();
+                     ++iter) {
+                    back.append_unchecked(iter->first, iter->second);
+                }
+            } else {
+                added_.clear();
+                removed_.clear();
+
+                // Values are assigned in place; only added and removed
+                // keys move the others (which costs a sweep of the copy)
+                auto srcIter = source.cbegin();
+                auto backIter = back.begin();
+
+                for (auto key : stale.keys) {
+                    srcIter = source.lower_bound(key, srcIter);
+                    backIter = back.lower_bound(key, backIter);
+
+                    bool inSource
+                        = srcIter != source.cend() && srcIter->first == key;
+                    bool inBack = backIter != back.end()
+                        && backIter->first == key;
+
+                    if (inSource && inBack) {
+                        backIter->second = srcIter->second;
+                    } else if (inSource) {
+                        added_.push_back(key);
+                    } else if (inBack) {
+                        removed_.push_back(key);
+                    }
+                }
+
+                back.erase_sorted(removed_.begin(), removed_.end());
+
+                auto oldSize = back.size();
+                for (auto key : added_) {
+                    back.append_unchecked(key, source.find(key)->second);
+                }
+                back.merge_appended(oldSize);
+            }
+
+            stale.keys.clear();
+            stale.all = false;
+        }
+
+        friend class oki::ComponentManager;
+    };
+
+    /*
+     * Publishes the current components of buffered type Type (see
+     * oki_buffered.h) to <buffer>, for its reader to acquire(). Only the
+     * thread changing the ComponentManager may call this, and each type
+     * may be published to only one buffer.
+     *
+     * This brings the buffer's spare copy up to date and then swaps it in,
+     * which is a single atomic exchange. Bringing it up to date copies only
+     * the components that changed since that copy was last published
+     * (assigning most in place, in O(log n) each), or all of them if more
+     * changed than that.
+     */
+    template <typename Type>
+    void publish_components(TripleBuffer<Type>& buffer)
+    {
+        auto& cont = this->get_or_create_cont_<Type>();
+        oki::intl_::check(cont.claim_changes(&buffer),
+            "A component type can only be published to one buffer");
+
+        bool allChanged = cont.take_changes(buffer.changed_);
+        buffer.add_stale_(allChanged, cont.size());
+        buffer.refresh_(cont);
+
+        auto ready = buffer.ready_.exchange(
+            buffer.writing_ | TripleBuffer<Type>::FRESH_,
+            std::memory_order_acq_rel);
+        buffer.writing_ = ready & ~TripleBuffer<Type>::FRESH_;
+    }
+
+    /*
+     * Makes <parent> the parent of <child> (e.g. a turret attached to a
+     * vehicle), detaching it from its previous parent, if any. Throws
+     * std::invalid_argument if <parent> is <child> or one of its
+     * descendants.
+     *
+     * Relationships are kept apart from components: the manager stores
+     * parent, first-child and sibling links plus a breadth-first order of
+     * every related entity, which propagate() walks linearly. Destroying
+     * an entity detaches it and turns its children into roots; see
+     * destroy_subtree() to destroy them too.
+     */
+    void set_parent(oki::Entity child, oki::Entity parent)
+    {
+        this->check_entity_(child);
+        this->check_entity_(parent);
+
+        hierarchy_.attach(child.handle_, parent.handle_);
+    }
+
+    /*
+     * Makes <parent> the parent of every entity in [first, last) (see
+     * set_parent()). The breadth-first order is only rebuilt once, the
+     * next time it is needed.
+     */
+    template <typename InputIt>
+    void set_parents(InputIt first, InputIt last, oki::Entity parent)
+    {
+        this->check_entity_(parent);
+
+        for (; first != last; ++first) {
+            oki::Entity child = *first;
+            this->check_entity_(child);
+
+            hierarchy_.attach(child.handle_, parent.handle_);
+        }
+    }
+
+    /*
+     * Detaches <child> from its parent, making it a root. Returns whether
+     * it had a parent.
+     */
+    bool remove_parent(oki::Entity child)
+    {
+        return hierarchy_.detach(child.handle_);
+    }
+
+    /*
+     * Returns the parent of <child>, or an empty std::optional if it has
+     * none.
+     */
+    std::optional<oki::Entity> get_parent(oki::Entity child) const
+    {
+        auto parent = hierarchy_.parent_of(child.handle_);
+
+        return !oki::intl_::is_bad_handle(parent)
+            ? std::optional<oki::Entity> { make_entity_(parent) }
+            : std::nullopt;
+    }
+
+    /*
+     * Calls func(child) for every child of <parent>, most recently
+     * attached first. func() may detach or destroy the child it is given
+     * (but no other entity of the hierarchy).
+     */
+    template <typename Callback>
+    Callback for_each_child(oki::Entity parent, Callback func)
+    {
+        auto visit = [&](HandleType child) { func(make_entity_(child)); };
+        hierarchy_.for_each_child(parent.handle_, visit);
+
+        return func;
+    }
+
+    /*
+     * Destroys <root> and all of its descendants, along with their
+     * components, and returns how many entities were destroyed.
+     *
+     * Like destroy_entities(), this sweeps each container once rather
+     * than looking up every entity in it.
+     */
+    std::size_t destroy_subtree(oki::Entity root)
+    {
+        std::vector<HandleType> handles;
+        hierarchy_.collect_subtree(root.handle_, handles);
+
+        return this->destroy_handles_(handles);
+    }
+
+    /*
+     * Visits every entity of the hierarchy that has a component of type
+     * Type, parents before children (breadth-first), and calls
+     * func(entity, component, parentComponent), where parentComponent
+     * points to the parent's component (and is null for roots and when
+     * the parent has none). This is how transforms are propagated:
+     *
+     *     compMan.propagate<Transform>([](auto, auto& local, auto* parent) {
+     *         local.world = parent ? parent->world * local.local
+     *                              : local.local;
+     *     });
+     *
+     * The components are found in one sweep over the container, then the
+     * hierarchy is walked in one linear pass over its stored order, with
+     * each parent's component remembered rather than looked up again.
+     */
+    template <typename Type, typename Callback>
+    Callback propagate(Callback func)
+    {
+        using Hierarchy = oki::intl_::Hierarchy<HandleType>;
+
+        auto* cont = this->try_get_cont_<Type>();
+        if (!cont) {
+            return func;
+        }
+
+        const auto& order = hierarchy_.order();
+        std::vector<ComponentPtr<Type>> found(order.size());
+
+        // Find every component in one sweep: visiting the hierarchy in
+        // handle order lets each search gallop on from the last one
+        auto iter = cont->begin();
+        for (auto idx : hierarchy_.positions_by_handle()) {
+            auto handle = order[idx].handle;
+            iter = cont->lower_bound(handle, iter);
+
+            if (iter != cont->end() && iter->first == handle) {
+                found[idx] = address_of_<Type>((*iter).second);
+            }
+        }
+
+        IterationGuard guard { iterating_, *cont };
+        for (std::size_t idx = 0; idx != order.size(); ++idx) {
+            if (!found[idx]) {
+                continue;
+            }
+
+            auto parentIdx = order[idx].parent;
+            func(make_entity_(order[idx].handle), *found[idx],
+                (parentIdx != Hierarchy::NO_PARENT) ? found[parentIdx]
+                                                    : ComponentPtr<Type> {});
+        }
+
+        return func;
+    }
+
+private:
+    /*
+     * The containers themselves live in a std::deque, which never moves its
+     * elements, so that views (and the pointers in data_) can refer to them
+     * directly. data_ is the index we probe on nearly every call, so it is
+     * a flat map of type -> container.
+     */
+    std::deque<ErasedContainer> containers_;
+    oki::intl_::FlatHashMap<oki::intl_::TypeIndex, ErasedContainer*> data_;
+
+    oki::intl_::DefaultHandleGenerator<oki::Entity::HandleType> handGen_;
+
+    // Parent/child relationships between entities (see set_parent())
+    oki::intl_::Hierarchy<HandleType> hierarchy_;
+
+    // (Checked builds only) The containers being iterated over right now,
+    // which must not have components added to or removed from them
+    std::vector<const void*> iterating_;
+
+    // Marks containers as being iterated over for its lifetime
+    class IterationGuard
+    {
+    public:
+        template <typename... Containers>
+        IterationGuard(
+            std::vector<const void*>& iterating, const Containers&... conts)
+            : iterating_(iterating)
+        {
+            if constexpr (oki::intl_::CHECKED) {
+                iterating_.insert(iterating_.end(), { &conts... });
+                count_ = sizeof...(Containers);
+            }
+        }
+
+        IterationGuard(const IterationGuard&) = delete;
+        IterationGuard& operator=(const IterationGuard&) = delete;
+
+        ~IterationGuard() { iterating_.resize(iterating_.size() - count_); }
+
+    private:
+        std::vector<const void*>& iterating_;
+        std::size_t count_ = 0;
+    };
+
+    void check_entity_(oki::Entity entity) const
+    {
+        if constexpr (oki::intl_::CHECKED) {
+            oki::intl_::check(handGen_.verify_handle(entity.handle_),
+                "Entity is invalid or has been destroyed");
+        }
+    }
+
+    void check_not_iterating_(const void* cont) const
+    {
+        if constexpr (oki::intl_::CHECKED) {
+            oki::intl_::check(std::find(iterating_.begin(), iterating_.end(),
+                                  cont)
+                    == iterating_.end(),
+                "Cannot add or remove components of a type while "
+                "iterating over it");
+        }
+    }
+
+    template <typename Cont>
+    void check_can_insert_(const Cont& cont, HandleType handle)
+    {
+        if constexpr (oki::intl_::CHECKED) {
+            if (!cont.contains(handle)) {
+                this->check_not_iterating_(&cont);
+            }
+        }
+    }
+
+    template <typename Type, typename InsertType>
+    std::pair<ComponentRef<Type>, bool> insert_or_assign_(
+        oki::Entity entity, InsertType&& value)
+    {
+        this->check_entity_(entity);
+
+        auto& cont = this->get_or_create_cont_<Type>();
+        this->check_can_insert_(cont, entity.handle_);
+
+        auto [valIter, success] = cont.insert_or_assign(
+            entity.handle_, std::forward<InsertType>(value));
+
+        return { (*valIter).second, success };
+    }
+
+    // Concurrent handles are created and destroyed through the calling
+    // thread's cache, so that threads do not contend on the generator
+    using HandleSource = std::conditional_t<oki::intl_::CONCURRENT_HANDLES,
+        oki::intl_::ConcurrentHandleGenerator<HandleType>::Cache,
+        oki::intl_::DefaultHandleGenerator<HandleType>>;
+
+    HandleSource& handle_source_() { return handle_source_(handGen_); }
+
+    template <typename Generator>
+    static Generator& handle_source_(Generator& handGen) noexcept
+    {
+        return handGen;
+    }
+
+    static oki::intl_::ConcurrentHandleGenerator<HandleType>::Cache&
+    handle_source_(oki::intl_::ConcurrentHandleGenerator<HandleType>& handGen)
+    {
+        return handGen.thread_cache();
+    }
+
+    /*
+     * Destroys the entities behind <handles> (which it sorts and rids of
+     * repeats) along with their components, sweeping each container once.
+     */
+    std::size_t destroy_handles_(std::vector<HandleType>& handles)
+    {
+        // A repeated handle would be destroyed (and so reused) twice
+        std::sort(handles.begin(), handles.end());
+        handles.erase(
+            std::unique(handles.begin(), handles.end()), handles.end());
+
+        if constexpr (oki::intl_::CHECKED) {
+            for (const auto& container : containers_) {
+                for (auto handle : handles) {
+                    if (container.invoke(&ContainerOps::contains, handle)) {
+                        this->check_not_iterating_(container.address());
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (auto& container : containers_) {
+            container.invoke(&ContainerOps::erase_sorted, handles.data(),
+                handles.data() + handles.size());
+        }
+
+        if (!hierarchy_.empty()) {
+            for (auto handle : handles) {
+                hierarchy_.erase(handle);
+            }
+        }
+
+        std::size_t destroyed = 0;
+        auto& handleSource = this->handle_source_();
+        for (auto handle : handles) {
+            destroyed += handleSource.destroy_handle(handle);
+        }
+
+        return destroyed;
+    }
+
+    template <typename Type>
+    static constexpr void check_not_split_()
+    {
+        static_assert(!IS_SPLIT_<Type>,
+            "Split components are stored (and so must be iterated over or "
+            "pointed to) as oki::Hot<Type> and oki::Cold<Type>");
+    }
 
     template <typename Type>
     Container<Type>& get_or_create_cont_()
     {
+        check_not_split_<Type>();
+
         auto type = oki::intl_::get_type<Type>();
         auto iter = data_.find(type);
 
         if (iter == data_.end()) {
             // This branch is relatively unlikely, so we can avoid
             // type-erasing a new Container<Type> most of the time
-            iter = data_.emplace(type, Container<Type>()).first;
+            auto& erased = containers_.emplace_back(Container<Type>());
+            iter = data_.emplace(type, &erased).first;
         }
 
-        return iter->second.template get_as<Container<Type>>();
+        return iter->second->template get_as<Container<Type>>();
     }
 
     template <typename Type>
     Container<Type>& get_cont_()
     {
+        check_not_split_<Type>();
+
         auto iter = data_.find(oki::intl_::get_type<Type>());
+        oki::intl_::check(
+            iter != data_.end(), "No component of this type exists");
 
-        return iter->second.template get_as<Container<Type>>();
+        return iter->second->template get_as<Container<Type>>();
     }
 
     template <typename Type>
     Container<Type>* try_get_cont_()
     {
+        check_not_split_<Type>();
+
+        auto iter = data_.find(oki::intl_::get_type<Type>());
+
+        return iter != data_.end()
+            ? &iter->second->template get_as<Container<Type>>()
+            : nullptr;
+    }
+
+    template <typename Type>
+    const Container<Type>* try_get_cont_() const
+    {
+        check_not_split_<Type>();
+
         auto iter = data_.find(oki::intl_::get_type<Type>());
 
         return iter != data_.end()
-            ? &iter->second.template get_as<Container<Type>>()
+            ? &std::as_const(*iter->second)
+                   .template get_as<Container<Type>>()
             : nullptr;
     }
 
@@ -429,9 +2256,9 @@ private:
     {
         static_assert(std::is_convertible_v<DefaultRet, ReturnType>);
 
-        auto contIter = data_.find(oki::intl_::get_type<Type>());
-        if (contIter != data_.cend()) {
-            return func(contIter->second.template get_as<Container<Type>>());
+        auto contPtr = this->try_get_cont_<Type>();
+        if (contPtr) {
+            return func(*contPtr);
         }
 
         return defaultValue;
@@ -441,13 +2268,11 @@ private:
         typename DefaultRet>
     ReturnType call_on_cont_checked_(Callback func, DefaultRet defaultValue)
     {
-        // Trying to do this with two const_casts and a std::as_const was worse
-        // than just duplicating this code
         static_assert(std::is_convertible_v<DefaultRet, ReturnType>);
 
-        auto contIter = data_.find(oki::intl_::get_type<Type>());
-        if (contIter != data_.end()) {
-            return func(contIter->second.template get_as<Container<Type>>());
+        auto contPtr = this->try_get_cont_<Type>();
+        if (contPtr) {
+            return func(*contPtr);
         }
 
         return defaultValue;
@@ -464,16 +2289,229 @@ private:
             0);
     }
 
+    // How many entities get_components_batch() resolves at once
+    static constexpr std::size_t BATCH_SIZE_ = 64;
+
+    template <typename Conts, typename Found, std::size_t... Is>
+    static void batch_search_(Conts& conts, const HandleType* handles,
+        std::size_t count, Found& found, std::index_sequence<Is...>)
+    {
+        auto search = [&](auto* cont, auto& results) {
+            if (cont) {
+                cont->lower_bound_batch(
+                    handles, handles + count, results.begin());
+            }
+        };
+
+        (search(std::get<Is>(conts), found[Is]), ...);
+    }
+
+    template <typename Conts, typename Found, std::size_t... Is>
+    static auto batch_gather_(Conts& conts, HandleType handle, Found& found,
+        std::size_t i, std::index_sequence<Is...>)
+    {
+        auto gather = [&](auto* cont, std::size_t idx) {
+            using Type = typename std::remove_pointer_t<
+                decltype(cont)>::mapped_type;
+
+            if (!cont || idx == cont->size()) {
+                return ComponentPtr<Type> {};
+            }
+
+            auto&& pair = cont->begin()[idx];
+            return (pair.first == handle) ? address_of_<Type>(pair.second)
+                                          : ComponentPtr<Type> {};
+        };
+
+        return std::make_tuple(gather(std::get<Is>(conts), found[Is][i])...);
+    }
+
+    // Access that may run on several threads counts as changing every
+    // buffered component, since logging them one by one would race
+    template <typename Cont>
+    static void mark_all_changed_(Cont& cont) noexcept
+    {
+        using Buffered = oki::intl_::BufferedSortedVector<HandleType,
+            typename Cont::mapped_type>;
+
+        if constexpr (std::is_same_v<Cont, Buffered>) {
+            cont.mark_all_changed();
+        }
+    }
+
+    // Below this many entities per thread, reduce() is better off serial
+    static constexpr std::size_t MIN_REDUCE_CHUNK_ = 1 << 13;
+
+    template <typename ValueType, typename Map, typename Combine,
+        typename LeadContainer, typename... Containers>
+    static ValueType reduce_intersection_(ValueType identity, Map& map,
+        Combine& combine, LeadContainer& lead, Containers&... conts)
+    {
+        using Partial = oki::intl_::CacheAligned<ValueType>;
+
+        mark_all_changed_(lead);
+        (mark_all_changed_(conts), ...);
+
+        // We split the first container evenly and restrict the others to
+        // the same range of keys, so every chunk is independent
+        std::size_t size = lead.size();
+        std::size_t numChunks
+            = oki::intl_::choose_num_workers(size, MIN_REDUCE_CHUNK_);
+
+        std::vector<Partial> partials(numChunks, Partial { identity });
+
+        oki::intl_::parallel_for_chunks(size, numChunks,
+            [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                if (begin == end) {
+                    return;
+                }
+
+                auto leadBegin = lead.begin() + begin;
+                auto leadEnd = lead.begin() + end;
+
+                [[maybe_unused]] auto restrict_range = [&](auto& cont) {
+                    auto contEnd = (leadEnd == lead.end())
+                        ? cont.end()
+                        : cont.lower_bound(leadEnd->first);
+
+                    return std::make_pair(
+                        cont.lower_bound(leadBegin->first), contEnd);
+                };
+
+                auto& total = partials[chunk].value;
+                oki::intl_::variadic_set_intersection(
+                    [&](auto&& val, auto&&... vals) {
+                        total = combine(std::move(total),
+                            map(make_entity_(val.first), val.second,
+                                vals.second...));
+                    },
+                    std::make_pair(leadBegin, leadEnd),
+                    restrict_range(conts)...);
+            });
+
+        for (auto& partial : partials) {
+            identity = combine(std::move(identity), std::move(partial.value));
+        }
+
+        return identity;
+    }
+
+    // Does the work of spawn() given a std::tuple of references to the
+    // containers (so that a Prefab can skip looking them up)
+    template <typename Conts, typename Initializer>
+    oki::EntityRange spawn_into_(Conts conts, std::size_t n, Initializer& init)
+    {
+        std::apply(
+            [&](auto&... cont) {
+                (this->check_not_iterating_(&cont), ...);
+                (reserve_for_append_(cont, n), ...);
+            },
+            conts);
+
+        std::array<std::size_t, std::tuple_size_v<Conts>> oldSizes;
+        std::apply(
+            [&](auto&... cont) {
+                std::size_t idx = 0;
+                ((oldSizes[idx++] = cont.size()), ...);
+            },
+            conts);
+
+        auto mergeAll = [&]() {
+            std::apply(
+                [&](auto&... cont) {
+                    std::size_t idx = 0;
+                    (cont.merge_appended(oldSizes[idx++]), ...);
+                },
+                conts);
+        };
+
+        auto range = this->create_entities(n);
+        try {
+            for (std::size_t i = 0; i != n; ++i) {
+                append_components_(conts, range[i].handle_, init(i),
+                    std::make_index_sequence<std::tuple_size_v<Conts>>());
+            }
+        } catch (...) {
+            // Leave the containers sorted; the entities stay alive, with
+            // whatever components were spawned for them
+            mergeAll();
+            throw;
+        }
+
+        mergeAll();
+        return range;
+    }
+
+    // Makes room for <n> more components, growing geometrically so that
+    // many small spawns do not each reallocate
+    template <typename Cont>
+    static void reserve_for_append_(Cont& cont, std::size_t n)
+    {
+        if (cont.capacity() - cont.size() < n) {
+            cont.reserve(std::max(cont.size() + n, cont.capacity() * 2));
+        }
+    }
+
+    // Appends the Is-th of <values> to the Is-th of <conts>, for spawn()
+    template <typename Conts, typename Values, std::size_t... Is>
+    static void append_components_(Conts& conts, HandleType handle,
+        Values&& values, std::index_sequence<Is...>)
+    {
+        (std::get<Is>(conts).append_unchecked(
+             handle, std::get<Is>(std::forward<Values>(values))),
+            ...);
+    }
+
+    // Takes the address of a component, or wraps a proxy (a ColumnRef or
+    // BlobRef, which has none) in a std::optional
+    template <typename Type, typename Ref>
+    static ComponentPtr<Type> address_of_(Ref&& ref) noexcept
+    {
+        if constexpr (IS_COLUMNS_<Type> || IS_BLOB_<Type>) {
+            return ComponentPtr<Type> { ref };
+        } else {
+            return std::addressof(ref);
+        }
+    }
+
+    static oki::Entity make_entity_(HandleType handle) noexcept
+    {
+        oki::Entity entity;
+        entity.handle_ = handle;
+
+        return entity;
+    }
+
+    /*
+     * For each of the ascending <handles>, writes the position of its
+     * component in <cont> to <out> (or EntityGroup's NO_MATCH). Searching
+     * on from the last hit keeps this a near-linear merge.
+     */
+    template <typename Cont>
+    static void match_positions_(const std::vector<HandleType>& handles,
+        const Cont& cont, std::vector<std::size_t>& out)
+    {
+        constexpr auto NO_MATCH = std::numeric_limits<std::size_t>::max();
+
+        out.resize(handles.size());
+        auto hint = cont.cbegin();
+
+        for (std::size_t pos = 0; pos != handles.size(); ++pos) {
+            hint = cont.lower_bound(handles[pos], hint);
+
+            out[pos] = (hint != cont.cend() && hint->first == handles[pos])
+                ? static_cast<std::size_t>(hint - cont.cbegin())
+                : NO_MATCH;
+        }
+    }
+
     template <typename Callback, typename... Containers>
     static void component_intersection_(Callback& func, Containers&... conts)
     {
         oki::intl_::variadic_set_intersection(
-            [&](auto& val, auto&... vals) {
-                // Unfortunate oversight on my part
-                oki::Entity entity;
-                entity.handle_ = val.first;
-
-                func(entity, val.second, vals.second...);
+            [&](auto&& val, auto&&... vals) {
+                return func(
+                    make_entity_(val.first), val.second, vals.second...);
             },
             std::make_pair(conts.begin(), conts.end())...);
     }
@@ -0,0 +1,84 @@
+#ifndef OKI_CONFIG_H
+#define OKI_CONFIG_H
+
+#include <stdexcept>
+
+/*
+ * OKI_CHECKED selects between the two ways the library can be built:
+ *   - Checked (1): misuse is caught and reported by throwing
+ *       std::logic_error, including stale entities, missing components,
+ *       duplicate "unchecked" binds and adding/removing components of a
+ *       type while iterating over it
+ *   - Unchecked (0): the "unchecked" parts of the API really are, so hot
+ *       paths compile down to plain lookups and loads
+ *
+ * It follows NDEBUG unless defined beforehand (to 0 or 1), which must be
+ * done consistently across a program.
+ */
+#ifndef OKI_CHECKED
+#ifdef NDEBUG
+#define OKI_CHECKED 0
+#else
+#define OKI_CHECKED 1
+#endif
+#endif
+
+/*
+ * OKI_HANDLE_BITS selects the width of oki::Handle, the key behind every
+ * entity, observer connection and system:
+ *   - 64 (default): handles are issued linearly and never run out
+ *   - 32: handles are an index plus a generation, reusing indices, which
+ *       halves the memory spent on keys (so twice as many fit in a cache
+ *       line) but caps the number of live handles at 2^24 - 1
+ *
+ * Like OKI_CHECKED, it must be defined consistently across a program.
+ */
+#ifndef OKI_HANDLE_BITS
+#define OKI_HANDLE_BITS 64
+#endif
+
+#if OKI_HANDLE_BITS != 32 && OKI_HANDLE_BITS != 64
+#error "OKI_HANDLE_BITS must be 32 or 64"
+#endif
+
+/*
+ * OKI_CONCURRENT_HANDLES (0 by default) makes handles come from a
+ * thread-safe generator, so that ComponentManager::create_entity() (and
+ * create_entities()) can be called from worker threads, e.g. by a parallel
+ * system that binds the new entities' components once it has joined.
+ * Nothing else about the ComponentManager becomes thread-safe.
+ *
+ * Destroyed handles are still reused, but stale ones are no longer caught
+ * in checked builds. It requires 64-bit handles, and must be defined
+ * consistently across a program.
+ */
+#ifndef OKI_CONCURRENT_HANDLES
+#define OKI_CONCURRENT_HANDLES 0
+#endif
+
+#if OKI_CONCURRENT_HANDLES && OKI_HANDLE_BITS != 64
+#error "OKI_CONCURRENT_HANDLES requires OKI_HANDLE_BITS to be 64"
+#endif
+
+namespace oki {
+namespace intl_ {
+constexpr bool CHECKED = OKI_CHECKED;
+constexpr bool CONCURRENT_HANDLES = OKI_CONCURRENT_HANDLES;
+
+/*
+ * Throws if the condition is false in checked builds; does nothing
+ * otherwise. Expensive conditions should be put behind
+ * "if constexpr (oki::intl_::CHECKED)" so they are never evaluated.
+ */
+inline void check(bool condition, const char* message)
+{
+    if constexpr (CHECKED) {
+        if (!condition) {
+            throw std::logic_error(message);
+        }
+    }
+}
+}
+}
+
+#endif // OKI_CONFIG_H
@@ -3,6 +3,7 @@
 
 #include "oki/oki_component.h"
 #include "oki/oki_observer.h"
+#include "oki/oki_resource.h"
 #include "oki/oki_system.h"
 
 #include <type_traits>
@@ -10,7 +11,8 @@
 namespace oki {
 class Engine : public oki::ComponentManager,
                public oki::SignalManager,
-               public oki::SystemManager
+               public oki::SystemManager,
+               public oki::ResourceManager
 { };
 
 template <typename ChildClass = void>
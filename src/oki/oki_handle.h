@@ -1,15 +1,22 @@
 #ifndef OKI_HANDLE_H
 #define OKI_HANDLE_H
 
+#include "oki/oki_config.h"
+
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 namespace oki {
 /*
  * The handle "type" used throughout the library as a key.
  * It is lightweight (one integer right now) but purposely opaque
  * and should not be assumed to be an integral or consistent type.
+ *
+ * Its width is chosen with OKI_HANDLE_BITS (see oki_config.h).
  */
-using Handle = std::uint64_t;
+using Handle = std::conditional_t<OKI_HANDLE_BITS == 32, std::uint32_t,
+    std::uint64_t>;
 
 namespace intl_ {
 /*
@@ -54,6 +61,18 @@ constexpr HandleType advance(HandleType& handle) noexcept
 {
     return handle++;
 }
+
+/*
+ * Equivalent to calling oki::advance() <n> times.
+ */
+template <typename HandleType = oki::Handle>
+constexpr HandleType advance(HandleType& handle, std::size_t n) noexcept
+{
+    auto old = handle;
+    handle += static_cast<HandleType>(n);
+
+    return old;
+}
 }
 }
 
@@ -0,0 +1,83 @@
+#ifndef OKI_INDEX_H
+#define OKI_INDEX_H
+
+#include "oki/util/oki_field_index.h"
+
+#include <type_traits>
+
+namespace oki {
+/*
+ * An index on a field of a component type for equality lookups in O(1)
+ * (see IndexedBy). The field needs operator== and a std::hash
+ * specialization.
+ */
+template <auto MEMBER>
+struct HashIndex
+{
+    static constexpr auto member = MEMBER;
+    static constexpr bool ORDERED = false;
+
+    template <typename Key>
+    using Store = oki::intl_::HashFieldIndex<Key, MEMBER>;
+};
+
+/*
+ * An index on a field of a component type for range (and equality)
+ * lookups in O(log n + k) (see IndexedBy). The field needs operator<.
+ */
+template <auto MEMBER>
+struct OrderedIndex
+{
+    static constexpr auto member = MEMBER;
+    static constexpr bool ORDERED = true;
+
+    template <typename Key>
+    using Store = oki::intl_::OrderedFieldIndex<Key, MEMBER>;
+};
+
+// A list of HashIndex and OrderedIndex, see IndexedBy
+template <typename... IndexTypes>
+struct Indexes
+{
+    using List = Indexes;
+};
+
+/*
+ * Declares indexes on the fields of a component type, which the
+ * ComponentManager keeps up to date as components are bound, assigned and
+ * removed, so that entities can be looked up by field value rather than
+ * by scanning:
+ *
+ *     struct NetId { std::uint32_t id; };
+ *     struct Team { int number; float morale; };
+ *
+ *     namespace oki {
+ *     template <>
+ *     struct IndexedBy<NetId> : Indexes<HashIndex<&NetId::id>> { };
+ *
+ *     template <>
+ *     struct IndexedBy<Team> : Indexes<OrderedIndex<&Team::number>> { };
+ *     }
+ *
+ *     auto owner = compMan.find_by<&NetId::id>(42);
+ *     compMan.find_all_by<&Team::number>(3, std::back_inserter(team));
+ *
+ * Components of such a type are handed out as const Type& (and const
+ * Type*), since changing one in place would go unnoticed by its indexes;
+ * bind_or_assign_component() changes one. It is best to keep indexed
+ * fields in small components of their own.
+ */
+template <typename Type>
+struct IndexedBy : Indexes<>
+{ };
+
+namespace intl_ {
+template <typename Type>
+struct IsIndexed
+    : std::bool_constant<!std::is_same_v<typename oki::IndexedBy<Type>::List,
+          oki::Indexes<>>>
+{ };
+}
+}
+
+#endif // OKI_INDEX_H
@@ -2,13 +2,15 @@
 #define OKI_OBSERVER_H
 
 #include "oki/oki_handle.h"
+#include "oki/util/oki_container.h"
+#include "oki/util/oki_flat_map.h"
 #include "oki/util/oki_handle_gen.h"
 #include "oki/util/oki_type_erasure.h"
 
 #include <algorithm>
-#include <map>
+#include <cstddef>
+#include <memory>
 #include <type_traits>
-#include <unordered_map>
 
 namespace oki {
 /*
@@ -81,7 +83,7 @@ public:
     oki::Handle connect(Observer<Subject>& observer)
     {
         auto handle = handGen_.create_handle();
-        observers_.insert({ handle, std::addressof(observer) });
+        observers_.insert(handle, std::addressof(observer));
 
         return handle;
     }
@@ -111,22 +113,32 @@ public:
      */
     void send(Subject data)
     {
-        auto iter = observers_.begin();
+        for (std::size_t i = 0; i < observers_.size();) {
+            auto iter = observers_.begin() + i;
+            auto handle = iter->first;
 
-        while (iter != observers_.end()) {
             oki::ObserverOptions options;
             iter->second->observe(data, options);
 
-            if (options.disconn_) {
-                iter = observers_.erase(iter);
-            } else {
-                ++iter;
+            // Observers can (dis)connect others from observe(), which moves
+            // ours around in the vector, so find it again if necessary
+            iter = observers_.begin() + std::min(i, observers_.size());
+            if (iter == observers_.end() || iter->first != handle) {
+                iter = observers_.lower_bound(handle);
             }
+
+            if (iter != observers_.end() && iter->first == handle) {
+                iter = options.disconn_ ? observers_.erase(iter) : iter + 1;
+            }
+
+            i = static_cast<std::size_t>(iter - observers_.begin());
         }
     }
 
 private:
-    std::map<oki::Handle, Observer<Subject>*> observers_;
+    // Handles only ever increase, so connecting is an append and observers
+    // are notified in the order they connected
+    oki::intl_::AssocSortedVector<oki::Handle, Observer<Subject>*> observers_;
 
     oki::intl_::DefaultHandleGenerator<oki::Handle> handGen_;
 };
@@ -185,12 +197,11 @@ public:
 
         // If we don't have it, make one
         if (pipeIter == data_.end()) {
-            pipeIter = data_.emplace(type, this->create_erased_pipe_<Subject>())
-                           .first;
+            pipeIter = data_.emplace(type, Pipe<Subject> {}).first;
         }
 
         // Then connect our observer
-        auto& pipe = pipeIter->second.pipe_.template get_as<Pipe<Subject>>();
+        auto& pipe = pipeIter->second.template get_as<Pipe<Subject>>();
         return { pipe.connect(observer), type };
     }
 
@@ -202,7 +213,7 @@ public:
         auto pipeIter = data_.find(handle.type_);
 
         if (pipeIter != data_.end()) {
-            (*pipeIter->second.disconnect_)(pipeIter->second.pipe_, handle);
+            pipeIter->second.invoke(&PipeOps::disconnect, handle.handle_);
         }
     }
 
@@ -235,15 +246,23 @@ private:
     template <typename Subject>
     using Pipe = oki::SubjectPipe<std::decay_t<Subject>>;
 
-    using ErasedPipe = oki::intl_::OptimalErasedType<Pipe<void*>>;
-
-    struct ErasedPipeData
+    // Lets disconnect() reach a pipe knowing only its type index
+    struct PipeOps
     {
-        ErasedPipe pipe_;
-        void (*disconnect_)(ErasedPipe&, ObserverHandle);
+        void (*disconnect)(void*, oki::Handle);
+
+        template <typename PipeType>
+        static constexpr PipeOps create() noexcept
+        {
+            return { [](void* pipe, oki::Handle handle) {
+                oki::intl_::erased_cast<PipeType>(pipe)->disconnect(handle);
+            } };
+        }
     };
 
-    std::unordered_map<oki::intl_::TypeIndex, ErasedPipeData> data_;
+    using ErasedPipe = oki::intl_::OptimalErasedType<Pipe<void*>, PipeOps>;
+
+    oki::intl_::FlatHashMap<oki::intl_::TypeIndex, ErasedPipe> data_;
 
     template <typename Subject, typename Callback>
     void call_on_pipe_checked_(Callback func)
@@ -251,23 +270,9 @@ private:
         auto pipeIter = data_.find(oki::intl_::get_type<Subject>());
 
         if (pipeIter != data_.end()) {
-            func(pipeIter->second.pipe_.template get_as<Pipe<Subject>>());
+            func(pipeIter->second.template get_as<Pipe<Subject>>());
         }
     }
-
-    template <typename Subject>
-    static void disconn_type_erased_(
-        ErasedPipe& pipe, oki::ObserverHandle handle)
-    {
-        pipe.template get_as<Pipe<Subject>>().disconnect(handle.handle_);
-    }
-
-    template <typename Subject>
-    static ErasedPipeData create_erased_pipe_()
-    {
-        return ErasedPipeData { Pipe<Subject> {},
-            &disconn_type_erased_<Subject> };
-    }
 };
 }
 
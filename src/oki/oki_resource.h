@@ -0,0 +1,252 @@
+#ifndef OKI_RESOURCE_H
+#define OKI_RESOURCE_H
+
+#include "oki/oki_config.h"
+#include "oki/util/oki_type_erasure.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+struct ResourceFamily;
+
+// Numbers resource types densely, so that they can index an array
+template <typename Type>
+std::size_t get_resource_id() noexcept
+{
+    return oki::intl_::get_sequential_id<ResourceFamily, std::decay_t<Type>>();
+}
+}
+
+/*
+ * Class responsible for storing resources: global state (e.g. input,
+ * timers, configuration) of which there is exactly one instance per type,
+ * unattached to any entity.
+ *
+ * Every resource type is numbered the first time it is used, and the
+ * resources live in an array indexed by that number, so resource() is a
+ * couple of loads rather than a hash lookup and a binary search (as a
+ * component on a dummy entity would be).
+ */
+class ResourceManager
+{
+public:
+    /*
+     * Constructs a resource of type Type from <args>, replacing any
+     * existing one, and returns it.
+     *
+     * The resource stays at the same address until it is replaced or
+     * removed.
+     */
+    template <typename Type, typename... Args>
+    std::decay_t<Type>& emplace_resource(Args&&... args)
+    {
+        using Stored = std::decay_t<Type>;
+
+        auto id = id_<Type>();
+        if (id >= slots_.size()) {
+            slots_.resize(id + 1);
+        }
+
+        // Aggregates (like most configuration structs) need braces
+        Stored* resource = nullptr;
+        if constexpr (std::is_constructible_v<Stored, Args...>) {
+            resource = new Stored(std::forward<Args>(args)...);
+        } else {
+            resource = new Stored { std::forward<Args>(args)... };
+        }
+
+        slots_[id] = Slot(resource, Deleter { &destroy_<Stored> });
+
+        return *resource;
+    }
+
+    /*
+     * Retrieves the resource of type Type, assuming (without checking, in
+     * unchecked builds) that one exists.
+     */
+    template <typename Type>
+    std::decay_t<Type>& resource()
+    {
+        return const_cast<std::decay_t<Type>&>(
+            std::as_const(*this).template resource<Type>());
+    }
+
+    template <typename Type>
+    const std::decay_t<Type>& resource() const
+    {
+        auto id = id_<Type>();
+
+        if constexpr (oki::intl_::CHECKED) {
+            oki::intl_::check(id < slots_.size() && slots_[id],
+                "No resource of this type exists");
+        }
+
+        return *static_cast<const std::decay_t<Type>*>(slots_[id].get());
+    }
+
+    /*
+     * If there is a resource of type Type, returns a pointer thereto;
+     * otherwise, returns nullptr.
+     */
+    template <typename Type>
+    std::decay_t<Type>* try_resource() noexcept
+    {
+        auto id = id_<Type>();
+
+        return (id < slots_.size())
+            ? static_cast<std::decay_t<Type>*>(slots_[id].get())
+            : nullptr;
+    }
+
+    template <typename Type>
+    bool has_resource() const noexcept
+    {
+        auto id = id_<Type>();
+        return id < slots_.size() && slots_[id];
+    }
+
+    /*
+     * Destroys the resource of type Type. Returns whether there was one.
+     */
+    template <typename Type>
+    bool remove_resource()
+    {
+        if (!this->has_resource<Type>()) {
+            return false;
+        }
+
+        slots_[id_<Type>()].reset();
+        return true;
+    }
+
+private:
+    struct Deleter
+    {
+        void (*destroy_)(void*) = nullptr;
+
+        void operator()(void* resource) const { destroy_(resource); }
+    };
+
+    using Slot = std::unique_ptr<void, Deleter>;
+
+    // Indexed by resource number (see oki::intl_::get_resource_id())
+    std::vector<Slot> slots_;
+
+    template <typename Type>
+    static std::size_t id_() noexcept
+    {
+        return oki::intl_::get_resource_id<Type>();
+    }
+
+    template <typename Type>
+    static void destroy_(void* resource)
+    {
+        delete static_cast<Type*>(resource);
+    }
+};
+
+/*
+ * Describes which resources a piece of work (e.g. a system) reads and
+ * which it writes, so that a parallel scheduler can tell whether two such
+ * pieces may run at once:
+ *
+ *     auto physics = oki::ResourceAccess().reads<Config>().writes<Timer>();
+ *     auto render = oki::ResourceAccess().reads<Config, Camera>();
+ *
+ *     physics.conflicts_with(render); // false: both only read Config
+ *
+ * Writing a resource implies reading it.
+ */
+class ResourceAccess
+{
+public:
+    template <typename... Types>
+    ResourceAccess& reads()
+    {
+        (insert_(reads_, id_<Types>()), ...);
+        return *this;
+    }
+
+    template <typename... Types>
+    ResourceAccess& writes()
+    {
+        (insert_(writes_, id_<Types>()), ...);
+        return *this;
+    }
+
+    template <typename Type>
+    bool will_read() const noexcept
+    {
+        return contains_(reads_, id_<Type>()) || this->will_write<Type>();
+    }
+
+    template <typename Type>
+    bool will_write() const noexcept
+    {
+        return contains_(writes_, id_<Type>());
+    }
+
+    /*
+     * Returns whether one of the two writes a resource that the other
+     * reads or writes (that is, whether they must not run at once).
+     */
+    bool conflicts_with(const ResourceAccess& that) const noexcept
+    {
+        return intersect_(writes_, that.writes_)
+            || intersect_(writes_, that.reads_)
+            || intersect_(reads_, that.writes_);
+    }
+
+private:
+    // Both sorted, by resource number
+    std::vector<std::size_t> reads_;
+    std::vector<std::size_t> writes_;
+
+    template <typename Type>
+    static std::size_t id_() noexcept
+    {
+        return oki::intl_::get_resource_id<Type>();
+    }
+
+    static void insert_(std::vector<std::size_t>& ids, std::size_t id)
+    {
+        auto iter = std::lower_bound(ids.begin(), ids.end(), id);
+        if (iter == ids.end() || *iter != id) {
+            ids.insert(iter, id);
+        }
+    }
+
+    static bool contains_(
+        const std::vector<std::size_t>& ids, std::size_t id) noexcept
+    {
+        return std::binary_search(ids.begin(), ids.end(), id);
+    }
+
+    static bool intersect_(const std::vector<std::size_t>& lhs,
+        const std::vector<std::size_t>& rhs) noexcept
+    {
+        auto lIter = lhs.begin();
+        auto rIter = rhs.begin();
+
+        while (lIter != lhs.end() && rIter != rhs.end()) {
+            if (*lIter < *rIter) {
+                ++lIter;
+            } else if (*rIter < *lIter) {
+                ++rIter;
+            } else {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+}
+
+#endif // OKI_RESOURCE_H
@@ -0,0 +1,215 @@
+#ifndef OKI_SCRATCH_H
+#define OKI_SCRATCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace oki {
+/*
+ * A monotonic ("bump") allocator for temporary memory: allocating moves a
+ * pointer forward, freeing does nothing (except for the latest allocation,
+ * which is given back) and reset() makes all of it available again at once.
+ *
+ * Once the arena has grown to fit the largest batch of allocations made
+ * between resets, it stops allocating from the heap altogether.
+ */
+class ScratchArena
+{
+public:
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    ScratchArena() = default;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /*
+     * Returns <size> bytes aligned to <align> (a power of two), which stay
+     * valid until the next reset().
+     */
+    void* allocate(std::size_t size, std::size_t align)
+    {
+        if (!blocks_.empty()) {
+            if (void* ptr = this->bump_(size, align)) {
+                return ptr;
+            }
+        }
+
+        // Either move on to the next (already allocated) block or make one
+        // big enough, keeping any blocks after it for later
+        if (current_ + 1 < blocks_.size()
+            && blocks_[current_ + 1].size_ >= size + align) {
+            ++current_;
+        } else {
+            auto lastSize = blocks_.empty() ? 0 : blocks_[current_].size_;
+            auto blockSize
+                = std::max({ BLOCK_SIZE, lastSize * 2, size + align });
+
+            auto insertAt = blocks_.empty() ? 0 : current_ + 1;
+            blocks_.insert(blocks_.begin() + insertAt, Block(blockSize));
+            current_ = insertAt;
+        }
+
+        offset_ = 0;
+        return this->bump_(size, align);
+    }
+
+    /*
+     * Gives the memory back if it is the latest allocation (e.g. a vector
+     * that grew then shrank) and otherwise does nothing.
+     */
+    void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        if (blocks_.empty()) {
+            return;
+        }
+
+        auto* top = blocks_[current_].data_.get() + offset_;
+        if (static_cast<std::byte*>(ptr) + size == top) {
+            offset_ -= size;
+        }
+    }
+
+    /*
+     * Makes all memory available again, invalidating everything allocated
+     * since the last reset(). If that took several blocks, they are
+     * replaced by a single one that fits all of it.
+     */
+    void reset()
+    {
+        if (blocks_.size() > 1) {
+            auto total = this->capacity();
+
+            blocks_.clear();
+            blocks_.emplace_back(total);
+        }
+
+        current_ = 0;
+        offset_ = 0;
+    }
+
+    // Returns the number of bytes allocated for the arena (used or not)
+    std::size_t capacity() const noexcept
+    {
+        std::size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block.size_;
+        }
+
+        return total;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data_;
+        std::size_t size_;
+
+        explicit Block(std::size_t size)
+            : data_(new std::byte[size])
+            , size_(size)
+        {
+        }
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t current_ = 0;
+    std::size_t offset_ = 0;
+
+    void* bump_(std::size_t size, std::size_t align) noexcept
+    {
+        auto& block = blocks_[current_];
+        auto base = reinterpret_cast<std::uintptr_t>(block.data_.get());
+
+        auto aligned = (base + offset_ + align - 1) & ~(align - 1);
+        auto begin = static_cast<std::size_t>(aligned - base);
+
+        if (begin > block.size_ || block.size_ - begin < size) {
+            return nullptr;
+        }
+
+        offset_ = begin + size;
+        return block.data_.get() + begin;
+    }
+};
+
+/*
+ * Returns the calling thread's scratch arena. SystemManager resets it after
+ * every step (see SystemOptions::scratch()).
+ */
+inline ScratchArena& thread_scratch() noexcept
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+/*
+ * An allocator for standard containers that allocates from a ScratchArena,
+ * so that temporary containers cost a pointer bump rather than a trip to
+ * the heap:
+ *
+ *     oki::ScratchVector<oki::Entity> toDelete(opts.scratch());
+ *
+ * Such containers must be gone by the time the arena is reset.
+ */
+template <typename Type>
+class ScratchAllocator
+{
+public:
+    using value_type = Type;
+
+    ScratchAllocator(ScratchArena& arena) noexcept
+        : arena_(&arena)
+    {
+    }
+
+    template <typename OtherType>
+    ScratchAllocator(const ScratchAllocator<OtherType>& other) noexcept
+        : arena_(other.arena_)
+    {
+    }
+
+    Type* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(Type)) {
+            throw std::bad_array_new_length();
+        }
+
+        return static_cast<Type*>(
+            arena_->allocate(n * sizeof(Type), alignof(Type)));
+    }
+
+    void deallocate(Type* ptr, std::size_t n) noexcept
+    {
+        arena_->deallocate(ptr, n * sizeof(Type));
+    }
+
+    template <typename OtherType>
+    bool operator==(const ScratchAllocator<OtherType>& other) const noexcept
+    {
+        return arena_ == other.arena_;
+    }
+
+    template <typename OtherType>
+    bool operator!=(const ScratchAllocator<OtherType>& other) const noexcept
+    {
+        return arena_ != other.arena_;
+    }
+
+private:
+    ScratchArena* arena_;
+
+    template <typename OtherType>
+    friend class ScratchAllocator;
+};
+
+template <typename Type>
+using ScratchVector = std::vector<Type, oki::ScratchAllocator<Type>>;
+}
+
+#endif // OKI_SCRATCH_H
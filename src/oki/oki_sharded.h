@@ -0,0 +1,275 @@
+#ifndef OKI_SHARDED_H
+#define OKI_SHARDED_H
+
+#include "oki/oki_component.h"
+#include "oki/oki_config.h"
+#include "oki/oki_handle.h"
+#include "oki/util/oki_parallel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace oki {
+/*
+ * A ComponentManager split into shards, so that several threads can make
+ * structural changes (creating and destroying entities, adding and
+ * removing components) at once, as long as each works on its own shard.
+ *
+ * Each shard is a ComponentManager with its own containers and handles.
+ * The shard is encoded in the top bits of the handles it issues, so
+ * every entity is unique across shards and knows which shard owns it.
+ * Entities must be created and changed through their shard, which
+ * shard() and shard_of() return:
+ *
+ *     oki::intl_::parallel_for_chunks(n, sharded.num_shards(),
+ *         [&](std::size_t idx, std::size_t begin, std::size_t end) {
+ *             auto shard = sharded.shard(idx);
+ *             for (auto i = begin; i != end; ++i) {
+ *                 shard.bind_component(shard.create_entity(), Position {});
+ *             }
+ *         });
+ *
+ * Queries visit every shard, one after another or (with the _parallel
+ * variants) one shard per thread.
+ */
+class ShardedComponentManager
+{
+    using HandleType = oki::Entity::HandleType;
+
+    static_assert(sizeof(HandleType) == sizeof(std::uint64_t),
+        "Sharding requires 64-bit handles (see oki_config.h)");
+
+    static constexpr unsigned SHARD_BITS = 8;
+    static constexpr unsigned SHARD_SHIFT = sizeof(HandleType) * 8 - SHARD_BITS;
+    static constexpr HandleType LOCAL_MASK
+        = (HandleType { 1 } << SHARD_SHIFT) - 1;
+
+public:
+    static constexpr std::size_t MAX_SHARDS = std::size_t { 1 } << SHARD_BITS;
+
+    /*
+     * One shard of a ShardedComponentManager, which takes and returns the
+     * manager's entities (rather than the underlying ComponentManager's
+     * own). Its functions mirror ComponentManager's.
+     *
+     * It is only a reference: any number can be made, and they are cheap
+     * to copy.
+     */
+    class Shard
+    {
+    public:
+        oki::Entity create_entity()
+        {
+            return this->to_global_(manager_->create_entity());
+        }
+
+        bool destroy_entity(oki::Entity entity)
+        {
+            return manager_->destroy_entity(this->to_local_(entity));
+        }
+
+        template <typename Type, typename... Args>
+        decltype(auto) emplace_component(oki::Entity entity, Args&&... args)
+        {
+            return manager_->emplace_component<Type>(
+                this->to_local_(entity), std::forward<Args>(args)...);
+        }
+
+        template <typename InsertType>
+        decltype(auto) bind_component(oki::Entity entity, InsertType&& value)
+        {
+            return manager_->bind_component(
+                this->to_local_(entity), std::forward<InsertType>(value));
+        }
+
+        template <typename InsertType>
+        decltype(auto) bind_or_assign_component(
+            oki::Entity entity, InsertType&& value)
+        {
+            return manager_->bind_or_assign_component(
+                this->to_local_(entity), std::forward<InsertType>(value));
+        }
+
+        template <typename Type>
+        bool remove_component(oki::Entity entity)
+        {
+            return manager_->remove_component<Type>(this->to_local_(entity));
+        }
+
+        template <typename Type>
+        decltype(auto) get_component(oki::Entity entity)
+        {
+            return manager_->get_component<Type>(this->to_local_(entity));
+        }
+
+        template <typename Type>
+        decltype(auto) get_component_checked(oki::Entity entity)
+        {
+            return manager_->get_component_checked<Type>(
+                this->to_local_(entity));
+        }
+
+        template <typename Type>
+        bool has_component(oki::Entity entity) const
+        {
+            return manager_->has_component<Type>(this->to_local_(entity));
+        }
+
+        // Like ComponentManager::for_each(), over this shard only
+        template <typename... Types, typename Callback>
+        Callback for_each(Callback func)
+        {
+            manager_->for_each<Types...>(
+                [&](oki::Entity entity, auto&&... comps) {
+                    return func(this->to_global_(entity),
+                        std::forward<decltype(comps)>(comps)...);
+                });
+
+            return func;
+        }
+
+        std::size_t index() const noexcept { return idx_; }
+
+    private:
+        oki::ComponentManager* manager_;
+        std::size_t idx_;
+
+        Shard(oki::ComponentManager& manager, std::size_t idx) noexcept
+            : manager_(&manager)
+            , idx_(idx)
+        {
+        }
+
+        oki::Entity to_global_(oki::Entity entity) const noexcept
+        {
+            entity.handle_ |= static_cast<HandleType>(idx_) << SHARD_SHIFT;
+            return entity;
+        }
+
+        oki::Entity to_local_(oki::Entity entity) const
+        {
+            oki::intl_::check(shard_index_(entity) == idx_,
+                "Entity belongs to a different shard");
+
+            entity.handle_ &= LOCAL_MASK;
+            return entity;
+        }
+
+        friend class oki::ShardedComponentManager;
+    };
+
+    /*
+     * Creates <numShards> (at least 1, at most MAX_SHARDS) empty shards.
+     * There is no benefit to having more shards than threads working on
+     * them at once.
+     */
+    explicit ShardedComponentManager(std::size_t numShards)
+    {
+        if (numShards == 0 || numShards > MAX_SHARDS) {
+            throw std::invalid_argument("Invalid number of shards");
+        }
+
+        shards_.resize(numShards);
+    }
+
+    std::size_t num_shards() const noexcept { return shards_.size(); }
+
+    Shard shard(std::size_t idx)
+    {
+        oki::intl_::check(idx < shards_.size(), "Shard index out of range");
+        return Shard(shards_[idx], idx);
+    }
+
+    // The shard that owns <entity>
+    Shard shard_of(oki::Entity entity)
+    {
+        return this->shard(shard_index_(entity));
+    }
+
+    /*
+     * Calls func() like ComponentManager::for_each() would, for every
+     * matching entity of every shard (shard by shard). If func() returns
+     * a bool, returning false stops the iteration altogether.
+     */
+    template <typename... Types, typename Callback>
+    Callback for_each(Callback func)
+    {
+        bool stopped = false;
+
+        for (std::size_t idx = 0; idx != shards_.size() && !stopped; ++idx) {
+            this->shard(idx).for_each<Types...>(
+                [&](oki::Entity entity, auto&&... comps) {
+                    using Result = decltype(
+                        func(entity, std::forward<decltype(comps)>(comps)...));
+
+                    if constexpr (std::is_same_v<Result, bool>) {
+                        stopped = !func(entity,
+                            std::forward<decltype(comps)>(comps)...);
+                        return !stopped;
+                    } else {
+                        func(entity, std::forward<decltype(comps)>(comps)...);
+                    }
+                });
+        }
+
+        return func;
+    }
+
+    /*
+     * Like for_each(), but visits the shards on several threads at once
+     * (one shard per thread), so func() must be safe to call
+     * concurrently. Returning false from func() only stops the iteration
+     * over the current shard.
+     */
+    template <typename... Types, typename Callback>
+    void for_each_parallel(const Callback& func)
+    {
+        auto numWorkers = oki::intl_::choose_num_workers(shards_.size(), 1);
+
+        oki::intl_::parallel_for_chunks(shards_.size(), numWorkers,
+            [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (auto idx = begin; idx != end; ++idx) {
+                    this->shard(idx).for_each<Types...>(func);
+                }
+            });
+    }
+
+    // Counts the entities with all of Types... across every shard
+    template <typename... Types>
+    std::size_t count() const
+    {
+        std::size_t total = 0;
+        for (const auto& manager : shards_) {
+            total += manager.count<Types...>();
+        }
+
+        return total;
+    }
+
+    // The number of components of type Type across every shard
+    template <typename Type>
+    std::size_t num_components() const
+    {
+        std::size_t total = 0;
+        for (const auto& manager : shards_) {
+            total += manager.num_components<Type>();
+        }
+
+        return total;
+    }
+
+private:
+    std::vector<oki::ComponentManager> shards_;
+
+    static std::size_t shard_index_(oki::Entity entity) noexcept
+    {
+        return static_cast<std::size_t>(entity.handle_ >> SHARD_SHIFT);
+    }
+};
+}
+
+#endif // OKI_SHARDED_H
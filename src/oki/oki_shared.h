@@ -0,0 +1,34 @@
+#ifndef OKI_SHARED_H
+#define OKI_SHARED_H
+
+#include <type_traits>
+
+namespace oki {
+/*
+ * Opts a component type into being stored shared ("flyweight"): each
+ * distinct value is stored once, and entities refer to it by index.
+ * Suited to components that many entities have identical copies of (e.g.
+ * materials, colors, configuration):
+ *
+ *     struct Material { int texture; float shininess; };
+ *
+ *     namespace oki {
+ *     template <>
+ *     struct StoreShared<Material> : std::true_type { };
+ *     }
+ *
+ * The type needs operator== and a std::hash specialization, which is how
+ * equal values are found. Values are reference counted and dropped when
+ * no entity refers to them anymore.
+ *
+ * Components of such a type are handed out as const Type& (and const
+ * Type*), since changing one in place would change every entity sharing
+ * it; bind_or_assign_component() gives a single entity another value.
+ * ComponentManager::for_each_group() visits the entities grouped by value.
+ */
+template <typename Type>
+struct StoreShared : std::false_type
+{ };
+}
+
+#endif // OKI_SHARED_H
@@ -0,0 +1,186 @@
+#ifndef OKI_SPLIT_H
+#define OKI_SPLIT_H
+
+#include "oki/oki_blob.h"
+#include "oki/oki_buffered.h"
+#include "oki/oki_columns.h"
+#include "oki/oki_index.h"
+#include "oki/oki_shared.h"
+
+#include <optional>
+#include <type_traits>
+
+namespace oki {
+/*
+ * Declares a component made of a "hot" part, which is used all the time
+ * (e.g. a position), and a "cold" one, which rarely is (e.g. a debug name).
+ * Either use it directly or derive from it:
+ *
+ *     struct Unit : oki::Split<UnitState, UnitInfo> { };
+ *
+ * The ComponentManager stores the two parts in separate columns, so that
+ * iterating over the hot part never drags the cold bytes through the
+ * cache. The parts can be iterated over (and looked up) individually as
+ * oki::Hot<Unit> and oki::Cold<Unit>, while binding, removing and
+ * get_component() deal with the whole logical component.
+ */
+template <typename HotType, typename ColdType>
+struct Split
+{
+    using Hot = HotType;
+    using Cold = ColdType;
+
+    HotType hot;
+    ColdType cold;
+};
+
+// Names the hot column of a split component, e.g. for_each<oki::Hot<Unit>>
+template <typename SplitType>
+struct Hot
+{ };
+
+// Names the cold column of a split component
+template <typename SplitType>
+struct Cold
+{ };
+
+/*
+ * What get_component() returns for a split component: references to both
+ * parts, accessed the same way as the component's own members.
+ */
+template <typename SplitType>
+struct SplitRef
+{
+    typename SplitType::Hot& hot;
+    typename SplitType::Cold& cold;
+
+    // Copies the logical component back out
+    operator SplitType() const
+    {
+        using Base = oki::Split<typename SplitType::Hot,
+            typename SplitType::Cold>;
+
+        if constexpr (std::is_same_v<SplitType, Base>) {
+            return SplitType { hot, cold };
+        } else {
+            return SplitType { Base { hot, cold } };
+        }
+    }
+};
+
+namespace intl_ {
+template <typename Type, typename = void>
+struct IsSplit : std::false_type
+{ };
+
+template <typename Type>
+struct IsSplit<Type, std::void_t<typename Type::Hot, typename Type::Cold>>
+    : std::is_base_of<oki::Split<typename Type::Hot, typename Type::Cold>,
+          Type>
+{ };
+
+/*
+ * How a component type is stored (Stored), handed back by reference (Ref)
+ * and by pointer (Ptr). Split components themselves are never stored;
+ * their columns are. Column-stored components (see oki_columns.h) are
+ * referred to through proxies, as are blobs (see oki_blob.h), and shared
+ * (see oki_shared.h) and indexed (see oki_index.h) ones are read-only.
+ */
+template <typename Type, bool SPLIT = IsSplit<Type>::value,
+    bool COLUMNS = oki::StoreAsColumns<Type>::value,
+    bool SHARED = oki::StoreShared<Type>::value>
+struct ComponentTraits
+{
+    static constexpr bool INDEXED = IsIndexed<Type>::value;
+
+    static_assert(!INDEXED || !oki::StoreBuffered<Type>::value,
+        "Indexed components cannot be buffered");
+
+    using Stored = Type;
+    using Ref = std::conditional_t<INDEXED, const Type&, Type&>;
+    using Ptr = std::conditional_t<INDEXED, const Type*, Type*>;
+};
+
+template <typename Type, bool SHARED>
+struct ComponentTraits<Type, false, true, SHARED>
+{
+    static_assert(!SHARED, "Shared components cannot be stored as columns");
+    static_assert(!IsIndexed<Type>::value,
+        "Indexed components cannot be stored as columns");
+    static_assert(!oki::StoreBuffered<Type>::value,
+        "Buffered components cannot be stored as columns");
+
+    using Stored = Type;
+    using Ref = oki::ColumnRef<Type>;
+    using Ptr = std::optional<oki::ColumnRef<Type>>;
+};
+
+template <typename Type>
+struct ComponentTraits<Type, false, false, true>
+{
+    static_assert(!IsIndexed<Type>::value,
+        "Indexed components cannot be stored shared");
+    static_assert(!oki::StoreBuffered<Type>::value,
+        "Buffered components cannot be stored shared");
+
+    using Stored = Type;
+    using Ref = const Type&;
+    using Ptr = const Type*;
+};
+
+template <typename Element, typename Tag>
+struct ComponentTraits<oki::Blob<Element, Tag>, false, false, false>
+{
+    static_assert(!oki::StoreBuffered<oki::Blob<Element, Tag>>::value,
+        "Blob components cannot be buffered");
+
+    using Stored = oki::Blob<Element, Tag>;
+    using Ref = oki::BlobRef<Stored>;
+    using Ptr = std::optional<oki::BlobRef<Stored>>;
+};
+
+template <typename Type, bool COLUMNS, bool SHARED>
+struct ComponentTraits<Type, true, COLUMNS, SHARED>
+{
+    static_assert(!COLUMNS, "Split components cannot be stored as columns");
+    static_assert(!SHARED, "Split components cannot be stored shared");
+    static_assert(
+        !IsIndexed<Type>::value, "Split components cannot be indexed");
+    static_assert(!oki::StoreBuffered<Type>::value,
+        "Split components cannot be buffered");
+
+    using Stored = Type;
+    using Ref = oki::SplitRef<Type>;
+    using Ptr = Type*;
+};
+
+template <typename Type>
+struct SplitPartTraits
+{
+    static_assert(!oki::StoreAsColumns<Type>::value,
+        "The parts of split components cannot be stored as columns");
+    static_assert(!oki::StoreShared<Type>::value,
+        "The parts of split components cannot be stored shared");
+    static_assert(!IsIndexed<Type>::value,
+        "The parts of split components cannot be indexed");
+    static_assert(!oki::StoreBuffered<Type>::value,
+        "The parts of split components cannot be buffered");
+
+    using Stored = Type;
+    using Ref = Type&;
+    using Ptr = Type*;
+};
+
+template <typename SplitType>
+struct ComponentTraits<oki::Hot<SplitType>, false, false, false>
+    : SplitPartTraits<typename SplitType::Hot>
+{ };
+
+template <typename SplitType>
+struct ComponentTraits<oki::Cold<SplitType>, false, false, false>
+    : SplitPartTraits<typename SplitType::Cold>
+{ };
+}
+}
+
+#endif // OKI_SPLIT_H
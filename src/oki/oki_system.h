@@ -2,19 +2,45 @@
 #define OKI_SYSTEM_H
 
 #include "oki/oki_handle.h"
+#include "oki/oki_scratch.h"
+#include "oki/util/oki_flat_map.h"
 #include "oki/util/oki_handle_gen.h"
+#include "oki/util/oki_parallel.h"
 #include "oki/util/oki_type_erasure.h"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <exception>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace oki {
 using SystemPriority = std::uint16_t;
 
+/*
+ * The stages of a frame, which run in this order. By default, every system
+ * simulates; splitting the rest out only matters to
+ * SystemManager::run_pipelined(), which overlaps presenting one frame with
+ * simulating the next:
+ *   - SIMULATE: update the world (e.g. physics, game logic)
+ *   - EXTRACT: copy what presenting needs out of the world (e.g. with
+ *       ComponentManager::publish_components()), while nothing else runs
+ *   - PRESENT: show the extracted copy (e.g. draw, swap buffers), without
+ *       touching the world, since the next frame is being simulated
+ */
+enum class SystemStage : std::uint8_t
+{
+    SIMULATE,
+    EXTRACT,
+    PRESENT
+};
+
 class SystemOptions;
 class SystemManager;
 
@@ -78,6 +104,17 @@ public:
 
     void remove_me() noexcept { shouldRemove_ = true; }
 
+    /*
+     * Returns the calling thread's scratch arena, for temporary memory that
+     * is only needed during this step (e.g. through oki::ScratchVector).
+     * The SystemManager resets it once the step (or, when pipelined, the
+     * frame) is over.
+     */
+    oki::ScratchArena& scratch() const noexcept
+    {
+        return oki::thread_scratch();
+    }
+
 private:
     int exitCode_;
 
@@ -131,20 +168,8 @@ public:
     oki::Handle add_priority_system(
         oki::SystemPriority priority, SystemType& system)
     {
-        static_assert(std::is_base_of_v<oki::System, SystemType>);
-
-        SystemData sysData;
-        sysData.system_ = std::addressof(system);
-        sysData.handle_ = handleGen_.create_handle();
-        sysData.priority_ = priority;
-
-        // We want to insert this system after higher-priority sytems
-        // and, if they match priorities, after its peers
-        auto sysIter = std::find_if(systems_.begin(), systems_.end(),
-            [=](const auto& elem) { return elem.priority_ < priority; });
-
-        systems_.insert(sysIter, sysData);
-        return sysData.handle_;
+        return this->add_staged_system(
+            oki::SystemStage::SIMULATE, system, priority);
     }
 
     /*
@@ -156,6 +181,36 @@ public:
         return this->add_priority_system<SystemType>(0, system);
     }
 
+    /*
+     * Adds a system to the given stage (see oki::SystemStage), which
+     * otherwise behaves like add_priority_system(): priority orders the
+     * systems within a stage.
+     */
+    template <typename SystemType>
+    oki::Handle add_staged_system(oki::SystemStage stage, SystemType& system,
+        oki::SystemPriority priority = 0)
+    {
+        static_assert(std::is_base_of_v<oki::System, SystemType>);
+
+        SystemData sysData;
+        sysData.system_ = std::addressof(system);
+        sysData.priority_ = priority;
+
+        if (pendingLock_) {
+            std::lock_guard lock { *pendingLock_ };
+
+            sysData.handle_ = handleGen_.create_handle();
+            pending_.push_back({ sysData, stage });
+
+            return sysData.handle_;
+        }
+
+        sysData.handle_ = handleGen_.create_handle();
+        this->insert_system_(stage, sysData);
+
+        return sysData.handle_;
+    }
+
     /*
      * Removes a system given its handle.
      *
@@ -163,12 +218,27 @@ public:
      */
     bool remove_system(oki::Handle handle)
     {
-        auto sysIter = this->seek_handle_(handle);
+        if (pendingLock_) {
+            std::lock_guard lock { *pendingLock_ };
 
-        if (sysIter != systems_.end()) {
+            if (!this->seek_pending_(handle)) {
+                return false;
+            }
+
+            SystemData removal {};
+            removal.handle_ = handle;
+            pending_.push_back({ removal, oki::SystemStage::SIMULATE });
+
+            return true;
+        }
+
+        auto* sysData = this->seek_handle_(handle);
+
+        if (sysData) {
             // Does not hard erase (could be occuring during iteration)
-            sysIter->handle_ = oki::intl_::get_invalid_handle_constant();
-            sysIter->system_ = nullptr;
+            handleIndex_.erase(handle);
+            sysData->handle_ = oki::intl_::get_invalid_handle_constant();
+            sysData->system_ = nullptr;
 
             return true;
         }
@@ -184,48 +254,38 @@ public:
      */
     oki::System* get_system(oki::Handle handle)
     {
-        auto sysIter = this->seek_handle_(handle);
-        return (sysIter != systems_.end()) ? sysIter->system_ : nullptr;
+        if (pendingLock_) {
+            std::lock_guard lock { *pendingLock_ };
+            return this->seek_pending_(handle);
+        }
+
+        auto* sysData = this->seek_handle_(handle);
+        return sysData ? sysData->system_ : nullptr;
     }
 
     /*
      * Runs a single step, calling the step() function of each associated
-     * system exactly once. Respects priority.
+     * system exactly once, stage by stage (see oki::SystemStage). Respects
+     * priority within each stage.
      *
      * Returns two values indicating whether one of the systems has
      * requested to exit and with which code.
      */
     std::pair<bool, int> step()
     {
-        for (auto sysIter = systems_.begin(); sysIter != systems_.end();) {
-            // If this system was removed in the last pass,
-            // hard erase it
-            if (!sysIter->system_) {
-                sysIter = systems_.erase(sysIter);
-                continue;
-            }
-
-            oki::SystemOptions options;
-            sysIter->system_->step(*this, options);
+        std::pair<bool, int> exitPair { false, 0 };
 
-            if (options.will_remove()) {
-                sysIter = systems_.erase(sysIter);
-                continue;
-            }
+        for (auto stage : { oki::SystemStage::SIMULATE,
+                 oki::SystemStage::EXTRACT, oki::SystemStage::PRESENT }) {
+            exitPair = this->step_stage_(stage);
 
-            if (options.will_skip()) {
-                break;
-            }
-
-            auto exitPair = options.exit_info();
             if (exitPair.first) {
-                return exitPair;
+                break;
             }
-
-            ++sysIter;
         }
 
-        return { false, 0 };
+        oki::thread_scratch().reset();
+        return exitPair;
     }
 
     /*
@@ -235,7 +295,7 @@ public:
     int run()
     {
         // If all systems have been removed, exit
-        while (!systems_.empty()) {
+        while (!this->empty_()) {
             auto [exit, code] = this->step();
 
             if (exit) {
@@ -246,6 +306,89 @@ public:
         return 0;
     }
 
+    /*
+     * Like run(), but presents each frame while the next one is being
+     * simulated: after frame N is extracted, the PRESENT stage of frame N
+     * runs on the calling thread (which is where windowing and graphics
+     * usually have to be) while the SIMULATE stage of frame N + 1 runs on
+     * another thread (the same one every frame). The EXTRACT stage runs
+     * alone, in between.
+     *
+     * So when both take a while, a frame takes about as long as the slower
+     * of the two rather than their sum. In exchange:
+     *   - PRESENT systems must only read what was extracted for them
+     *   - Systems added or removed (including through SystemOptions) while
+     *       the two stages overlap only join or leave once both are done
+     *   - A system that asks to exit stops the loop once both stages are
+     *       done with their frames
+     */
+    int run_pipelined()
+    {
+        // The first frame has nothing before it to present
+        for (auto stage :
+            { oki::SystemStage::SIMULATE, oki::SystemStage::EXTRACT }) {
+            if (auto [exit, code] = this->step_stage_(stage); exit) {
+                return code;
+            }
+        }
+
+        // One thread simulates every frame, so that its scratch arena (like
+        // the calling thread's) stops growing once it is big enough
+        std::pair<bool, int> simulatedExit;
+        oki::intl_::Worker simulator([this, &simulatedExit]() {
+            simulatedExit = this->step_stage_(oki::SystemStage::SIMULATE);
+            oki::thread_scratch().reset();
+        });
+
+        while (!this->empty_()) {
+            oki::thread_scratch().reset();
+
+            // Neither stage may change the systems while the other runs
+            std::mutex pendingLock;
+            pendingLock_ = &pendingLock;
+
+            simulator.run();
+
+            // Both stages finish (and their changes apply) before anything
+            // either threw is rethrown, the presented frame's first
+            std::exception_ptr error;
+            std::pair<bool, int> presented;
+
+            try {
+                presented = this->step_stage_(oki::SystemStage::PRESENT);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            try {
+                simulator.wait();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+
+            this->apply_pending_();
+            if (error) {
+                std::rethrow_exception(error);
+            }
+
+            // The presented frame is the older one, so its exit goes first
+            for (auto exitPair : { presented, simulatedExit }) {
+                if (exitPair.first) {
+                    return exitPair.second;
+                }
+            }
+
+            auto extracted = this->step_stage_(oki::SystemStage::EXTRACT);
+            if (extracted.first) {
+                return extracted.second;
+            }
+        }
+
+        return 0;
+    }
+
 private:
     struct SystemData
     {
@@ -254,20 +397,133 @@ private:
         oki::SystemPriority priority_;
     };
 
+    using SystemList = std::list<SystemData>;
+
     // This choice of data structure makes the implementation easier and
     // its cache misses should be acceptable because the virtual function
-    // associated with an oki::System will miss anyway (+ quantity is low)
-    std::list<SystemData> systems_;
+    // associated with an oki::System will miss anyway (+ quantity is low).
+    // Each stage has its own list, so that two stages can run at once.
+    std::array<SystemList, 3> stages_;
+
+    // Lets us find a system by handle without walking the whole list
+    oki::intl_::FlatHashMap<oki::Handle, SystemList::iterator> handleIndex_;
 
     oki::intl_::DefaultHandleGenerator<oki::Handle> handleGen_;
 
-    auto seek_handle_(oki::Handle handle) noexcept ->
-        typename decltype(systems_)::iterator
+    // A system to add, or (if its system_ is null) one to remove
+    struct PendingChange
     {
-        // A linear search is fine, because in general there should
-        // be very few systems
-        return std::find_if(systems_.begin(), systems_.end(),
-            [=](const auto& elem) { return elem.handle_ == handle; });
+        SystemData sysData_;
+        oki::SystemStage stage_;
+    };
+
+    // While run_pipelined() overlaps two stages, changes to the systems
+    // (and so to the index) are queued behind this lock instead, and
+    // applied once both stages are done
+    std::mutex* pendingLock_ = nullptr;
+    std::vector<PendingChange> pending_;
+
+    void insert_system_(oki::SystemStage stage, const SystemData& sysData)
+    {
+        // We want to insert this system after higher-priority sytems
+        // and, if they match priorities, after its peers
+        auto& systems = stages_[static_cast<std::size_t>(stage)];
+        auto sysIter = std::find_if(systems.begin(), systems.end(),
+            [&](const auto& elem) {
+                return elem.priority_ < sysData.priority_;
+            });
+
+        handleIndex_.emplace(sysData.handle_, systems.insert(sysIter, sysData));
+    }
+
+    // The system a handle refers to once the queued changes are applied
+    oki::System* seek_pending_(oki::Handle handle) noexcept
+    {
+        for (auto iter = pending_.rbegin(); iter != pending_.rend(); ++iter) {
+            if (iter->sysData_.handle_ == handle) {
+                return iter->sysData_.system_;
+            }
+        }
+
+        // Nothing changes the index while changes are queued
+        auto* sysData = this->seek_handle_(handle);
+        return sysData ? sysData->system_ : nullptr;
+    }
+
+    void apply_pending_()
+    {
+        pendingLock_ = nullptr;
+
+        auto pending = std::move(pending_);
+        pending_.clear();
+
+        for (const auto& change : pending) {
+            if (change.sysData_.system_) {
+                this->insert_system_(change.stage_, change.sysData_);
+            } else {
+                this->remove_system(change.sysData_.handle_);
+            }
+        }
+    }
+
+    SystemData* seek_handle_(oki::Handle handle) noexcept
+    {
+        auto indexIter = handleIndex_.find(handle);
+        return (indexIter != handleIndex_.end()) ? &*indexIter->second
+                                                 : nullptr;
+    }
+
+    bool empty_() const noexcept
+    {
+        return std::all_of(stages_.begin(), stages_.end(),
+            [](const auto& systems) { return systems.empty(); });
+    }
+
+    /*
+     * Steps every system of one stage. Systems removing themselves while
+     * changes are queued (see pendingLock_) are queued for removal too, so
+     * that the index never refers to a system this erased.
+     */
+    std::pair<bool, int> step_stage_(oki::SystemStage stage)
+    {
+        auto& systems = stages_[static_cast<std::size_t>(stage)];
+
+        for (auto sysIter = systems.begin(); sysIter != systems.end();) {
+            // If this system was removed in the last pass,
+            // hard erase it
+            if (!sysIter->system_) {
+                sysIter = systems.erase(sysIter);
+                continue;
+            }
+
+            oki::SystemOptions options;
+            sysIter->system_->step(*this, options);
+
+            if (options.will_remove()) {
+                if (pendingLock_) {
+                    this->remove_system(sysIter->handle_);
+                    ++sysIter;
+                } else {
+                    handleIndex_.erase(sysIter->handle_);
+                    sysIter = systems.erase(sysIter);
+                }
+
+                continue;
+            }
+
+            if (options.will_skip()) {
+                break;
+            }
+
+            auto exitPair = options.exit_info();
+            if (exitPair.first) {
+                return exitPair;
+            }
+
+            ++sysIter;
+        }
+
+        return { false, 0 };
     }
 };
 }
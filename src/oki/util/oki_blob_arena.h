@@ -0,0 +1,202 @@
+#ifndef OKI_BLOB_ARENA_H
+#define OKI_BLOB_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+/*
+ * One array holding the elements of many variable-length blobs (see
+ * oki_blob.h), each of which is an extent: an offset, a size and a
+ * capacity (the size it can grow to in place).
+ *
+ * A blob that outgrows its extent moves to the end of the array, leaving a
+ * hole behind, as does releasing one. compact() closes the holes and puts
+ * the blobs back in a given order, so that visiting them in that order
+ * reads the array front to back.
+ */
+template <typename Element>
+class BlobArena
+{
+public:
+    struct Extent
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint32_t capacity = 0;
+    };
+
+    // Copies [first, last) to the end of the array and returns its extent
+    template <typename InputIt>
+    Extent allocate(InputIt first, InputIt last)
+    {
+        auto offset = storage_.size();
+        storage_.insert(storage_.end(), first, last);
+
+        auto size = storage_.size() - offset;
+        this->check_fits_(storage_.size());
+        live_ += size;
+
+        return { static_cast<std::uint32_t>(offset),
+            static_cast<std::uint32_t>(size),
+            static_cast<std::uint32_t>(size) };
+    }
+
+    /*
+     * Resizes the blob at <extent>, value-initializing new elements. It
+     * grows in place while it has the capacity (or is at the end of the
+     * array) and otherwise moves. Either way its capacity at least
+     * doubles, so a run of push_back()s moves it O(log n) times.
+     */
+    void resize(Extent& extent, std::size_t n)
+    {
+        if (n > extent.capacity) {
+            auto capacity = std::max(n, std::size_t { extent.capacity } * 2);
+
+            if (this->is_last_(extent)) {
+                this->check_fits_(extent.offset + capacity);
+                storage_.resize(extent.offset + capacity);
+            } else {
+                this->relocate_(extent, capacity);
+            }
+
+            extent.capacity = static_cast<std::uint32_t>(capacity);
+        }
+
+        auto* data = storage_.data() + extent.offset;
+        if (n > extent.size) {
+            std::fill(data + extent.size, data + n, Element {});
+        } else {
+            this->clear_(data + n, data + extent.size);
+        }
+
+        live_ = live_ - extent.size + n;
+        extent.size = static_cast<std::uint32_t>(n);
+    }
+
+    // Replaces the contents of the blob at <extent> with [first, last)
+    template <typename ForwardIt>
+    void assign(Extent& extent, ForwardIt first, ForwardIt last)
+    {
+        this->resize(extent, std::distance(first, last));
+        std::copy(first, last, storage_.begin() + extent.offset);
+    }
+
+    // Gives back the blob at <extent>, which must not be used afterwards
+    void release(const Extent& extent)
+    {
+        live_ -= extent.size;
+
+        if (this->is_last_(extent)) {
+            storage_.erase(storage_.begin() + extent.offset, storage_.end());
+        } else {
+            auto* data = storage_.data() + extent.offset;
+            this->clear_(data, data + extent.size);
+        }
+    }
+
+    /*
+     * Moves every blob in [first, last) (a range of Extent&) to the front
+     * of the array, in that order, dropping all holes and spare capacity.
+     * Every live blob must be in the range.
+     */
+    template <typename ExtentIt>
+    void compact(ExtentIt first, ExtentIt last)
+    {
+        std::vector<Element> compacted;
+        compacted.reserve(live_);
+
+        for (; first != last; ++first) {
+            Extent& extent = *first;
+            auto source = storage_.begin() + extent.offset;
+
+            extent.offset = static_cast<std::uint32_t>(compacted.size());
+            extent.capacity = extent.size;
+
+            compacted.insert(compacted.end(), std::make_move_iterator(source),
+                std::make_move_iterator(source + extent.size));
+        }
+
+        storage_.swap(compacted);
+    }
+
+    /*
+     * Whether the holes and spare capacity outweigh the blobs themselves
+     * (and are big enough to bother with), i.e. whether to compact().
+     */
+    bool fragmented() const noexcept
+    {
+        auto waste = storage_.size() - live_;
+        return waste > std::max(live_, MIN_WASTE);
+    }
+
+    Element* data() noexcept { return storage_.data(); }
+    const Element* data() const noexcept { return storage_.data(); }
+
+    // The number of elements in blobs (excluding holes and spare capacity)
+    std::size_t live() const noexcept { return live_; }
+
+    void clear() noexcept
+    {
+        storage_.clear();
+        live_ = 0;
+    }
+
+    void shrink_to_fit() { storage_.shrink_to_fit(); }
+
+    std::size_t memory_usage() const noexcept
+    {
+        return storage_.capacity() * sizeof(Element);
+    }
+
+private:
+    static constexpr std::size_t MIN_WASTE = 1024;
+
+    std::vector<Element> storage_;
+    std::size_t live_ = 0;
+
+    bool is_last_(const Extent& extent) const noexcept
+    {
+        return std::size_t { extent.offset } + extent.capacity
+            == storage_.size();
+    }
+
+    void relocate_(Extent& extent, std::size_t capacity)
+    {
+        auto offset = storage_.size();
+        this->check_fits_(offset + capacity);
+        storage_.resize(offset + capacity);
+
+        auto source = storage_.begin() + extent.offset;
+        std::move(source, source + extent.size, storage_.begin() + offset);
+        this->clear_(&*source, &*source + extent.size);
+
+        extent.offset = static_cast<std::uint32_t>(offset);
+    }
+
+    // Lets go of whatever elements in a hole own (a no-op for most types)
+    static void clear_(Element* first, Element* last)
+    {
+        if constexpr (!std::is_trivially_destructible_v<Element>) {
+            std::fill(first, last, Element {});
+        }
+    }
+
+    static void check_fits_(std::size_t size)
+    {
+        if (size > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("Blob arena is too large");
+        }
+    }
+};
+}
+}
+
+#endif // OKI_BLOB_ARENA_H
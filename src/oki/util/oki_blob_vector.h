@@ -0,0 +1,466 @@
+#ifndef OKI_BLOB_VECTOR_H
+#define OKI_BLOB_VECTOR_H
+
+#include "oki/oki_blob.h"
+#include "oki/util/oki_blob_arena.h"
+#include "oki/util/oki_container.h"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace oki {
+namespace intl_ {
+/*
+ * The blob (see oki_blob.h) counterpart to AssocSortedVector: a sorted
+ * array of (key, extent) pairs, where each extent locates a blob's
+ * elements in a BlobArena.
+ *
+ * It has the same interface as AssocSortedVector except that its
+ * iterators are proxies: dereferencing one yields a
+ * std::pair<Key, oki::BlobRef<BlobType>> by value. Erasing compacts the
+ * arena (in key order) once it is mostly holes, as does compact().
+ */
+template <typename Key, typename BlobType>
+class BlobSortedVector
+{
+    static_assert(oki::intl_::IsBlob<BlobType>::value);
+
+    using Element = typename BlobType::value_type;
+    using Arena = oki::intl_::BlobArena<Element>;
+    using Entries = oki::intl_::AssocSortedVector<Key, typename Arena::Extent>;
+
+public:
+    using key_type = Key;
+    using mapped_type = BlobType;
+    using value_type = std::pair<Key, BlobType>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template <bool CONST>
+    class IteratorImpl
+    {
+        using Base = std::conditional_t<CONST, typename Entries::const_iterator,
+            typename Entries::iterator>;
+        using ArenaPtr = std::conditional_t<CONST, const Arena*, Arena*>;
+        using Ref = oki::BlobRef<
+            std::conditional_t<CONST, const BlobType, BlobType>>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = BlobSortedVector::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<Key, Ref>;
+
+        // What operator->() returns, since there is no pair to point to
+        struct pointer
+        {
+            reference pair;
+
+            reference* operator->() noexcept { return &pair; }
+        };
+
+        IteratorImpl() = default;
+
+        // Allow iterator -> const_iterator conversion
+        template <bool THAT_CONST,
+            std::enable_if_t<CONST && !THAT_CONST, int> = 0>
+        IteratorImpl(const IteratorImpl<THAT_CONST>& that)
+            : base_(that.base_)
+            , arena_(that.arena_)
+        {
+        }
+
+        reference operator*() const
+        {
+            return { base_->first, Ref { *arena_, base_->second } };
+        }
+
+        pointer operator->() const { return pointer { **this }; }
+
+        reference operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        IteratorImpl& operator++()
+        {
+            ++base_;
+            return *this;
+        }
+
+        IteratorImpl operator++(int)
+        {
+            auto old = *this;
+            ++base_;
+
+            return old;
+        }
+
+        IteratorImpl& operator--()
+        {
+            --base_;
+            return *this;
+        }
+
+        IteratorImpl operator--(int)
+        {
+            auto old = *this;
+            --base_;
+
+            return old;
+        }
+
+        IteratorImpl& operator+=(difference_type n)
+        {
+            base_ += n;
+            return *this;
+        }
+
+        IteratorImpl& operator-=(difference_type n)
+        {
+            base_ -= n;
+            return *this;
+        }
+
+        friend IteratorImpl operator+(IteratorImpl iter, difference_type n)
+        {
+            return iter += n;
+        }
+
+        friend IteratorImpl operator+(difference_type n, IteratorImpl iter)
+        {
+            return iter += n;
+        }
+
+        friend IteratorImpl operator-(IteratorImpl iter, difference_type n)
+        {
+            return iter -= n;
+        }
+
+        friend difference_type operator-(
+            const IteratorImpl& lhs, const IteratorImpl& rhs)
+        {
+            return lhs.base_ - rhs.base_;
+        }
+
+        bool operator==(const IteratorImpl& that) const
+        {
+            return base_ == that.base_;
+        }
+
+        bool operator!=(const IteratorImpl& that) const
+        {
+            return base_ != that.base_;
+        }
+
+        bool operator<(const IteratorImpl& that) const
+        {
+            return base_ < that.base_;
+        }
+
+        bool operator>(const IteratorImpl& that) const
+        {
+            return base_ > that.base_;
+        }
+
+        bool operator<=(const IteratorImpl& that) const
+        {
+            return base_ <= that.base_;
+        }
+
+        bool operator>=(const IteratorImpl& that) const
+        {
+            return base_ >= that.base_;
+        }
+
+    private:
+        Base base_ {};
+        ArenaPtr arena_ = nullptr;
+
+        IteratorImpl(Base base, ArenaPtr arena)
+            : base_(base)
+            , arena_(arena)
+        {
+        }
+
+        friend class BlobSortedVector;
+        friend class IteratorImpl<!CONST>;
+    };
+
+    using iterator = IteratorImpl<false>;
+    using const_iterator = IteratorImpl<true>;
+    using reference = typename iterator::reference;
+    using const_reference = typename const_iterator::reference;
+
+    /*
+     * Inserts a new key-value pair into the container, where the blob is
+     * constructed from the arguments.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Key key, Args&&... args)
+    {
+        auto iter = entries_.lower_bound(key);
+        if (iter != entries_.end() && iter->first == key) {
+            return { this->wrap_(iter), false };
+        }
+
+        auto extent = this->allocate_(std::forward<Args>(args)...);
+        return { this->wrap_(entries_.emplace(key, extent).first), true };
+    }
+
+    template <typename InsertType>
+    std::pair<iterator, bool> insert(Key key, InsertType&& value)
+    {
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Guarantees that a pair with key value <key> holds the value <value>,
+     * reusing the old blob's space if it fits.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename InsertType>
+    std::pair<iterator, bool> insert_or_assign(Key key, InsertType&& value)
+    {
+        auto iter = entries_.lower_bound(key);
+        if (iter != entries_.end() && iter->first == key) {
+            const BlobType& blob = value;
+            arena_.assign(iter->second, blob.begin(), blob.end());
+
+            return { this->wrap_(iter), false };
+        }
+
+        auto extent = this->allocate_(std::forward<InsertType>(value));
+        return { this->wrap_(entries_.emplace(key, extent).first), true };
+    }
+
+    /*
+     * Emplaces a key-value pair under the assumption that no item with
+     * that <key> already exists in the container. Does not check.
+     *
+     * Returns an iterator to the newly inserted pair.
+     */
+    template <typename... Args>
+    iterator emplace_unchecked(Key key, Args&&... args)
+    {
+        auto extent = this->allocate_(std::forward<Args>(args)...);
+        return this->wrap_(entries_.emplace_unchecked(key, extent));
+    }
+
+    template <typename InsertType>
+    iterator insert_unchecked(Key key, InsertType&& value)
+    {
+        return this->emplace_unchecked(key, std::forward<InsertType>(value));
+    }
+
+    // See AssocSortedVector::append_unchecked()
+    template <typename... Args>
+    void append_unchecked(Key key, Args&&... args)
+    {
+        auto extent = this->allocate_(std::forward<Args>(args)...);
+        entries_.append_unchecked(key, extent);
+    }
+
+    // See AssocSortedVector::merge_appended()
+    void merge_appended(std::size_t oldSize)
+    {
+        entries_.merge_appended(oldSize);
+    }
+
+    /*
+     * Erases every pair whose key is in the sorted range [first, last) in
+     * a single pass, returning how many were erased.
+     */
+    template <typename KeyIt>
+    std::size_t erase_sorted(KeyIt first, KeyIt last)
+    {
+        // Give back the blobs first (searching onward from the last hit)
+        auto hint = entries_.cbegin();
+        for (auto keyIter = first; keyIter != last; ++keyIter) {
+            hint = std::as_const(entries_).lower_bound(*keyIter, hint);
+
+            if (hint != entries_.cend() && hint->first == *keyIter) {
+                arena_.release(hint->second);
+            }
+        }
+
+        auto erased = entries_.erase_sorted(first, last);
+        this->compact_if_fragmented_();
+
+        return erased;
+    }
+
+    /*
+     * Attempts to erase a pair with key <key>. Does nothing if <key> is not
+     * present.
+     */
+    bool erase(Key key)
+    {
+        auto iter = entries_.find(key);
+        if (iter == entries_.end()) {
+            return false;
+        }
+
+        this->erase(this->wrap_(iter));
+        return true;
+    }
+
+    /*
+     * Erases the pair at <pos> and returns an iterator to the pair after it.
+     */
+    iterator erase(const_iterator pos)
+    {
+        arena_.release(pos.base_->second);
+
+        auto next = entries_.erase(pos.base_);
+        this->compact_if_fragmented_();
+
+        return this->wrap_(next);
+    }
+
+    const_iterator find(Key key) const noexcept
+    {
+        return this->wrap_(entries_.find(key));
+    }
+
+    iterator find(Key key) noexcept { return this->wrap_(entries_.find(key)); }
+
+    const_iterator lower_bound(Key key) const noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key));
+    }
+
+    iterator lower_bound(Key key) noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key));
+    }
+
+    // See AssocSortedVector::lower_bound()
+    const_iterator lower_bound(Key key, const_iterator hint) const noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key, hint.base_));
+    }
+
+    iterator lower_bound(Key key, const_iterator hint) noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key, hint.base_));
+    }
+
+    // See AssocSortedVector::lower_bound_batch()
+    template <typename KeyIt, typename OutputIt>
+    OutputIt lower_bound_batch(KeyIt first, KeyIt last, OutputIt out) const
+    {
+        return entries_.lower_bound_batch(first, last, out);
+    }
+
+    bool contains(Key key) const noexcept { return entries_.contains(key); }
+
+    /*
+     * Moves the blobs to the front of the arena in key order, dropping any
+     * holes and spare capacity, so that iterating reads the arena front to
+     * back. Invalidates pointers into blobs.
+     */
+    void compact()
+    {
+        struct ExtentIter
+        {
+            typename Entries::iterator base;
+
+            auto& operator*() const { return base->second; }
+
+            ExtentIter& operator++()
+            {
+                ++base;
+                return *this;
+            }
+
+            bool operator!=(const ExtentIter& that) const
+            {
+                return base != that.base;
+            }
+        };
+
+        arena_.compact(
+            ExtentIter { entries_.begin() }, ExtentIter { entries_.end() });
+    }
+
+    // The total number of elements in all blobs
+    std::size_t num_elements() const noexcept { return arena_.live(); }
+
+    iterator begin() { return this->wrap_(entries_.begin()); }
+    const_iterator begin() const { return this->wrap_(entries_.cbegin()); }
+    const_iterator cbegin() const { return this->begin(); }
+    iterator end() { return this->wrap_(entries_.end()); }
+    const_iterator end() const { return this->wrap_(entries_.cend()); }
+    const_iterator cend() const { return this->end(); }
+
+    std::size_t size() const noexcept { return entries_.size(); }
+
+    void clear() noexcept
+    {
+        entries_.clear();
+        arena_.clear();
+    }
+
+    void reserve(std::size_t n) { entries_.reserve(n); }
+    std::size_t capacity() const noexcept { return entries_.capacity(); }
+
+    void shrink_to_fit()
+    {
+        entries_.shrink_to_fit();
+        arena_.shrink_to_fit();
+    }
+
+    // Returns the number of bytes allocated for pairs and the arena
+    std::size_t memory_usage() const noexcept
+    {
+        return entries_.memory_usage() + arena_.memory_usage();
+    }
+
+private:
+    Entries entries_;
+    Arena arena_;
+
+    iterator wrap_(typename Entries::iterator base) noexcept
+    {
+        return { base, &arena_ };
+    }
+
+    const_iterator wrap_(typename Entries::const_iterator base) const noexcept
+    {
+        return { base, &arena_ };
+    }
+
+    template <typename... Args>
+    typename Arena::Extent allocate_(Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 1
+            && (std::is_convertible_v<Args, const BlobType&> && ...)) {
+            const BlobType& blob = (args, ...);
+            return arena_.allocate(blob.begin(), blob.end());
+        } else {
+            BlobType blob(std::forward<Args>(args)...);
+            return arena_.allocate(blob.begin(), blob.end());
+        }
+    }
+
+    void compact_if_fragmented_()
+    {
+        if (arena_.fragmented()) {
+            this->compact();
+        }
+    }
+};
+}
+}
+
+#endif // OKI_BLOB_VECTOR_H
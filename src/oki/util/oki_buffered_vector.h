@@ -0,0 +1,413 @@
+#ifndef OKI_BUFFERED_VECTOR_H
+#define OKI_BUFFERED_VECTOR_H
+
+#include "oki/util/oki_container.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+/*
+ * The buffered (see oki_buffered.h) counterpart to AssocSortedVector: the
+ * same sorted array, plus a log of the keys whose values may have changed
+ * since the log was last taken (see take_changes()).
+ *
+ * It has the same interface as AssocSortedVector except that its iterator
+ * logs the key whenever it is dereferenced, since that hands out a
+ * mutable reference. Its operator-> is read-only, so that comparing keys
+ * (as searching and intersecting do) logs nothing.
+ *
+ * The log holds at most size() keys; past that, every key counts as
+ * changed until the next take_changes().
+ */
+template <typename Key, typename Type>
+class BufferedSortedVector
+{
+    using Data = oki::intl_::AssocSortedVector<Key, Type>;
+
+public:
+    using key_type = Key;
+    using mapped_type = Type;
+    using value_type = std::pair<Key, Type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = typename Data::const_iterator;
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::pair<Key, Type>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type&;
+        using pointer = const value_type*;
+
+        iterator() = default;
+
+        reference operator*() const
+        {
+            owner_->mark_changed(base_->first);
+            return *base_;
+        }
+
+        pointer operator->() const { return &*base_; }
+
+        reference operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        iterator& operator++()
+        {
+            ++base_;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto old = *this;
+            ++base_;
+
+            return old;
+        }
+
+        iterator& operator--()
+        {
+            --base_;
+            return *this;
+        }
+
+        iterator operator--(int)
+        {
+            auto old = *this;
+            --base_;
+
+            return old;
+        }
+
+        iterator& operator+=(difference_type n)
+        {
+            base_ += n;
+            return *this;
+        }
+
+        iterator& operator-=(difference_type n)
+        {
+            base_ -= n;
+            return *this;
+        }
+
+        friend iterator operator+(iterator iter, difference_type n)
+        {
+            return iter += n;
+        }
+
+        friend iterator operator+(difference_type n, iterator iter)
+        {
+            return iter += n;
+        }
+
+        friend iterator operator-(iterator iter, difference_type n)
+        {
+            return iter -= n;
+        }
+
+        friend difference_type operator-(
+            const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.base_ - rhs.base_;
+        }
+
+        bool operator==(const iterator& that) const
+        {
+            return base_ == that.base_;
+        }
+
+        bool operator!=(const iterator& that) const
+        {
+            return base_ != that.base_;
+        }
+
+        bool operator<(const iterator& that) const
+        {
+            return base_ < that.base_;
+        }
+
+        bool operator>(const iterator& that) const
+        {
+            return base_ > that.base_;
+        }
+
+        bool operator<=(const iterator& that) const
+        {
+            return base_ <= that.base_;
+        }
+
+        bool operator>=(const iterator& that) const
+        {
+            return base_ >= that.base_;
+        }
+
+        operator const_iterator() const noexcept { return base_; }
+
+    private:
+        typename Data::iterator base_;
+        BufferedSortedVector* owner_ = nullptr;
+
+        iterator(typename Data::iterator base, BufferedSortedVector* owner)
+            : base_(base)
+            , owner_(owner)
+        {
+        }
+
+        friend class BufferedSortedVector;
+    };
+
+    /*
+     * Inserts a new key-value pair into the container, where the value is
+     * constructed from the arguments.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Key key, Args&&... args)
+    {
+        auto [iter, inserted] = data_.emplace(key, std::forward<Args>(args)...);
+        if (inserted) {
+            this->mark_changed(key);
+        }
+
+        return { this->wrap_(iter), inserted };
+    }
+
+    template <typename InsertType>
+    std::pair<iterator, bool> insert(Key key, InsertType&& value)
+    {
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Guarantees that a pair with key value <key> holds the value <value>.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename InsertType>
+    std::pair<iterator, bool> insert_or_assign(Key key, InsertType&& value)
+    {
+        auto [iter, inserted]
+            = data_.insert_or_assign(key, std::forward<InsertType>(value));
+        this->mark_changed(key);
+
+        return { this->wrap_(iter), inserted };
+    }
+
+    /*
+     * Emplaces a key-value pair under the assumption that no item with
+     * that <key> already exists in the container. Does not check.
+     *
+     * Returns an iterator to the newly inserted pair.
+     */
+    template <typename... Args>
+    iterator emplace_unchecked(Key key, Args&&... args)
+    {
+        auto iter = data_.emplace_unchecked(key, std::forward<Args>(args)...);
+        this->mark_changed(key);
+
+        return this->wrap_(iter);
+    }
+
+    template <typename InsertType>
+    iterator insert_unchecked(Key key, InsertType&& value)
+    {
+        return this->emplace_unchecked(key, std::forward<InsertType>(value));
+    }
+
+    // See AssocSortedVector::append_unchecked()
+    template <typename... Args>
+    void append_unchecked(Key key, Args&&... args)
+    {
+        data_.append_unchecked(key, std::forward<Args>(args)...);
+        this->mark_changed(key);
+    }
+
+    // See AssocSortedVector::merge_appended()
+    void merge_appended(std::size_t oldSize) { data_.merge_appended(oldSize); }
+
+    // See AssocSortedVector::erase_sorted()
+    template <typename KeyIt>
+    std::size_t erase_sorted(KeyIt first, KeyIt last)
+    {
+        // Keys that were not present cost a log entry too, but no more
+        // than the sweep below costs anyway
+        for (auto keyIter = first; keyIter != last; ++keyIter) {
+            this->mark_changed(*keyIter);
+        }
+
+        return data_.erase_sorted(first, last);
+    }
+
+    /*
+     * Attempts to erase a pair with key <key>. Does nothing if <key> is not
+     * present.
+     */
+    bool erase(Key key)
+    {
+        if (!data_.erase(key)) {
+            return false;
+        }
+
+        this->mark_changed(key);
+        return true;
+    }
+
+    /*
+     * Erases the pair at <pos> and returns an iterator to the pair after it.
+     */
+    iterator erase(const_iterator pos)
+    {
+        this->mark_changed(pos->first);
+        return this->wrap_(data_.erase(pos));
+    }
+
+    const_iterator find(Key key) const noexcept { return data_.find(key); }
+    iterator find(Key key) noexcept { return this->wrap_(data_.find(key)); }
+
+    const_iterator lower_bound(Key key) const noexcept
+    {
+        return data_.lower_bound(key);
+    }
+
+    iterator lower_bound(Key key) noexcept
+    {
+        return this->wrap_(data_.lower_bound(key));
+    }
+
+    // See AssocSortedVector::lower_bound()
+    const_iterator lower_bound(Key key, const_iterator hint) const noexcept
+    {
+        return data_.lower_bound(key, hint);
+    }
+
+    iterator lower_bound(Key key, const_iterator hint) noexcept
+    {
+        return this->wrap_(data_.lower_bound(key, hint));
+    }
+
+    // See AssocSortedVector::lower_bound_batch()
+    template <typename KeyIt, typename OutputIt>
+    OutputIt lower_bound_batch(KeyIt first, KeyIt last, OutputIt out) const
+    {
+        return data_.lower_bound_batch(first, last, out);
+    }
+
+    bool contains(Key key) const noexcept { return data_.contains(key); }
+
+    iterator begin() { return this->wrap_(data_.begin()); }
+    const_iterator cbegin() const { return data_.cbegin(); }
+    iterator end() { return this->wrap_(data_.end()); }
+    const_iterator cend() const { return data_.cend(); }
+
+    std::size_t size() const noexcept { return data_.size(); }
+
+    void clear() noexcept
+    {
+        data_.clear();
+        this->mark_all_changed();
+    }
+
+    void reserve(std::size_t n) { data_.reserve(n); }
+    std::size_t capacity() const noexcept { return data_.capacity(); }
+
+    void shrink_to_fit()
+    {
+        data_.shrink_to_fit();
+        changed_.shrink_to_fit();
+    }
+
+    // Returns the number of bytes allocated for pairs and the log
+    std::size_t memory_usage() const noexcept
+    {
+        return data_.memory_usage() + changed_.capacity() * sizeof(Key);
+    }
+
+    // Logs that the value of <key> may have changed
+    void mark_changed(Key key)
+    {
+        if (allChanged_) {
+            return;
+        }
+
+        if (!changed_.empty() && changed_.back() == key) {
+            return;
+        }
+
+        if (changed_.size() < data_.size()) {
+            changed_.push_back(key);
+        } else {
+            this->mark_all_changed();
+        }
+    }
+
+    /*
+     * Logs that every value may have changed, which makes logging free
+     * (and so safe from several threads) until the next take_changes().
+     */
+    void mark_all_changed() noexcept
+    {
+        allChanged_ = true;
+        changed_.clear();
+    }
+
+    /*
+     * Swaps the logged keys into <keys> (sorted, without repeats) and
+     * starts a new log. Returns true, leaving <keys> empty, if every value
+     * counts as changed instead.
+     */
+    bool take_changes(std::vector<Key>& keys)
+    {
+        keys.clear();
+        keys.swap(changed_);
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        return std::exchange(allChanged_, false);
+    }
+
+    /*
+     * Ties the log to one consumer, since taking it twice would lose
+     * changes. Returns whether <consumer> is that one.
+     */
+    bool claim_changes(const void* consumer) noexcept
+    {
+        if (!consumer_) {
+            consumer_ = consumer;
+        }
+
+        return consumer_ == consumer;
+    }
+
+private:
+    Data data_;
+
+    std::vector<Key> changed_;
+    bool allChanged_ = true;
+    const void* consumer_ = nullptr;
+
+    iterator wrap_(typename Data::iterator iter) noexcept
+    {
+        return iterator { iter, this };
+    }
+};
+}
+}
+
+#endif // OKI_BUFFERED_VECTOR_H
@@ -0,0 +1,631 @@
+#ifndef OKI_COLUMN_VECTOR_H
+#define OKI_COLUMN_VECTOR_H
+
+#include "oki/oki_columns.h"
+#include "oki/util/oki_container.h"
+#include "oki/util/oki_reflect.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+/*
+ * The "structure of arrays" counterpart to AssocSortedVector: a sorted
+ * array of keys alongside one array per field of the (aggregate) mapped
+ * type, all in the same order.
+ *
+ * It has the same interface (and performance characteristics) except that
+ * its iterators are proxies: dereferencing one yields a
+ * std::pair<Key, oki::ColumnRef<Type>> by value. Touching a field only
+ * touches that field's column, and column<I>() exposes each column whole.
+ */
+template <typename Key, typename Type>
+class ColumnSortedVector
+{
+    static_assert(std::is_aggregate_v<Type>);
+
+    using Fields = oki::intl_::FieldTypes<Type>;
+    static constexpr std::size_t NUM_FIELDS = std::tuple_size_v<Fields>;
+
+    template <typename Tuple>
+    struct Columns;
+
+    template <typename... FieldTypes>
+    struct Columns<std::tuple<FieldTypes...>>
+    {
+        static_assert((!std::is_aggregate_v<FieldTypes> && ...),
+            "Fields of a column-stored component must not be aggregates");
+
+        using type = std::tuple<std::vector<FieldTypes>...>;
+        using pointers = std::tuple<FieldTypes*...>;
+        using const_pointers = std::tuple<const FieldTypes*...>;
+    };
+
+    using Indices = std::make_index_sequence<NUM_FIELDS>;
+
+public:
+    using key_type = Key;
+    using mapped_type = Type;
+    using value_type = std::pair<Key, Type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template <bool CONST>
+    class IteratorImpl
+    {
+        using KeyPtr = const Key*;
+        using ColumnPtrs = std::conditional_t<CONST,
+            typename Columns<Fields>::const_pointers,
+            typename Columns<Fields>::pointers>;
+        using Ref = oki::ColumnRef<std::conditional_t<CONST, const Type, Type>>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = ColumnSortedVector::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<Key, Ref>;
+
+        // What operator->() returns, since there is no pair to point to
+        struct pointer
+        {
+            reference pair;
+
+            reference* operator->() noexcept { return &pair; }
+        };
+
+        IteratorImpl() = default;
+
+        // Allow iterator -> const_iterator conversion
+        template <bool THAT_CONST,
+            std::enable_if_t<CONST && !THAT_CONST, int> = 0>
+        IteratorImpl(const IteratorImpl<THAT_CONST>& that)
+            : keys_(that.keys_)
+            , columns_(that.columns_)
+            , idx_(that.idx_)
+        {
+        }
+
+        reference operator*() const
+        {
+            return this->deref_(idx_, Indices {});
+        }
+
+        pointer operator->() const { return pointer { **this }; }
+
+        reference operator[](difference_type n) const
+        {
+            return this->deref_(idx_ + n, Indices {});
+        }
+
+        IteratorImpl& operator++()
+        {
+            ++idx_;
+            return *this;
+        }
+
+        IteratorImpl operator++(int)
+        {
+            auto old = *this;
+            ++idx_;
+
+            return old;
+        }
+
+        IteratorImpl& operator--()
+        {
+            --idx_;
+            return *this;
+        }
+
+        IteratorImpl operator--(int)
+        {
+            auto old = *this;
+            --idx_;
+
+            return old;
+        }
+
+        IteratorImpl& operator+=(difference_type n)
+        {
+            idx_ += n;
+            return *this;
+        }
+
+        IteratorImpl& operator-=(difference_type n)
+        {
+            idx_ -= n;
+            return *this;
+        }
+
+        friend IteratorImpl operator+(IteratorImpl iter, difference_type n)
+        {
+            return iter += n;
+        }
+
+        friend IteratorImpl operator+(difference_type n, IteratorImpl iter)
+        {
+            return iter += n;
+        }
+
+        friend IteratorImpl operator-(IteratorImpl iter, difference_type n)
+        {
+            return iter -= n;
+        }
+
+        friend difference_type operator-(
+            const IteratorImpl& lhs, const IteratorImpl& rhs)
+        {
+            return lhs.idx_ - rhs.idx_;
+        }
+
+        bool operator==(const IteratorImpl& that) const
+        {
+            return idx_ == that.idx_;
+        }
+
+        bool operator!=(const IteratorImpl& that) const
+        {
+            return idx_ != that.idx_;
+        }
+
+        bool operator<(const IteratorImpl& that) const
+        {
+            return idx_ < that.idx_;
+        }
+
+        bool operator>(const IteratorImpl& that) const
+        {
+            return idx_ > that.idx_;
+        }
+
+        bool operator<=(const IteratorImpl& that) const
+        {
+            return idx_ <= that.idx_;
+        }
+
+        bool operator>=(const IteratorImpl& that) const
+        {
+            return idx_ >= that.idx_;
+        }
+
+    private:
+        // Iterators hold the start of every column and an index into them
+        KeyPtr keys_ = nullptr;
+        ColumnPtrs columns_ {};
+        difference_type idx_ = 0;
+
+        IteratorImpl(KeyPtr keys, ColumnPtrs columns, difference_type idx)
+            : keys_(keys)
+            , columns_(columns)
+            , idx_(idx)
+        {
+        }
+
+        template <std::size_t... Is>
+        reference deref_(difference_type idx, std::index_sequence<Is...>) const
+        {
+            return { keys_[idx],
+                Ref { { std::get<Is>(columns_)[idx]... } } };
+        }
+
+        friend class ColumnSortedVector;
+        friend class IteratorImpl<!CONST>;
+    };
+
+    using iterator = IteratorImpl<false>;
+    using const_iterator = IteratorImpl<true>;
+    using reference = typename iterator::reference;
+    using const_reference = typename const_iterator::reference;
+
+    /*
+     * Inserts a new key-value pair into the container, where the value is
+     * brace-initialized from the arguments.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Key key, Args&&... args)
+    {
+        auto idx = this->find_key_maybe_max_(key);
+        if (this->check_key_idx_(key, idx)) {
+            return { this->make_iter_(idx), false };
+        }
+
+        this->insert_at_(idx, key, Type { std::forward<Args>(args)... });
+        return { this->make_iter_(idx), true };
+    }
+
+    template <typename InsertType>
+    std::pair<iterator, bool> insert(Key key, InsertType&& value)
+    {
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Guarantees that a pair with key value <key> holds the value <value>.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename InsertType>
+    std::pair<iterator, bool> insert_or_assign(Key key, InsertType&& value)
+    {
+        auto idx = this->find_key_maybe_max_(key);
+        if (this->check_key_idx_(key, idx)) {
+            auto iter = this->make_iter_(idx);
+            iter->second = std::forward<InsertType>(value);
+
+            return { iter, false };
+        }
+
+        this->insert_at_(idx, key, std::forward<InsertType>(value));
+        return { this->make_iter_(idx), true };
+    }
+
+    /*
+     * Emplaces a key-value pair under the assumption that no item with
+     * that <key> already exists in the container. Does not check.
+     *
+     * Returns an iterator to the newly inserted pair.
+     */
+    template <typename... Args>
+    iterator emplace_unchecked(Key key, Args&&... args)
+    {
+        auto idx = this->find_key_maybe_max_(key);
+        this->insert_at_(idx, key, Type { std::forward<Args>(args)... });
+
+        return this->make_iter_(idx);
+    }
+
+    template <typename InsertType>
+    iterator insert_unchecked(Key key, InsertType&& value)
+    {
+        return this->emplace_unchecked(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * See AssocSortedVector::append_unchecked(). The value is
+     * brace-initialized from the arguments.
+     */
+    template <typename... Args>
+    void append_unchecked(Key key, Args&&... args)
+    {
+        this->insert_at_(
+            keys_.size(), key, Type { std::forward<Args>(args)... });
+    }
+
+    /*
+     * See AssocSortedVector::merge_appended(). When the appended keys are
+     * not all greater than the others, every column is permuted into key
+     * order.
+     */
+    void merge_appended(std::size_t oldSize)
+    {
+        if (oldSize == 0 || oldSize == keys_.size()
+            || keys_[oldSize - 1] < keys_[oldSize]) {
+            return;
+        }
+
+        std::vector<std::size_t> order(keys_.size());
+        for (std::size_t i = 0; i != order.size(); ++i) {
+            order[i] = i;
+        }
+
+        std::inplace_merge(order.begin(), order.begin() + oldSize,
+            order.end(), [this](std::size_t lhs, std::size_t rhs) {
+                return keys_[lhs] < keys_[rhs];
+            });
+
+        auto permute = [&](auto& column) {
+            std::remove_reference_t<decltype(column)> sorted;
+            sorted.reserve(column.capacity());
+
+            for (auto idx : order) {
+                sorted.push_back(std::move(column[idx]));
+            }
+
+            column.swap(sorted);
+        };
+
+        permute(keys_);
+        std::apply([&](auto&... cols) { (permute(cols), ...); }, columns_);
+    }
+
+    /*
+     * Erases every pair whose key is in the sorted range [first, last) in
+     * a single pass, returning how many were erased.
+     */
+    template <typename KeyIt>
+    std::size_t erase_sorted(KeyIt first, KeyIt last)
+    {
+        if (first == last) {
+            return 0;
+        }
+
+        // Compact every column the same way the keys are
+        std::size_t out = this->find_key_(*first);
+        auto compact = [&](auto& column, auto keep) {
+            std::size_t to = out;
+            for (std::size_t from = out; from != column.size(); ++from) {
+                if (keep(from)) {
+                    column[to++] = std::move(column[from]);
+                }
+            }
+
+            return to;
+        };
+
+        std::vector<bool> kept(keys_.size());
+        auto newSize = compact(keys_, [&](std::size_t idx) {
+            while (first != last && *first < keys_[idx]) {
+                ++first;
+            }
+
+            return kept[idx] = (first == last || !(*first == keys_[idx]));
+        });
+
+        std::apply(
+            [&](auto&... cols) {
+                (compact(cols, [&](std::size_t idx) { return kept[idx]; }),
+                    ...);
+            },
+            columns_);
+
+        auto truncate = [=](auto& column) {
+            column.erase(column.begin() + newSize, column.end());
+        };
+
+        auto erased = keys_.size() - newSize;
+        truncate(keys_);
+        std::apply([&](auto&... cols) { (truncate(cols), ...); }, columns_);
+
+        return erased;
+    }
+
+    /*
+     * Attempts to erase a pair with key <key>. Does nothing if <key> is not
+     * present.
+     */
+    bool erase(Key key)
+    {
+        auto idx = this->find_key_(key);
+        if (!this->check_key_idx_(key, idx)) {
+            return false;
+        }
+
+        this->erase_at_(idx, Indices {});
+        return true;
+    }
+
+    /*
+     * Erases the pair at <pos> and returns an iterator to the pair after it.
+     */
+    iterator erase(const_iterator pos)
+    {
+        auto idx = static_cast<std::size_t>(pos.idx_);
+        this->erase_at_(idx, Indices {});
+
+        return this->make_iter_(idx);
+    }
+
+    const_iterator find(Key key) const noexcept
+    {
+        auto idx = this->find_key_(key);
+        return this->check_key_idx_(key, idx) ? this->make_iter_(idx)
+                                              : this->cend();
+    }
+
+    iterator find(Key key) noexcept
+    {
+        auto idx = this->find_key_(key);
+        return this->check_key_idx_(key, idx) ? this->make_iter_(idx)
+                                              : this->end();
+    }
+
+    const_iterator lower_bound(Key key) const noexcept
+    {
+        return this->make_iter_(this->find_key_(key));
+    }
+
+    iterator lower_bound(Key key) noexcept
+    {
+        return this->make_iter_(this->find_key_(key));
+    }
+
+    /*
+     * Equivalent to lower_bound(key), but gallops outward from <hint> (see
+     * AssocSortedVector::lower_bound()).
+     */
+    const_iterator lower_bound(Key key, const_iterator hint) const noexcept
+    {
+        return this->make_iter_(this->gallop_(key, hint));
+    }
+
+    iterator lower_bound(Key key, const_iterator hint) noexcept
+    {
+        return this->make_iter_(this->gallop_(key, hint));
+    }
+
+    /*
+     * See AssocSortedVector::lower_bound_batch(). Only the keys are
+     * searched, which are packed more densely than in an
+     * AssocSortedVector.
+     */
+    template <typename KeyIt, typename OutputIt>
+    OutputIt lower_bound_batch(KeyIt first, KeyIt last, OutputIt out) const
+    {
+        return oki::intl_::helper_::batch_lower_bound<Key>(keys_.data(),
+            keys_.size(), first, last, out, [](Key stored) { return stored; });
+    }
+
+    bool contains(Key key) const noexcept
+    {
+        return this->check_key_idx_(key, this->find_key_(key));
+    }
+
+    /*
+     * Returns the Ith field of every value, in key order.
+     */
+    template <std::size_t I>
+    auto column() noexcept
+    {
+        auto& col = std::get<I>(columns_);
+        return oki::ColumnSpan { col.data(), col.size() };
+    }
+
+    template <std::size_t I>
+    auto column() const noexcept
+    {
+        auto& col = std::get<I>(columns_);
+        return oki::ColumnSpan { col.data(), col.size() };
+    }
+
+    iterator begin() { return this->make_iter_(0); }
+    const_iterator begin() const { return this->make_iter_(0); }
+    const_iterator cbegin() const { return this->begin(); }
+    iterator end() { return this->make_iter_(keys_.size()); }
+    const_iterator end() const { return this->make_iter_(keys_.size()); }
+    const_iterator cend() const { return this->end(); }
+
+    std::size_t size() const noexcept { return keys_.size(); }
+
+    void clear() noexcept
+    {
+        keys_.clear();
+        std::apply([](auto&... cols) { (cols.clear(), ...); }, columns_);
+    }
+
+    void reserve(std::size_t n)
+    {
+        keys_.reserve(n);
+        std::apply([=](auto&... cols) { (cols.reserve(n), ...); }, columns_);
+    }
+
+    // The number of pairs that fit in every column without reallocating
+    std::size_t capacity() const noexcept
+    {
+        return std::apply(
+            [this](const auto&... cols) {
+                return std::min({ keys_.capacity(), cols.capacity()... });
+            },
+            columns_);
+    }
+
+    void shrink_to_fit()
+    {
+        keys_.shrink_to_fit();
+        std::apply(
+            [](auto&... cols) { (cols.shrink_to_fit(), ...); }, columns_);
+    }
+
+    // Returns the number of bytes allocated for all columns (used or not)
+    std::size_t memory_usage() const noexcept
+    {
+        return std::apply(
+            [this](const auto&... cols) {
+                return keys_.capacity() * sizeof(Key)
+                    + ((cols.capacity() * sizeof(cols[0])) + ...);
+            },
+            columns_);
+    }
+
+private:
+    std::vector<Key> keys_;
+    typename Columns<Fields>::type columns_;
+
+    iterator make_iter_(std::size_t idx)
+    {
+        return std::apply(
+            [&](auto&... cols) {
+                return iterator { keys_.data(),
+                    typename iterator::ColumnPtrs { cols.data()... },
+                    static_cast<difference_type>(idx) };
+            },
+            columns_);
+    }
+
+    const_iterator make_iter_(std::size_t idx) const
+    {
+        return std::apply(
+            [&](const auto&... cols) {
+                return const_iterator { keys_.data(),
+                    typename const_iterator::ColumnPtrs { cols.data()... },
+                    static_cast<difference_type>(idx) };
+            },
+            columns_);
+    }
+
+    std::size_t find_key_(Key key) const
+    {
+        auto iter = std::lower_bound(keys_.begin(), keys_.end(), key);
+        return static_cast<std::size_t>(iter - keys_.begin());
+    }
+
+    // Most insertions are of new, maximal keys, which need no search
+    std::size_t find_key_maybe_max_(Key key) const
+    {
+        if (keys_.empty() || keys_.back() < key) {
+            return keys_.size();
+        }
+
+        return this->find_key_(key);
+    }
+
+    bool check_key_idx_(Key key, std::size_t idx) const
+    {
+        return idx != keys_.size() && keys_[idx] == key;
+    }
+
+    std::size_t gallop_(Key key, const_iterator hint) const
+    {
+        auto iter = oki::intl_::helper_::gallop_lower_bound(keys_.begin(),
+            keys_.end(), keys_.begin() + hint.idx_, key,
+            [](Key stored) { return stored; });
+
+        return static_cast<std::size_t>(iter - keys_.begin());
+    }
+
+    template <typename Value>
+    void insert_at_(std::size_t idx, Key key, Value&& value)
+    {
+        // Grow every column up front so that the insertions below cannot
+        // fail partway through and leave the columns out of step
+        if (this->capacity() == keys_.size()) {
+            this->reserve(std::max<std::size_t>(2 * keys_.size(), 8));
+        }
+
+        Type copy { std::forward<Value>(value) };
+        this->insert_fields_(idx, oki::intl_::tie_fields(copy), Indices {});
+        keys_.insert(keys_.begin() + idx, key);
+    }
+
+    template <typename FieldRefs, std::size_t... Is>
+    void insert_fields_(
+        std::size_t idx, FieldRefs fields, std::index_sequence<Is...>)
+    {
+        (std::get<Is>(columns_).insert(std::get<Is>(columns_).begin() + idx,
+             std::move(std::get<Is>(fields))),
+            ...);
+    }
+
+    template <std::size_t... Is>
+    void erase_at_(std::size_t idx, std::index_sequence<Is...>)
+    {
+        keys_.erase(keys_.begin() + idx);
+        (std::get<Is>(columns_).erase(std::get<Is>(columns_).begin() + idx),
+            ...);
+    }
+};
+}
+}
+
+#endif // OKI_COLUMN_VECTOR_H
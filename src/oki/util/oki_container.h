@@ -2,6 +2,8 @@
 #define OKI_CONTAINER_H
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <tuple>
@@ -11,6 +13,113 @@
 
 namespace oki {
 namespace intl_ {
+// Hints that the memory at <ptr> will be read soon
+inline void prefetch(const void* ptr) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#else
+    (void)ptr;
+#endif
+}
+
+namespace helper_ {
+/*
+ * std::lower_bound() over the sorted range [begin, end), where keyOf()
+ * extracts the key from an element, that searches outward from <hint> in
+ * exponentially growing steps ("galloping") before binary searching.
+ */
+template <typename Iterator, typename Key, typename KeyOf>
+Iterator gallop_lower_bound(
+    Iterator begin, Iterator end, Iterator hint, Key key, KeyOf keyOf)
+{
+    auto less = [&](const auto& elem, Key val) { return keyOf(elem) < val; };
+    std::size_t step = 1;
+
+    if (hint != end && keyOf(*hint) < key) {
+        // Everything before lo is less than key
+        auto lo = std::next(hint);
+        while (static_cast<std::size_t>(end - lo) > step) {
+            auto hi = lo + step;
+            if (!(keyOf(*hi) < key)) {
+                return std::lower_bound(lo, hi, key, less);
+            }
+
+            lo = std::next(hi);
+            step *= 2;
+        }
+
+        return std::lower_bound(lo, end, key, less);
+    }
+
+    // Nothing from hi onwards is less than key
+    auto hi = hint;
+    while (static_cast<std::size_t>(hi - begin) > step) {
+        auto lo = hi - step;
+        if (keyOf(*lo) < key) {
+            return std::lower_bound(std::next(lo), hi, key, less);
+        }
+
+        hi = lo;
+        step *= 2;
+    }
+
+    return std::lower_bound(begin, hi, key, less);
+}
+
+/*
+ * Writes the index of the lower bound of each key in [first, last) within
+ * the sorted array data[0, size) to <out> (see
+ * AssocSortedVector::lower_bound_batch()).
+ */
+template <typename Key, typename Element, typename KeyIt, typename OutputIt,
+    typename KeyOf>
+OutputIt batch_lower_bound(const Element* data, std::size_t size,
+    KeyIt first, KeyIt last, OutputIt out, KeyOf keyOf)
+{
+    constexpr std::size_t GROUP = 16;
+
+    std::array<Key, GROUP> keys;
+    std::array<const Element*, GROUP> bases;
+
+    while (first != last) {
+        std::size_t count = 0;
+        for (; count != GROUP && first != last; ++count, ++first) {
+            keys[count] = *first;
+            bases[count] = data;
+        }
+
+        // A branchless binary search: every key takes the same number of
+        // steps, which is what lets them share a loop
+        for (std::size_t n = size; n > 1;) {
+            std::size_t half = n / 2;
+            std::size_t next = (n - half) / 2;
+
+            for (std::size_t i = 0; i != count; ++i) {
+                auto base = bases[i];
+                oki::intl_::prefetch(base + next);
+                oki::intl_::prefetch(base + half + next);
+
+                bases[i] = base + (keyOf(base[half]) < keys[i] ? half : 0);
+            }
+
+            n -= half;
+        }
+
+        for (std::size_t i = 0; i != count; ++i) {
+            auto result = bases[i];
+            if (size && keyOf(*result) < keys[i]) {
+                ++result;
+            }
+
+            *out++ = static_cast<std::size_t>(result - data);
+        }
+    }
+
+    return out;
+}
+}
+
 /*
  * This is an implementation of one the simplest associative containers:
  * the sorted array.
@@ -142,6 +251,71 @@ public:
         return this->emplace_unchecked(key, std::forward<InsertType>(value));
     }
 
+    /*
+     * For bulk insertions: appends a key-value pair without regard for
+     * order (or checking whether <key> is already present). A run of
+     * these must end with merge_appended() before the container is used
+     * for anything else.
+     */
+    template <typename... Args>
+    void append_unchecked(Key key, Args&&... args)
+    {
+        data_.emplace_back(std::piecewise_construct, std::tuple { key },
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /*
+     * Restores order after append_unchecked(), given the size beforehand.
+     * The appended keys must be ascending among themselves, so this only
+     * costs a comparison if they were all greater than the others (and a
+     * linear merge otherwise).
+     */
+    void merge_appended(std::size_t oldSize)
+    {
+        auto mid = data_.begin() + oldSize;
+        if (mid == data_.begin() || mid == data_.end()
+            || std::prev(mid)->first < mid->first) {
+            return;
+        }
+
+        std::inplace_merge(data_.begin(), mid, data_.end(),
+            [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+    }
+
+    /*
+     * Erases every pair whose key is in the sorted range [first, last) in
+     * a single pass, returning how many were erased. The range must not
+     * repeat keys (the containers built on this one rely on that too).
+     */
+    template <typename KeyIt>
+    std::size_t erase_sorted(KeyIt first, KeyIt last)
+    {
+        if (first == last) {
+            return 0;
+        }
+
+        auto out = this->find_key_(*first);
+        for (auto iter = out; iter != data_.end(); ++iter) {
+            while (first != last && *first < iter->first) {
+                ++first;
+            }
+
+            if (first == last || !(*first == iter->first)) {
+                if (out != iter) {
+                    *out = std::move(*iter);
+                }
+                ++out;
+            }
+        }
+
+        auto erased = static_cast<std::size_t>(data_.end() - out);
+        data_.erase(out, data_.end());
+
+        return erased;
+    }
+
     /*
      * Attempts to erase a pair with key <key>. Does nothing if <key> is not
      * present.
@@ -158,6 +332,11 @@ public:
         return true;
     }
 
+    /*
+     * Erases the pair at <pos> and returns an iterator to the pair after it.
+     */
+    iterator erase(const_iterator pos) { return data_.erase(pos); }
+
     /*
      * Attempts to locate a const_iterator to a pair with key <key>.
      *
@@ -183,6 +362,57 @@ public:
         return ret;
     }
 
+    /*
+     * Returns an iterator to the first pair whose key is not less than
+     * <key> (which is this->end() if there is none).
+     */
+    const_iterator lower_bound(Key key) const noexcept
+    {
+        return this->find_key_(key);
+    }
+
+    iterator lower_bound(Key key) noexcept { return this->find_key_(key); }
+
+    /*
+     * Equivalent to lower_bound(key), but searches outward from <hint> in
+     * exponentially growing steps ("galloping") before binary searching.
+     * This costs O(log d), where d is the distance from <hint> to the
+     * result, so a sequence of lookups in (mostly) ascending key order,
+     * each hinted with the last result, approaches the cost of a scan.
+     */
+    const_iterator lower_bound(Key key, const_iterator hint) const noexcept
+    {
+        return oki::intl_::helper_::gallop_lower_bound(data_.cbegin(),
+            data_.cend(), hint, key,
+            [](const auto& kvPair) { return kvPair.first; });
+    }
+
+    /*
+     * Equivalent to calling lower_bound() on each key in [first, last), but
+     * writes the index of each result (size() if there is none) to <out>.
+     *
+     * The searches for a group of keys advance in lockstep, prefetching
+     * both of each one's possible next probes, so their cache misses
+     * overlap instead of forming one long dependent chain per key. This is
+     * much faster for many keys in a large container.
+     */
+    template <typename KeyIt, typename OutputIt>
+    OutputIt lower_bound_batch(KeyIt first, KeyIt last, OutputIt out) const
+    {
+        return oki::intl_::helper_::batch_lower_bound<Key>(data_.data(),
+            data_.size(), first, last, out,
+            [](const auto& kvPair) { return kvPair.first; });
+    }
+
+    iterator lower_bound(Key key, const_iterator hint) noexcept
+    {
+        auto iter = std::as_const(*this).lower_bound(key, hint);
+        auto ret = data_.begin();
+        std::advance(ret, std::distance(data_.cbegin(), iter));
+
+        return ret;
+    }
+
     /*
      * Attempts to locate a pair with key <key>.
      *
@@ -201,6 +431,14 @@ public:
     std::size_t size() const noexcept { return data_.size(); }
     void clear() noexcept { data_.clear(); }
     void reserve(std::size_t n) { data_.reserve(n); }
+    std::size_t capacity() const noexcept { return data_.capacity(); }
+    void shrink_to_fit() { data_.shrink_to_fit(); }
+
+    // Returns the number of bytes allocated for pairs (used or not)
+    std::size_t memory_usage() const noexcept
+    {
+        return data_.capacity() * sizeof(value_type);
+    }
 
 private:
     DataType data_;
@@ -294,8 +532,10 @@ enum class Status
 template <typename Key, typename IteratorPair>
 oki::intl_::helper_::Status step_iter_pair(Key& max, IteratorPair& pair)
 {
-    pair.first = std::find_if_not(pair.first, pair.second,
-        [=](const auto& kvPair) { return kvPair.first < max; });
+    // Only compares keys through ->, which never hands out a value
+    while (pair.first != pair.second && pair.first->first < max) {
+        ++pair.first;
+    }
 
     if (pair.first == pair.second) {
         return Status::STOP;
@@ -307,35 +547,185 @@ oki::intl_::helper_::Status step_iter_pair(Key& max, IteratorPair& pair)
         return Status::NEW_MAX;
     }
 }
-}
 
-template <typename Callback, typename... IteratorPairs>
-Callback variadic_set_intersection(Callback func, IteratorPairs... iterPairs)
+/*
+ * Advances every iterator pair to the next key they all have in common,
+ * starting from their current positions.
+ *
+ * Returns false (leaving the pairs in an unspecified, but valid, state)
+ * if any of them runs out before a common key is found.
+ */
+template <typename... IteratorPairs>
+bool seek_intersection(IteratorPairs&... iterPairs)
 {
-    namespace helper = oki::intl_::helper_;
-
     if (((iterPairs.first == iterPairs.second) || ...)) {
-        return func;
+        return false;
     }
 
     // This is essentially the merge join algorithm, optimized for
     // cache-coherence
-    auto max = helper::get_first_key(iterPairs...);
+    auto max = get_first_key(iterPairs...);
     while (true) {
-        helper::Status status
-            = std::min({ helper::step_iter_pair(max, iterPairs)... });
+        Status status = std::min({ step_iter_pair(max, iterPairs)... });
 
-        if (status == helper::Status::STOP) {
-            return func;
+        if (status == Status::STOP) {
+            return false;
+        }
+        if (status == Status::CALL) {
+            return true;
         }
-        if (status == helper::Status::CALL) {
-            func(*iterPairs.first...);
+    }
+}
+}
+
+/*
+ * Calls func() with the matching pairs for every key the given (sorted)
+ * ranges have in common.
+ *
+ * If func() returns a bool, returning false stops the iteration early.
+ */
+template <typename Callback, typename... IteratorPairs>
+Callback variadic_set_intersection(Callback func, IteratorPairs... iterPairs)
+{
+    namespace helper = oki::intl_::helper_;
+
+    using Result = std::invoke_result_t<Callback&,
+        decltype(*std::declval<IteratorPairs>().first)...>;
+
+    if constexpr (sizeof...(IteratorPairs) == 1) {
+        // Nothing to intersect with, so skip the key comparisons
+        for (; ((iterPairs.first != iterPairs.second) && ...);
+             (++iterPairs.first, ...)) {
+            if constexpr (std::is_same_v<Result, bool>) {
+                if (!func(*iterPairs.first...)) {
+                    break;
+                }
+            } else {
+                func(*iterPairs.first...);
+            }
+        }
+    } else {
+        while (helper::seek_intersection(iterPairs...)) {
+            if constexpr (std::is_same_v<Result, bool>) {
+                if (!func(*iterPairs.first...)) {
+                    break;
+                }
+            } else {
+                func(*iterPairs.first...);
+            }
+
             (++iterPairs.first, ...);
         }
     }
 
     return func;
 }
+
+/*
+ * Counts the keys the given (sorted) ranges have in common, without
+ * doing anything else with them.
+ */
+template <typename... IteratorPairs>
+std::size_t count_set_intersection(IteratorPairs... iterPairs)
+{
+    if constexpr (sizeof...(IteratorPairs) == 1) {
+        // Nothing to intersect with
+        return (std::distance(iterPairs.first, iterPairs.second) + ...);
+    } else {
+        std::size_t count = 0;
+        while (oki::intl_::helper_::seek_intersection(iterPairs...)) {
+            ++count;
+            (++iterPairs.first, ...);
+        }
+
+        return count;
+    }
+}
+
+/*
+ * The iterator equivalent of variadic_set_intersection(): walks several
+ * sorted ranges of key-value pairs at once, stopping only on the keys
+ * they all share.
+ *
+ * Dereferencing yields a std::tuple of references to the matching pairs
+ * (in the order the ranges were given), so this is only a proxy iterator
+ * and models a forward iterator at best.
+ */
+template <typename... Iterators>
+class IntersectionIterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type
+        = std::tuple<typename std::iterator_traits<Iterators>::reference...>;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+    using pointer = void;
+
+    IntersectionIterator() = default;
+
+    /*
+     * Takes each range as a (begin, end) pair and moves to the first
+     * common key. Passing (end, end) for the ranges creates the end
+     * iterator.
+     */
+    explicit IntersectionIterator(std::pair<Iterators, Iterators>... ranges)
+        : ranges_(ranges...)
+    {
+        this->seek_();
+    }
+
+    reference operator*() const
+    {
+        return std::apply(
+            [](const auto&... ranges) {
+                return reference { *ranges.first... };
+            },
+            ranges_);
+    }
+
+    IntersectionIterator& operator++()
+    {
+        std::apply([](auto&... ranges) { (++ranges.first, ...); }, ranges_);
+        this->seek_();
+
+        return *this;
+    }
+
+    IntersectionIterator operator++(int)
+    {
+        auto old = *this;
+        ++*this;
+
+        return old;
+    }
+
+    bool operator==(const IntersectionIterator& that) const
+    {
+        // Exhausted iterators are moved entirely to the end, so comparing
+        // the first range is enough
+        return std::get<0>(ranges_).first == std::get<0>(that.ranges_).first;
+    }
+
+    bool operator!=(const IntersectionIterator& that) const
+    {
+        return !(*this == that);
+    }
+
+private:
+    std::tuple<std::pair<Iterators, Iterators>...> ranges_;
+
+    void seek_()
+    {
+        std::apply(
+            [](auto&... ranges) {
+                if (!oki::intl_::helper_::seek_intersection(ranges...)) {
+                    ((ranges.first = ranges.second), ...);
+                }
+            },
+            ranges_);
+    }
+};
 }
 }
 
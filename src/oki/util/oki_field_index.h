@@ -0,0 +1,313 @@
+#ifndef OKI_FIELD_INDEX_H
+#define OKI_FIELD_INDEX_H
+
+#include "oki/util/oki_flat_map.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+// Takes a pointer to a data member apart
+template <typename MemberPtr>
+struct MemberTraits;
+
+template <typename ClassType, typename FieldType>
+struct MemberTraits<FieldType ClassType::*>
+{
+    using Class = ClassType;
+    using Field = FieldType;
+};
+
+template <auto MEMBER>
+using FieldOf = typename MemberTraits<decltype(MEMBER)>::Field;
+
+template <auto MEMBER>
+using ClassOf = typename MemberTraits<decltype(MEMBER)>::Class;
+
+// Whether two (possibly differently typed) member pointers are the same
+template <auto LHS, auto RHS>
+constexpr bool same_member() noexcept
+{
+    if constexpr (std::is_same_v<decltype(LHS), decltype(RHS)>) {
+        return LHS == RHS;
+    } else {
+        return false;
+    }
+}
+
+/*
+ * Maps the value of one field (MEMBER) of a component to the keys of the
+ * components that have it, for equality lookups in O(1).
+ *
+ * Each value keeps its keys in ascending order. The first is stored
+ * inline, so that an index of (mostly) unique values allocates nothing per
+ * value. The rest start at an offset into their array, so that the lowest
+ * key (as destroying entities in order removes) is taken off in O(1).
+ */
+template <typename Key, auto MEMBER>
+class HashFieldIndex
+{
+    using Class = ClassOf<MEMBER>;
+    using Field = FieldOf<MEMBER>;
+
+public:
+    void insert(Key key, const Class& comp)
+    {
+        auto [iter, inserted] = buckets_.emplace(comp.*MEMBER);
+        auto& bucket = iter->second;
+
+        if (inserted) {
+            bucket.first = key;
+        } else if (key < bucket.first) {
+            if (bucket.start) {
+                bucket.rest[--bucket.start] = bucket.first;
+            } else {
+                bucket.rest.insert(bucket.rest.begin(), bucket.first);
+            }
+
+            bucket.first = key;
+        } else if (bucket.size() == 0 || bucket.rest.back() < key) {
+            bucket.rest.push_back(key);
+        } else {
+            bucket.rest.insert(
+                std::lower_bound(bucket.begin(), bucket.rest.end(), key), key);
+        }
+    }
+
+    void erase(Key key, const Class& comp)
+    {
+        auto iter = buckets_.find(comp.*MEMBER);
+        auto& bucket = iter->second;
+
+        if (bucket.first != key) {
+            bucket.rest.erase(
+                std::lower_bound(bucket.begin(), bucket.rest.end(), key));
+            return;
+        }
+
+        if (bucket.size() == 0) {
+            buckets_.erase(iter);
+            return;
+        }
+
+        bucket.first = bucket.rest[bucket.start++];
+
+        // Dropping the taken keys once they are the bigger part keeps this
+        // amortized O(1)
+        if (bucket.start > bucket.size()) {
+            bucket.rest.erase(
+                bucket.rest.begin(), bucket.rest.begin() + bucket.start);
+            bucket.start = 0;
+        }
+    }
+
+    // Returns the lowest key whose field equals <value>, or nullptr
+    const Key* find_first(const Field& value) const
+    {
+        auto iter = buckets_.find(value);
+        return (iter != buckets_.end()) ? &iter->second.first : nullptr;
+    }
+
+    // Calls func(key) for each key whose field equals <value>, ascending
+    template <typename Callback>
+    void for_each_equal(const Field& value, Callback& func) const
+    {
+        auto iter = buckets_.find(value);
+        if (iter == buckets_.end()) {
+            return;
+        }
+
+        const auto& bucket = iter->second;
+        func(bucket.first);
+        for (auto keyIter = bucket.begin(); keyIter != bucket.rest.end();
+             ++keyIter) {
+            func(*keyIter);
+        }
+    }
+
+    void clear() noexcept { buckets_.clear(); }
+
+    std::size_t memory_usage() const noexcept
+    {
+        std::size_t total = buckets_.size() * sizeof(Bucket);
+        for (const auto& [value, bucket] : buckets_) {
+            total += bucket.rest.capacity() * sizeof(Key);
+        }
+
+        return total;
+    }
+
+private:
+    // The keys are first, then rest[start], rest[start + 1] and so on
+    struct Bucket
+    {
+        Key first {};
+        std::vector<Key> rest;
+        std::size_t start = 0;
+
+        auto begin() noexcept { return rest.begin() + start; }
+        auto begin() const noexcept { return rest.begin() + start; }
+
+        // The number of keys after the first
+        std::size_t size() const noexcept { return rest.size() - start; }
+    };
+
+    oki::intl_::FlatHashMap<Field, Bucket> buckets_;
+};
+
+/*
+ * Keeps (field value, key) pairs of one field (MEMBER) of a component in
+ * sorted order, for range lookups in O(log n + k).
+ *
+ * Changes are queued and applied in one pass (a merge) by the next lookup,
+ * so that adding or removing many components costs about as much as
+ * adding or removing one. They are also applied once they outnumber the
+ * entries, so that changes without lookups do not pile up.
+ */
+template <typename Key, auto MEMBER>
+class OrderedFieldIndex
+{
+    using Class = ClassOf<MEMBER>;
+    using Field = FieldOf<MEMBER>;
+    using Entry = std::pair<Field, Key>;
+
+public:
+    void insert(Key key, const Class& comp)
+    {
+        added_.emplace_back(comp.*MEMBER, key);
+        this->apply_changes_if_many_();
+    }
+
+    void erase(Key key, const Class& comp)
+    {
+        removed_.emplace_back(comp.*MEMBER, key);
+        this->apply_changes_if_many_();
+    }
+
+    // Returns the lowest key whose field equals <value>, or nullptr
+    const Key* find_first(const Field& value)
+    {
+        this->apply_changes_();
+
+        auto iter = this->lower_bound_(value);
+        return (iter != entries_.end() && !(value < iter->first))
+            ? &iter->second
+            : nullptr;
+    }
+
+    // Calls func(key) for each key whose field equals <value>, ascending
+    template <typename Callback>
+    void for_each_equal(const Field& value, Callback& func)
+    {
+        this->apply_changes_();
+
+        for (auto iter = this->lower_bound_(value);
+             iter != entries_.end() && !(value < iter->first); ++iter) {
+            func(iter->second);
+        }
+    }
+
+    /*
+     * Calls func(key) for each key whose field is in [lo, hi), in order of
+     * field value (then key).
+     */
+    template <typename Callback>
+    void for_each_in_range(const Field& lo, const Field& hi, Callback& func)
+    {
+        this->apply_changes_();
+
+        for (auto iter = this->lower_bound_(lo);
+             iter != entries_.end() && iter->first < hi; ++iter) {
+            func(iter->second);
+        }
+    }
+
+    void clear() noexcept
+    {
+        entries_.clear();
+        added_.clear();
+        removed_.clear();
+    }
+
+    std::size_t memory_usage() const noexcept
+    {
+        return (entries_.capacity() + added_.capacity() + removed_.capacity())
+            * sizeof(Entry);
+    }
+
+private:
+    // The fewest queued changes worth a merge on their own
+    static constexpr std::size_t MIN_QUEUED_ = 64;
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> added_;
+    std::vector<Entry> removed_;
+
+    auto lower_bound_(const Field& value) const
+    {
+        return std::lower_bound(entries_.begin(), entries_.end(), value,
+            [](const Entry& entry, const Field& val) {
+                return entry.first < val;
+            });
+    }
+
+    // Applying takes a pass over the entries, so waiting for about as
+    // many changes keeps each one amortized O(log n)
+    void apply_changes_if_many_()
+    {
+        auto queued = added_.size() + removed_.size();
+        if (queued > std::max(entries_.size(), MIN_QUEUED_)) {
+            this->apply_changes_();
+        }
+    }
+
+    void apply_changes_()
+    {
+        if (!added_.empty()) {
+            std::sort(added_.begin(), added_.end());
+
+            auto oldSize = entries_.size();
+            entries_.insert(entries_.end(), added_.begin(), added_.end());
+            std::inplace_merge(entries_.begin(), entries_.begin() + oldSize,
+                entries_.end());
+
+            added_.clear();
+        }
+
+        if (!removed_.empty()) {
+            std::sort(removed_.begin(), removed_.end());
+
+            // Both are sorted, so each removal drops one equal entry (and
+            // one with no match, e.g. a repeat, is passed over)
+            auto next = removed_.cbegin();
+            auto out = entries_.begin();
+
+            for (auto& entry : entries_) {
+                while (next != removed_.cend() && *next < entry) {
+                    ++next;
+                }
+
+                if (next != removed_.cend() && *next == entry) {
+                    ++next;
+                } else {
+                    if (&*out != &entry) {
+                        *out = std::move(entry);
+                    }
+
+                    ++out;
+                }
+            }
+
+            entries_.erase(out, entries_.end());
+            removed_.clear();
+        }
+    }
+};
+}
+}
+
+#endif // OKI_FIELD_INDEX_H
@@ -0,0 +1,454 @@
+#ifndef OKI_FLAT_MAP_H
+#define OKI_FLAT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace oki {
+namespace intl_ {
+/*
+ * An open-addressing hash map using Robin Hood hashing (linear probing,
+ * where an element that is closer to its ideal slot gives way to one that
+ * is further from its own) with backward-shift deletion.
+ *
+ * All elements live in one flat array, so a lookup is typically a single
+ * cache miss instead of the bucket-then-node chase of std::unordered_map.
+ * This is what the library uses for its small, very frequently probed
+ * registries.
+ *
+ * Its characteristics are as follows:
+ *   - Fast lookups, even at high load (probe lengths stay short)
+ *   - Elements MOVE on rehash and on erase: any insertion or erasure
+ *       invalidates all iterators, pointers and references
+ *   - Iteration order is unspecified
+ *
+ * The interface mimics (a subset of) std::unordered_map's. Keys must not be
+ * modified through an iterator.
+ */
+template <typename Key, typename Type, typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap
+{
+    struct Slot;
+
+public:
+    using key_type = Key;
+    using mapped_type = Type;
+    using value_type = std::pair<Key, Type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    template <bool CONST>
+    class IteratorImpl
+    {
+        using SlotPtr = std::conditional_t<CONST, const Slot*, Slot*>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference
+            = std::conditional_t<CONST, const value_type&, value_type&>;
+        using pointer
+            = std::conditional_t<CONST, const value_type*, value_type*>;
+
+        IteratorImpl() = default;
+
+        // Allow iterator -> const_iterator conversion
+        template <bool THAT_CONST,
+            std::enable_if_t<CONST && !THAT_CONST, int> = 0>
+        IteratorImpl(const IteratorImpl<THAT_CONST>& that)
+            : slot_(that.slot_)
+            , end_(that.end_)
+        {
+        }
+
+        reference operator*() const { return *slot_->get(); }
+        pointer operator->() const { return slot_->get(); }
+
+        IteratorImpl& operator++()
+        {
+            ++slot_;
+            this->skip_empty_();
+
+            return *this;
+        }
+
+        IteratorImpl operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+
+            return old;
+        }
+
+        bool operator==(const IteratorImpl& that) const
+        {
+            return slot_ == that.slot_;
+        }
+
+        bool operator!=(const IteratorImpl& that) const
+        {
+            return slot_ != that.slot_;
+        }
+
+    private:
+        SlotPtr slot_ = nullptr;
+        SlotPtr end_ = nullptr;
+
+        IteratorImpl(SlotPtr slot, SlotPtr end)
+            : slot_(slot)
+            , end_(end)
+        {
+        }
+
+        void skip_empty_()
+        {
+            while (slot_ != end_ && slot_->empty()) {
+                ++slot_;
+            }
+        }
+
+        friend class FlatHashMap;
+        friend class IteratorImpl<!CONST>;
+    };
+
+    using iterator = IteratorImpl<false>;
+    using const_iterator = IteratorImpl<true>;
+
+    FlatHashMap() = default;
+
+    FlatHashMap(const FlatHashMap& that)
+        : FlatHashMap()
+    {
+        this->reserve(that.size());
+
+        for (const auto& value : that) {
+            this->insert_unique_(value_type { value });
+        }
+    }
+
+    FlatHashMap(FlatHashMap&& that) noexcept
+        : slots_(std::move(that.slots_))
+        , capacity_(std::exchange(that.capacity_, 0))
+        , size_(std::exchange(that.size_, 0))
+        , shift_(std::exchange(that.shift_, HASH_BITS_))
+    {
+    }
+
+    ~FlatHashMap() { this->clear(); }
+
+    FlatHashMap& operator=(FlatHashMap that) noexcept
+    {
+        this->swap(that);
+        return *this;
+    }
+
+    void swap(FlatHashMap& that) noexcept
+    {
+        using std::swap;
+
+        swap(slots_, that.slots_);
+        swap(capacity_, that.capacity_);
+        swap(size_, that.size_);
+        swap(shift_, that.shift_);
+    }
+
+    /*
+     * Constructs a new key-value pair from <key> and the arguments if the
+     * key is not already present.
+     *
+     * Returns an iterator to the pair with this key and a bool indicating
+     * whether the insertion took place.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const Key& key, Args&&... args)
+    {
+        auto iter = this->find(key);
+        if (iter != this->end()) {
+            return { iter, false };
+        }
+
+        this->reserve(size_ + 1);
+
+        auto idx = this->insert_unique_(value_type { std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...) });
+
+        return { this->make_iter_(idx), true };
+    }
+
+    template <typename InsertType>
+    std::pair<iterator, bool> insert(const Key& key, InsertType&& value)
+    {
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Erases the pair with key <key>, if there is one, and returns the
+     * number of pairs erased.
+     */
+    size_type erase(const Key& key)
+    {
+        auto idx = this->find_index_(key);
+        if (idx == capacity_) {
+            return 0;
+        }
+
+        this->erase_index_(idx);
+        return 1;
+    }
+
+    void erase(const_iterator iter)
+    {
+        this->erase_index_(static_cast<std::size_t>(iter.slot_ - slots_.get()));
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        return this->make_iter_(this->find_index_(key));
+    }
+
+    iterator find(const Key& key)
+    {
+        return this->make_iter_(this->find_index_(key));
+    }
+
+    bool contains(const Key& key) const
+    {
+        return this->find_index_(key) != capacity_;
+    }
+
+    size_type count(const Key& key) const { return this->contains(key); }
+
+    iterator begin() { return this->make_iter_(0, true); }
+    const_iterator begin() const { return this->make_iter_(0, true); }
+    const_iterator cbegin() const { return this->begin(); }
+
+    iterator end() { return this->make_iter_(capacity_); }
+    const_iterator end() const { return this->make_iter_(capacity_); }
+    const_iterator cend() const { return this->end(); }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return !size_; }
+
+    // Erases all pairs but keeps the allocated slots
+    void clear() noexcept
+    {
+        for (std::size_t i = 0; i != capacity_; ++i) {
+            slots_[i].destroy();
+        }
+
+        size_ = 0;
+    }
+
+    /*
+     * Makes room for (at least) n pairs without exceeding the maximum
+     * load factor.
+     */
+    void reserve(size_type n)
+    {
+        if (n * MAX_LOAD_DEN_ <= capacity_ * MAX_LOAD_NUM_) {
+            return;
+        }
+
+        std::size_t newCapacity = MIN_CAPACITY_;
+        while (n * MAX_LOAD_DEN_ > newCapacity * MAX_LOAD_NUM_) {
+            newCapacity *= 2;
+        }
+
+        this->rehash_(newCapacity);
+    }
+
+private:
+    // Load factor is capped at 7/8, which Robin Hood tolerates well
+    static constexpr std::size_t MAX_LOAD_NUM_ = 7;
+    static constexpr std::size_t MAX_LOAD_DEN_ = 8;
+    static constexpr std::size_t MIN_CAPACITY_ = 8;
+    static constexpr unsigned HASH_BITS_ = 64;
+
+    struct Slot
+    {
+        // 0 marks an empty slot; otherwise, this is the distance from the
+        // element's ideal slot plus one
+        std::uint32_t dist = 0;
+        alignas(value_type) unsigned char data[sizeof(value_type)];
+
+        bool empty() const noexcept { return !dist; }
+
+        value_type* get() noexcept
+        {
+            return std::launder(reinterpret_cast<value_type*>(data));
+        }
+
+        const value_type* get() const noexcept
+        {
+            return std::launder(reinterpret_cast<const value_type*>(data));
+        }
+
+        void construct(value_type&& value, std::uint32_t newDist)
+        {
+            ::new (static_cast<void*>(data)) value_type(std::move(value));
+            dist = newDist;
+        }
+
+        void destroy() noexcept
+        {
+            if (dist) {
+                std::destroy_at(this->get());
+                dist = 0;
+            }
+        }
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+
+    // Fibonacci hashing: the top bits of (hash * golden ratio) pick the
+    // slot, which scatters even poor (e.g. identity) hashes well
+    unsigned shift_ = HASH_BITS_;
+
+    std::size_t home_(const Key& key) const
+    {
+        constexpr std::uint64_t GOLDEN = 0x9E3779B97F4A7C15ull;
+
+        auto hash = static_cast<std::uint64_t>(Hash {}(key));
+        return static_cast<std::size_t>((hash * GOLDEN) >> shift_);
+    }
+
+    std::size_t next_(std::size_t idx) const noexcept
+    {
+        return (idx + 1) & (capacity_ - 1);
+    }
+
+    // Returns capacity_ if the key is absent
+    std::size_t find_index_(const Key& key) const
+    {
+        if (!size_) {
+            return capacity_;
+        }
+
+        auto idx = this->home_(key);
+        for (std::uint32_t dist = 1;; ++dist) {
+            const auto& slot = slots_[idx];
+
+            // If we've gone further than the current occupant, the key
+            // would have displaced it when inserted, so it isn't here
+            if (slot.dist < dist) {
+                return capacity_;
+            }
+            if (KeyEqual {}(slot.get()->first, key)) {
+                return idx;
+            }
+
+            idx = this->next_(idx);
+        }
+    }
+
+    // Assumes the key is absent and that there is room for it. Returns
+    // the index at which the new pair ended up.
+    std::size_t insert_unique_(value_type&& value)
+    {
+        value_type carry = std::move(value);
+        std::size_t placed = capacity_;
+
+        auto idx = this->home_(carry.first);
+        for (std::uint32_t dist = 1;; ++dist) {
+            auto& slot = slots_[idx];
+
+            if (slot.empty()) {
+                slot.construct(std::move(carry), dist);
+                ++size_;
+
+                return (placed == capacity_) ? idx : placed;
+            }
+
+            // Robin Hood: take from the rich (close to home) and give to
+            // the poor (far from home)
+            if (slot.dist < dist) {
+                using std::swap;
+                swap(carry, *slot.get());
+                swap(dist, slot.dist);
+
+                if (placed == capacity_) {
+                    placed = idx;
+                }
+            }
+
+            idx = this->next_(idx);
+        }
+    }
+
+    void erase_index_(std::size_t idx)
+    {
+        slots_[idx].destroy();
+        --size_;
+
+        // Backward-shift the following run so that there are no holes
+        for (auto next = this->next_(idx); slots_[next].dist > 1;
+             next = this->next_(next)) {
+            auto dist = slots_[next].dist;
+
+            slots_[idx].construct(std::move(*slots_[next].get()), dist - 1);
+            slots_[next].destroy();
+
+            idx = next;
+        }
+    }
+
+    void rehash_(std::size_t newCapacity)
+    {
+        auto oldSlots = std::exchange(slots_,
+            std::unique_ptr<Slot[]>(new Slot[newCapacity]));
+        auto oldCapacity = std::exchange(capacity_, newCapacity);
+
+        size_ = 0;
+        shift_ = HASH_BITS_;
+        for (auto cap = newCapacity; cap > 1; cap >>= 1) {
+            --shift_;
+        }
+
+        for (std::size_t i = 0; i != oldCapacity; ++i) {
+            if (!oldSlots[i].empty()) {
+                this->insert_unique_(std::move(*oldSlots[i].get()));
+                oldSlots[i].destroy();
+            }
+        }
+    }
+
+    iterator make_iter_(std::size_t idx, bool skip = false)
+    {
+        iterator iter { slots_.get() + idx, slots_.get() + capacity_ };
+        if (skip) {
+            iter.skip_empty_();
+        }
+
+        return iter;
+    }
+
+    const_iterator make_iter_(std::size_t idx, bool skip = false) const
+    {
+        const_iterator iter { slots_.get() + idx, slots_.get() + capacity_ };
+        if (skip) {
+            iter.skip_empty_();
+        }
+
+        return iter;
+    }
+};
+}
+}
+
+#endif // OKI_FLAT_MAP_H
@@ -1,11 +1,23 @@
 #ifndef OKI_HANDLE_GEN_H
 #define OKI_HANDLE_GEN_H
 
+#include "oki/oki_config.h"
 #include "oki/oki_handle.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <forward_list>
 #include <functional>
-#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace oki {
 namespace intl_ {
@@ -51,6 +63,16 @@ public:
         return oki::intl_::advance(counter_);
     }
 
+    /*
+     * Consumes the next <n> handle values, which are consecutive (i.e.
+     * they are what n calls to oki::intl_::advance() on the returned
+     * handle would produce).
+     */
+    constexpr HandleType create_handles(std::size_t n) noexcept
+    {
+        return oki::intl_::advance(counter_, n);
+    }
+
     /*
      * Semantically, signifies that this Handle will no longer be used.
      * Returns a bool explaining whether the Handle was deleted without
@@ -93,6 +115,12 @@ private:
  * generation/deletion. It is able to catch double-deletes and bad
  * handles so is useful for debugging.
  *
+ * It remembers destroyed handles in a bitmap, split into pages of
+ * PAGE_SIZE handles that are only allocated once one of their handles is
+ * destroyed, and released again once all of them are. So both checks are
+ * O(1), and its memory is bounded by the handles that were issued but not
+ * all destroyed, plus a few bytes per page.
+ *
  * Like LinearHandleGenerator, this option will issue a limited number
  * of handles over its lifespan [currently, that number is exactly
  * std::numeric_limits<HandleType>::max()].
@@ -101,6 +129,8 @@ template <typename HandleType = oki::Handle>
 class DebugHandleGenerator
 {
 public:
+    static constexpr std::size_t PAGE_SIZE = 4096;
+
     // Move-only: Two generators with same state can only be trouble
     DebugHandleGenerator() = default;
 
@@ -124,6 +154,12 @@ public:
         return handleGen_.create_handle();
     }
 
+    // Consumes the next <n> (consecutive) handle values
+    constexpr HandleType create_handles(std::size_t n) noexcept
+    {
+        return handleGen_.create_handles(n);
+    }
+
     /*
      * Returns true if handle destruction was successful.
      * This generator will catch double-deletes and attempts to
@@ -133,8 +169,29 @@ public:
     {
         // Fail if the handle was already deleted (or is the invalid
         // constant)
-        return handleGen_.verify_handle(handle)
-            && invalidHandles_.insert(handle).second;
+        if (!this->verify_handle(handle)) {
+            return false;
+        }
+
+        auto [pageIdx, bit] = locate_(handle);
+        if (pageIdx >= pages_.size()) {
+            pages_.resize(pageIdx + 1);
+            numDestroyed_.resize(pageIdx + 1);
+        }
+
+        auto& page = pages_[pageIdx];
+        if (!page) {
+            page = std::make_unique<Page>();
+        }
+
+        (*page)[bit / WORD_BITS] |= std::uint64_t { 1 } << (bit % WORD_BITS);
+
+        // A page of destroyed handles says no more than its count does
+        if (++numDestroyed_[pageIdx] == PAGE_SIZE) {
+            page.reset();
+        }
+
+        return true;
     }
 
     /*
@@ -144,7 +201,8 @@ public:
     void reset() noexcept
     {
         handleGen_.reset();
-        invalidHandles_.clear();
+        pages_.clear();
+        numDestroyed_.clear();
     }
 
     /*
@@ -156,14 +214,57 @@ public:
      */
     bool verify_handle(const HandleType handle) const noexcept
     {
-        return handleGen_.verify_handle(handle) // Could have been given
-            && !invalidHandles_.count(handle); // Was not deleted
+        if (!handleGen_.verify_handle(handle)) { // Could have been given
+            return false;
+        }
+
+        auto [pageIdx, bit] = locate_(handle);
+        if (pageIdx >= pages_.size()) {
+            return true; // Nothing on this page was deleted
+        }
+
+        if (numDestroyed_[pageIdx] == PAGE_SIZE) {
+            return false; // Everything on this page was
+        }
+
+        return !pages_[pageIdx]
+            || !((*pages_[pageIdx])[bit / WORD_BITS]
+                & (std::uint64_t { 1 } << (bit % WORD_BITS)));
+    }
+
+    // The bytes spent remembering destroyed handles
+    std::size_t memory_usage() const noexcept
+    {
+        std::size_t total = pages_.capacity() * sizeof(pages_[0])
+            + numDestroyed_.capacity() * sizeof(numDestroyed_[0]);
+
+        for (const auto& page : pages_) {
+            total += page ? sizeof(Page) : 0;
+        }
+
+        return total;
     }
 
 private:
-    std::unordered_set<HandleType> invalidHandles_;
+    static constexpr std::size_t WORD_BITS = 64;
+
+    using Page = std::array<std::uint64_t, PAGE_SIZE / WORD_BITS>;
+
+    // One bit per handle, set if destroyed, and how many are
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::vector<std::uint32_t> numDestroyed_;
 
     LinearHandleGenerator<HandleType> handleGen_;
+
+    // The page a handle's bit is on, and which bit it is
+    static std::pair<std::size_t, std::size_t> locate_(
+        HandleType handle) noexcept
+    {
+        auto offset = static_cast<std::size_t>(
+            handle - oki::intl_::get_first_valid_handle<HandleType>());
+
+        return { offset / PAGE_SIZE, offset % PAGE_SIZE };
+    }
 };
 
 /*
@@ -207,6 +308,15 @@ public:
         return handleGen_.create_handle();
     }
 
+    /*
+     * Consumes the next <n> (consecutive) handle values, which never come
+     * from the deleted handles since those are not consecutive.
+     */
+    HandleType create_handles(std::size_t n) noexcept
+    {
+        return handleGen_.create_handles(n);
+    }
+
     /*
      * Returns true if destruction was successful (so the handle can be
      * reused later).
@@ -265,8 +375,509 @@ private:
     LinearHandleGenerator<HandleType> handleGen_;
 };
 
+/*
+ * The handle generator for narrow (e.g. 32-bit) handles, which would
+ * quickly run out if issued linearly.
+ *
+ * Each handle is an index (the low bits) plus a generation (the top
+ * quarter of the bits). Destroying a handle frees its index for reuse
+ * under the next generation, so stale copies of the old handle never
+ * verify. An index whose generation is exhausted is retired rather than
+ * wrapped around. Fresh indices are issued in increasing order.
+ *
+ * Its verify_handle() is exact, so it is as good for debugging as
+ * DebugHandleGenerator, while only costing a few bytes per index.
+ */
+template <typename HandleType = oki::Handle>
+class GenerationalHandleGenerator
+{
+    static_assert(std::is_unsigned_v<HandleType>);
+
+public:
+    static constexpr unsigned GENERATION_BITS = sizeof(HandleType) * 2;
+    static constexpr unsigned INDEX_BITS
+        = sizeof(HandleType) * 8 - GENERATION_BITS;
+
+    static constexpr HandleType MAX_INDEX
+        = (HandleType { 1 } << INDEX_BITS) - 1;
+    static constexpr HandleType MAX_GENERATION
+        = (HandleType { 1 } << GENERATION_BITS) - 1;
+
+    // Move-only: Two generators with same state can only be trouble
+    GenerationalHandleGenerator() = default;
+
+    GenerationalHandleGenerator(
+        const GenerationalHandleGenerator<HandleType>&)
+        = delete;
+
+    GenerationalHandleGenerator(
+        GenerationalHandleGenerator<HandleType>&&) noexcept
+        = default;
+
+    ~GenerationalHandleGenerator() noexcept = default;
+
+    GenerationalHandleGenerator<HandleType>& operator=(
+        const GenerationalHandleGenerator<HandleType>&)
+        = delete;
+
+    GenerationalHandleGenerator<HandleType>& operator=(
+        GenerationalHandleGenerator<HandleType>&&) noexcept
+        = default;
+
+    /*
+     * Reuses the index that has been free the longest, if any, so that
+     * generations advance as slowly as possible.
+     *
+     * Throws std::runtime_error if all MAX_INDEX indices are live.
+     */
+    HandleType create_handle()
+    {
+        if (!freeIndices_.empty()) {
+            auto index = freeIndices_.front();
+            freeIndices_.pop_front();
+
+            auto& slot = slots_[index];
+            slot.alive = true;
+
+            return make_handle_(index, slot.generation);
+        }
+
+        auto index = static_cast<HandleType>(slots_.size());
+        if (index > MAX_INDEX) {
+            throw std::runtime_error("Ran out of handle indices");
+        }
+
+        slots_.push_back({ 0, true });
+        return make_handle_(index, 0);
+    }
+
+    /*
+     * Consumes <n> consecutive handles, which are always fresh indices
+     * (since the free ones are not consecutive).
+     *
+     * Throws std::runtime_error if there are not enough indices left.
+     */
+    HandleType create_handles(std::size_t n)
+    {
+        auto index = static_cast<HandleType>(slots_.size());
+        if (n > MAX_INDEX + std::size_t { 1 } - slots_.size()) {
+            throw std::runtime_error("Ran out of handle indices");
+        }
+
+        slots_.resize(slots_.size() + n, Slot { 0, true });
+        return make_handle_(index, 0);
+    }
+
+    /*
+     * Returns true if handle destruction was successful, which (like in
+     * DebugHandleGenerator) excludes double-deletes and bad handles.
+     */
+    bool destroy_handle(const HandleType handle)
+    {
+        if (!this->verify_handle(handle)) {
+            return false;
+        }
+
+        auto index = handle & MAX_INDEX;
+        auto& slot = slots_[index];
+        slot.alive = false;
+
+        if (slot.generation != MAX_GENERATION) {
+            ++slot.generation;
+            freeIndices_.push_back(index);
+        }
+
+        return true;
+    }
+
+    /*
+     * Returns the generator's state to one equivalent to immediately
+     * after initialization
+     */
+    void reset() noexcept
+    {
+        slots_.assign(1, Slot {});
+        freeIndices_.clear();
+    }
+
+    /*
+     * Returns true if and only if the handle was given by this generator
+     * and has not been deleted.
+     */
+    bool verify_handle(const HandleType handle) const noexcept
+    {
+        auto index = handle & MAX_INDEX;
+        auto generation = handle >> INDEX_BITS;
+
+        return index != 0 && index < slots_.size() && slots_[index].alive
+            && slots_[index].generation == generation;
+    }
+
+private:
+    struct Slot
+    {
+        HandleType generation = 0;
+        bool alive = false;
+    };
+
+    // Index 0 is never issued, so that 0 stays the invalid handle
+    std::vector<Slot> slots_ = std::vector<Slot>(1);
+    std::deque<HandleType> freeIndices_;
+
+    static constexpr HandleType make_handle_(
+        HandleType index, HandleType generation) noexcept
+    {
+        return (generation << INDEX_BITS) | index;
+    }
+};
+
+/*
+ * The handle generator that several threads can create (and destroy)
+ * handles with at once.
+ *
+ * Fresh handles come from an atomic counter, and destroyed ones go to a
+ * shared overflow list (behind a mutex) to be reused. Calling the
+ * generator directly from many threads at once contends on both, so each
+ * thread should instead go through its own Cache, which:
+ *   - Takes fresh handles from the counter a block of BLOCK_SIZE at a time
+ *   - Keeps the handles its thread destroys for reuse, spilling half of
+ *       them to the overflow list whenever it holds more than CACHE_SIZE
+ *   - Refills from the overflow list before taking a new block
+ *   - Hands everything it holds back to the overflow list when flushed or
+ *       destroyed
+ *
+ * thread_cache() gives each thread such a Cache without having to pass one
+ * around; the ComponentManager creates and destroys entities through it.
+ *
+ * Like ReuseHandleGenerator, its verify_handle() only knows whether the
+ * handle could have been given (since destroyed handles may be sitting in
+ * any thread's cache). reset() and moves are not thread-safe, and every
+ * Cache (other than those of thread_cache()) must be gone before either.
+ */
+template <typename HandleType = oki::Handle>
+class ConcurrentHandleGenerator
+{
+public:
+    static constexpr std::size_t BLOCK_SIZE = 64;
+    static constexpr std::size_t CACHE_SIZE = 128;
+
+    // How many generators' caches thread_cache() keeps per thread
+    static constexpr std::size_t THREAD_CACHES = 8;
+
+    class Cache
+    {
+    public:
+        explicit Cache(ConcurrentHandleGenerator<HandleType>& handleGen)
+            : handleGen_(handleGen)
+        {
+        }
+
+        Cache(const Cache&) = delete;
+        Cache& operator=(const Cache&) = delete;
+
+        ~Cache() noexcept { this->flush(); }
+
+        // Consumes a handle, preferring ones this thread destroyed
+        HandleType create_handle()
+        {
+            if (freeHandles_.empty() && next_ == end_) {
+                this->refill_();
+            }
+
+            if (!freeHandles_.empty()) {
+                auto handle = freeHandles_.back();
+                freeHandles_.pop_back();
+
+                return handle;
+            }
+
+            return oki::intl_::advance(next_);
+        }
+
+        /*
+         * Keeps the handle for reuse by this thread. Like
+         * ReuseHandleGenerator, leaks the handle (and returns false)
+         * rather than throw.
+         */
+        bool destroy_handle(const HandleType handle) noexcept
+        {
+            try {
+                freeHandles_.push_back(handle);
+
+                if (freeHandles_.size() > CACHE_SIZE) {
+                    auto half = freeHandles_.begin() + CACHE_SIZE / 2;
+                    handleGen_.give_back_(half, freeHandles_.end());
+                    freeHandles_.erase(half, freeHandles_.end());
+                }
+            } catch (...) {
+                return false;
+            }
+
+            return true;
+        }
+
+        /*
+         * Hands every handle this cache holds (destroyed or not yet
+         * issued) to the shared overflow list, e.g. before a thread goes
+         * idle.
+         */
+        void flush() noexcept
+        {
+            if (freeHandles_.empty() && next_ == end_) {
+                return;
+            }
+
+            try {
+                for (; next_ != end_; oki::intl_::advance(next_)) {
+                    freeHandles_.push_back(next_);
+                }
+
+                handleGen_.give_back_(
+                    freeHandles_.begin(), freeHandles_.end());
+            } catch (...) {
+                // As in destroy_handle(), these are simply leaked
+            }
+
+            freeHandles_.clear();
+            next_ = end_;
+        }
+
+    private:
+        ConcurrentHandleGenerator<HandleType>& handleGen_;
+
+        HandleType next_ = oki::intl_::get_invalid_handle_constant();
+        HandleType end_ = oki::intl_::get_invalid_handle_constant();
+        std::vector<HandleType> freeHandles_;
+
+        void refill_()
+        {
+            handleGen_.take_back_(freeHandles_, CACHE_SIZE / 2);
+
+            if (freeHandles_.empty()) {
+                next_ = handleGen_.create_handles(BLOCK_SIZE);
+                end_ = next_;
+                oki::intl_::advance(end_, BLOCK_SIZE);
+            }
+        }
+
+        // Forgets (leaks) every handle without touching the generator,
+        // which may no longer exist
+        void abandon_() noexcept
+        {
+            freeHandles_.clear();
+            next_ = end_;
+        }
+
+        friend class ConcurrentHandleGenerator<HandleType>;
+    };
+
+    // Move-only: Two generators with same state can only be trouble
+    ConcurrentHandleGenerator() = default;
+
+    ConcurrentHandleGenerator(const ConcurrentHandleGenerator<HandleType>&)
+        = delete;
+
+    ConcurrentHandleGenerator(
+        ConcurrentHandleGenerator<HandleType>&& that) noexcept
+        : id_(next_id_())
+        , counter_(that.counter_.load())
+        , overflowSize_(that.overflowSize_.load())
+        , overflow_(std::move(that.overflow_))
+    {
+        that.reset();
+    }
+
+    ~ConcurrentHandleGenerator() noexcept = default;
+
+    ConcurrentHandleGenerator<HandleType>& operator=(
+        const ConcurrentHandleGenerator<HandleType>&)
+        = delete;
+
+    ConcurrentHandleGenerator<HandleType>& operator=(
+        ConcurrentHandleGenerator<HandleType>&& that) noexcept
+    {
+        id_ = next_id_();
+        counter_ = that.counter_.load();
+        overflowSize_ = that.overflowSize_.load();
+        overflow_ = std::move(that.overflow_);
+        that.reset();
+
+        return *this;
+    }
+
+    // Consumes a handle, reusing a destroyed one if any are available
+    HandleType create_handle()
+    {
+        // Avoid the lock in the common case of there being nothing to reuse
+        if (overflowSize_.load(std::memory_order_relaxed)) {
+            std::lock_guard lock { overflowMutex_ };
+
+            if (!overflow_.empty()) {
+                auto handle = overflow_.back();
+                overflow_.pop_back();
+                overflowSize_.store(
+                    overflow_.size(), std::memory_order_relaxed);
+
+                return handle;
+            }
+        }
+
+        return this->create_handles(1);
+    }
+
+    // Consumes the next <n> (consecutive) handle values
+    HandleType create_handles(std::size_t n) noexcept
+    {
+        return counter_.fetch_add(
+            static_cast<HandleType>(n), std::memory_order_relaxed);
+    }
+
+    /*
+     * Returns true if destruction was successful (so the handle can be
+     * reused later); like ReuseHandleGenerator, leaks it otherwise.
+     */
+    bool destroy_handle(const HandleType handle) noexcept
+    {
+        try {
+            this->give_back_(&handle, &handle + 1);
+        } catch (...) {
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+     * Returns the generator's state to one equivalent to immediately
+     * after initialization
+     */
+    void reset() noexcept
+    {
+        // Orphans every thread_cache() (and the handles in it)
+        id_ = next_id_();
+        counter_ = oki::intl_::get_first_valid_handle<HandleType>();
+        overflowSize_ = 0;
+        overflow_.clear();
+    }
+
+    // The same guarantees as ReuseHandleGenerator, minus the search
+    bool verify_handle(const HandleType handle) const noexcept
+    {
+        return !oki::intl_::is_bad_handle(handle)
+            && std::less<HandleType> {}(
+                handle, counter_.load(std::memory_order_relaxed));
+    }
+
+    /*
+     * Returns the calling thread's Cache for this generator, creating it
+     * on first use.
+     *
+     * Each thread keeps the caches of the last THREAD_CACHES generators it
+     * used. Rather than flush into a generator that may be gone, a cache
+     * that is dropped (when the thread exits, or to make room for another)
+     * leaks the handles it held, as does one orphaned by reset() or a move.
+     */
+    Cache& thread_cache()
+    {
+        thread_local ThreadCaches_ caches;
+        auto& entries = caches.entries;
+
+        // The most recently used cache is last
+        if (!entries.empty() && entries.back().id == id_) {
+            return *entries.back().cache;
+        }
+
+        auto iter = std::find_if(entries.begin(), entries.end(),
+            [this](const auto& entry) { return entry.id == id_; });
+
+        if (iter != entries.end()) {
+            std::rotate(iter, iter + 1, entries.end());
+        } else {
+            if (entries.size() == THREAD_CACHES) {
+                entries.front().cache->abandon_();
+                entries.erase(entries.begin());
+            }
+
+            entries.push_back({ id_, std::make_unique<Cache>(*this) });
+        }
+
+        return *entries.back().cache;
+    }
+
+private:
+    struct ThreadCaches_
+    {
+        struct Entry
+        {
+            std::uint64_t id;
+            std::unique_ptr<Cache> cache;
+        };
+
+        std::vector<Entry> entries;
+
+        ~ThreadCaches_()
+        {
+            for (auto& entry : entries) {
+                entry.cache->abandon_();
+            }
+        }
+    };
+
+    // Tells generators apart in thread_cache() even once one is gone and
+    // another is in its place, so these are never reused
+    std::uint64_t id_ = next_id_();
+
+    std::atomic<HandleType> counter_ {
+        oki::intl_::get_first_valid_handle<HandleType>()
+    };
+
+    std::atomic<std::size_t> overflowSize_ { 0 };
+    std::mutex overflowMutex_;
+    std::vector<HandleType> overflow_;
+
+    static std::uint64_t next_id_() noexcept
+    {
+        static std::atomic<std::uint64_t> nextId { 0 };
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename HandleIt>
+    void give_back_(HandleIt first, HandleIt last)
+    {
+        std::lock_guard lock { overflowMutex_ };
+
+        overflow_.insert(overflow_.end(), first, last);
+        overflowSize_.store(overflow_.size(), std::memory_order_relaxed);
+    }
+
+    void take_back_(std::vector<HandleType>& out, std::size_t n)
+    {
+        if (!overflowSize_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        std::lock_guard lock { overflowMutex_ };
+
+        auto first = overflow_.end() - std::min(n, overflow_.size());
+        out.insert(out.end(), first, overflow_.end());
+        overflow_.erase(first, overflow_.end());
+        overflowSize_.store(overflow_.size(), std::memory_order_relaxed);
+    }
+};
+
+/*
+ * Checked builds trade speed for catching stale handles, and handles too
+ * narrow to be issued linearly are always generational. Concurrent
+ * handles (see oki_config.h) take precedence over both.
+ */
 template <typename HandleType = oki::Handle>
-using DefaultHandleGenerator = LinearHandleGenerator<HandleType>;
+using DefaultHandleGenerator = std::conditional_t<CONCURRENT_HANDLES,
+    ConcurrentHandleGenerator<HandleType>,
+    std::conditional_t<(sizeof(HandleType) < sizeof(std::uint64_t)),
+        GenerationalHandleGenerator<HandleType>,
+        std::conditional_t<oki::intl_::CHECKED,
+            DebugHandleGenerator<HandleType>,
+            LinearHandleGenerator<HandleType>>>>;
 }
 }
 
@@ -0,0 +1,310 @@
+#ifndef OKI_HIERARCHY_H
+#define OKI_HIERARCHY_H
+
+#include "oki/oki_handle.h"
+#include "oki/util/oki_flat_map.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+/*
+ * Parent/child links between handles, stored as parent, first-child and
+ * (doubly linked) sibling links so that attaching and detaching are O(1),
+ * plus a breadth-first order of every handle in the hierarchy: roots
+ * first, then each depth in turn, so every parent comes before its
+ * children. The order is rebuilt lazily, once per batch of changes.
+ *
+ * Only handles that have a parent or a child are stored.
+ */
+template <typename HandleType>
+class Hierarchy
+{
+public:
+    static constexpr std::size_t NO_PARENT
+        = std::numeric_limits<std::size_t>::max();
+
+    // Stands for "no such handle" in the links
+    static constexpr HandleType NONE
+        = get_invalid_handle_constant<HandleType>();
+
+    // One position in the breadth-first order
+    struct Entry
+    {
+        HandleType handle;
+
+        // The parent's position in the order (or NO_PARENT for roots)
+        std::size_t parent;
+    };
+
+    /*
+     * Makes <parent> the parent of <child>, detaching it from its old one.
+     * Throws std::invalid_argument if that would make a cycle.
+     */
+    void attach(HandleType child, HandleType parent)
+    {
+        for (auto ancestor = parent; ancestor != NONE;
+             ancestor = this->parent_of(ancestor)) {
+            if (ancestor == child) {
+                throw std::invalid_argument(
+                    "An entity cannot be its own ancestor");
+            }
+        }
+
+        if (this->parent_of(child) == parent) {
+            return;
+        }
+
+        auto oldParent = this->detach_(child);
+
+        // Make both nodes before taking references (insertions move them)
+        nodes_.emplace(child);
+        nodes_.emplace(parent);
+
+        auto& childNode = this->node_(child);
+        auto& parentNode = this->node_(parent);
+
+        childNode.parent_ = parent;
+        childNode.nextSibling_ = parentNode.firstChild_;
+
+        if (parentNode.firstChild_ != NONE) {
+            this->node_(parentNode.firstChild_).prevSibling_ = child;
+        }
+
+        parentNode.firstChild_ = child;
+
+        this->erase_if_isolated_(oldParent);
+        dirty_ = true;
+    }
+
+    /*
+     * Makes <child> a root again. Returns whether it had a parent.
+     */
+    bool detach(HandleType child)
+    {
+        auto oldParent = this->detach_(child);
+        if (oldParent == NONE) {
+            return false;
+        }
+
+        this->erase_if_isolated_(child);
+        this->erase_if_isolated_(oldParent);
+        dirty_ = true;
+
+        return true;
+    }
+
+    /*
+     * Removes <handle> from the hierarchy altogether: it is detached from
+     * its parent and its children become roots.
+     */
+    void erase(HandleType handle)
+    {
+        if (!nodes_.contains(handle)) {
+            return;
+        }
+
+        auto oldParent = this->detach_(handle);
+
+        // Orphan the children (which does not move any nodes)
+        auto child = this->node_(handle).firstChild_;
+        while (child != NONE) {
+            auto& childNode = this->node_(child);
+            auto next = childNode.nextSibling_;
+
+            childNode.parent_ = NONE;
+            childNode.nextSibling_ = NONE;
+            childNode.prevSibling_ = NONE;
+
+            orphans_.push_back(child);
+            child = next;
+        }
+
+        nodes_.erase(handle);
+        this->erase_if_isolated_(oldParent);
+
+        for (auto orphan : orphans_) {
+            this->erase_if_isolated_(orphan);
+        }
+
+        orphans_.clear();
+        dirty_ = true;
+    }
+
+    // Returns the parent of <handle>, or the invalid handle if it has none
+    HandleType parent_of(HandleType handle) const
+    {
+        auto iter = nodes_.find(handle);
+        return (iter != nodes_.end()) ? iter->second.parent_ : NONE;
+    }
+
+    // Calls func(child) for each child of <parent>, newest first
+    template <typename Callback>
+    void for_each_child(HandleType parent, Callback& func) const
+    {
+        auto iter = nodes_.find(parent);
+        if (iter == nodes_.end()) {
+            return;
+        }
+
+        for (auto child = iter->second.firstChild_; child != NONE;) {
+            // Look up the sibling first, so that func() may detach child
+            auto next = nodes_.find(child)->second.nextSibling_;
+            func(child);
+            child = next;
+        }
+    }
+
+    /*
+     * Appends <root> and all of its descendants to <out>, parents before
+     * children.
+     */
+    void collect_subtree(HandleType root, std::vector<HandleType>& out) const
+    {
+        auto begin = out.size();
+        out.push_back(root);
+
+        for (auto idx = begin; idx != out.size(); ++idx) {
+            auto iter = nodes_.find(out[idx]);
+            if (iter == nodes_.end()) {
+                continue;
+            }
+
+            for (auto child = iter->second.firstChild_; child != NONE;
+                 child = nodes_.find(child)->second.nextSibling_) {
+                out.push_back(child);
+            }
+        }
+    }
+
+    // Returns the breadth-first order, rebuilding it if anything changed
+    const std::vector<Entry>& order()
+    {
+        if (dirty_) {
+            this->rebuild_order_();
+        }
+
+        return order_;
+    }
+
+    /*
+     * Returns the positions in order() sorted by handle, which lets the
+     * hierarchy be matched up against a sorted container in one sweep.
+     * Only valid after a call to order().
+     */
+    const std::vector<std::size_t>& positions_by_handle() const noexcept
+    {
+        return byHandle_;
+    }
+
+    bool empty() const noexcept { return nodes_.empty(); }
+
+    // Returns the number of handles in the hierarchy (roots included)
+    std::size_t size() const noexcept { return nodes_.size(); }
+
+private:
+    struct Node
+    {
+        HandleType parent_ = NONE;
+        HandleType firstChild_ = NONE;
+        HandleType nextSibling_ = NONE;
+        HandleType prevSibling_ = NONE;
+    };
+
+    FlatHashMap<HandleType, Node> nodes_;
+    std::vector<Entry> order_;
+    std::vector<std::size_t> byHandle_;
+    std::vector<HandleType> orphans_;
+    bool dirty_ = false;
+
+    Node& node_(HandleType handle) { return nodes_.find(handle)->second; }
+
+    /*
+     * Unlinks <child> from its parent and siblings without erasing any
+     * nodes. Returns the old parent (or the invalid handle).
+     */
+    HandleType detach_(HandleType child)
+    {
+        auto iter = nodes_.find(child);
+        if (iter == nodes_.end() || iter->second.parent_ == NONE) {
+            return NONE;
+        }
+
+        auto& childNode = iter->second;
+        auto oldParent = childNode.parent_;
+
+        if (childNode.prevSibling_ == NONE) {
+            this->node_(oldParent).firstChild_ = childNode.nextSibling_;
+        } else {
+            this->node_(childNode.prevSibling_).nextSibling_
+                = childNode.nextSibling_;
+        }
+
+        if (childNode.nextSibling_ != NONE) {
+            this->node_(childNode.nextSibling_).prevSibling_
+                = childNode.prevSibling_;
+        }
+
+        childNode.parent_ = NONE;
+        childNode.nextSibling_ = NONE;
+        childNode.prevSibling_ = NONE;
+
+        return oldParent;
+    }
+
+    // A handle with neither a parent nor children need not be stored
+    void erase_if_isolated_(HandleType handle)
+    {
+        auto iter = nodes_.find(handle);
+
+        if (iter != nodes_.end() && iter->second.parent_ == NONE
+            && iter->second.firstChild_ == NONE) {
+            nodes_.erase(handle);
+        }
+    }
+
+    void rebuild_order_()
+    {
+        order_.clear();
+
+        for (const auto& [handle, node] : nodes_) {
+            if (node.parent_ == NONE) {
+                order_.push_back({ handle, NO_PARENT });
+            }
+        }
+
+        // The map's order is arbitrary, so make the roots' predictable
+        std::sort(order_.begin(), order_.end(),
+            [](const auto& lhs, const auto& rhs) {
+                return lhs.handle < rhs.handle;
+            });
+
+        for (std::size_t idx = 0; idx != order_.size(); ++idx) {
+            for (auto child = this->node_(order_[idx].handle).firstChild_;
+                 child != NONE;
+                 child = this->node_(child).nextSibling_) {
+                order_.push_back({ child, idx });
+            }
+        }
+
+        byHandle_.resize(order_.size());
+        for (std::size_t idx = 0; idx != order_.size(); ++idx) {
+            byHandle_[idx] = idx;
+        }
+
+        std::sort(byHandle_.begin(), byHandle_.end(),
+            [this](std::size_t lhs, std::size_t rhs) {
+                return order_[lhs].handle < order_[rhs].handle;
+            });
+
+        dirty_ = false;
+    }
+};
+}
+}
+
+#endif // OKI_HIERARCHY_H
@@ -0,0 +1,298 @@
+#ifndef OKI_INDEXED_VECTOR_H
+#define OKI_INDEXED_VECTOR_H
+
+#include "oki/oki_index.h"
+#include "oki/util/oki_container.h"
+
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace oki {
+namespace intl_ {
+/*
+ * The indexed (see oki_index.h) counterpart to AssocSortedVector: the same
+ * sorted array, plus one index per declared field that every insertion,
+ * assignment and erasure keeps up to date.
+ *
+ * It has the same interface as AssocSortedVector except that values
+ * cannot be changed in place (only replaced with insert_or_assign()), so
+ * its iterator is the const_iterator.
+ */
+template <typename Key, typename Type,
+    typename IndexList = typename oki::IndexedBy<Type>::List>
+class IndexedSortedVector;
+
+template <typename Key, typename Type, typename... IndexTypes>
+class IndexedSortedVector<Key, Type, oki::Indexes<IndexTypes...>>
+{
+    using Data = oki::intl_::AssocSortedVector<Key, Type>;
+
+    static constexpr std::size_t NO_INDEX
+        = std::numeric_limits<std::size_t>::max();
+
+public:
+    using key_type = Key;
+    using mapped_type = Type;
+    using value_type = std::pair<Key, Type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = typename Data::const_iterator;
+    using const_iterator = typename Data::const_iterator;
+
+    /*
+     * Inserts a new key-value pair into the container, where the value is
+     * constructed from the arguments.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Key key, Args&&... args)
+    {
+        auto [iter, inserted] = data_.emplace(key, std::forward<Args>(args)...);
+        if (inserted) {
+            this->index_(key, iter->second);
+        }
+
+        return { iter, inserted };
+    }
+
+    template <typename InsertType>
+    std::pair<iterator, bool> insert(Key key, InsertType&& value)
+    {
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Guarantees that a pair with key value <key> holds the value <value>,
+     * moving it to the right place in every index.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename InsertType>
+    std::pair<iterator, bool> insert_or_assign(Key key, InsertType&& value)
+    {
+        auto iter = data_.lower_bound(key);
+        if (iter != data_.end() && iter->first == key) {
+            this->unindex_(key, iter->second);
+            iter->second = std::forward<InsertType>(value);
+            this->index_(key, iter->second);
+
+            return { iter, false };
+        }
+
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Emplaces a key-value pair under the assumption that no item with
+     * that <key> already exists in the container. Does not check.
+     *
+     * Returns an iterator to the newly inserted pair.
+     */
+    template <typename... Args>
+    iterator emplace_unchecked(Key key, Args&&... args)
+    {
+        auto iter = data_.emplace_unchecked(key, std::forward<Args>(args)...);
+        this->index_(key, iter->second);
+
+        return iter;
+    }
+
+    template <typename InsertType>
+    iterator insert_unchecked(Key key, InsertType&& value)
+    {
+        return this->emplace_unchecked(key, std::forward<InsertType>(value));
+    }
+
+    // See AssocSortedVector::append_unchecked()
+    template <typename... Args>
+    void append_unchecked(Key key, Args&&... args)
+    {
+        data_.append_unchecked(key, std::forward<Args>(args)...);
+        this->index_(key, std::prev(data_.end())->second);
+    }
+
+    // See AssocSortedVector::merge_appended()
+    void merge_appended(std::size_t oldSize) { data_.merge_appended(oldSize); }
+
+    /*
+     * Erases every pair whose key is in the sorted range [first, last) in
+     * a single pass, returning how many were erased.
+     */
+    template <typename KeyIt>
+    std::size_t erase_sorted(KeyIt first, KeyIt last)
+    {
+        // Unindex the values first (searching onward from the last hit)
+        auto hint = data_.cbegin();
+        for (auto keyIter = first; keyIter != last; ++keyIter) {
+            hint = std::as_const(data_).lower_bound(*keyIter, hint);
+
+            if (hint != data_.cend() && hint->first == *keyIter) {
+                this->unindex_(hint->first, hint->second);
+            }
+        }
+
+        return data_.erase_sorted(first, last);
+    }
+
+    /*
+     * Attempts to erase a pair with key <key>. Does nothing if <key> is not
+     * present.
+     */
+    bool erase(Key key)
+    {
+        auto iter = this->find(key);
+        if (iter == this->end()) {
+            return false;
+        }
+
+        this->erase(iter);
+        return true;
+    }
+
+    /*
+     * Erases the pair at <pos> and returns an iterator to the pair after it.
+     */
+    iterator erase(const_iterator pos)
+    {
+        this->unindex_(pos->first, pos->second);
+        return data_.erase(pos);
+    }
+
+    const_iterator find(Key key) const noexcept { return data_.find(key); }
+
+    const_iterator lower_bound(Key key) const noexcept
+    {
+        return data_.lower_bound(key);
+    }
+
+    // See AssocSortedVector::lower_bound()
+    const_iterator lower_bound(Key key, const_iterator hint) const noexcept
+    {
+        return data_.lower_bound(key, hint);
+    }
+
+    // See AssocSortedVector::lower_bound_batch()
+    template <typename KeyIt, typename OutputIt>
+    OutputIt lower_bound_batch(KeyIt first, KeyIt last, OutputIt out) const
+    {
+        return data_.lower_bound_batch(first, last, out);
+    }
+
+    bool contains(Key key) const noexcept { return data_.contains(key); }
+
+    /*
+     * Returns the lowest key whose MEMBER field equals <value> (or nullptr),
+     * using a HashIndex on it if there is one and an OrderedIndex if not.
+     */
+    template <auto MEMBER>
+    const Key* find_first(const FieldOf<MEMBER>& value)
+    {
+        return this->equality_index_<MEMBER>().find_first(value);
+    }
+
+    // Calls func(key) for each key whose MEMBER field equals <value>
+    template <auto MEMBER, typename Callback>
+    void for_each_equal(const FieldOf<MEMBER>& value, Callback& func)
+    {
+        this->equality_index_<MEMBER>().for_each_equal(value, func);
+    }
+
+    /*
+     * Calls func(key) for each key whose MEMBER field is in [lo, hi), in
+     * order of field value. Requires an OrderedIndex on it.
+     */
+    template <auto MEMBER, typename Callback>
+    void for_each_in_range(
+        const FieldOf<MEMBER>& lo, const FieldOf<MEMBER>& hi, Callback& func)
+    {
+        constexpr auto IDX = find_index_<MEMBER, true>();
+        static_assert(IDX != NO_INDEX,
+            "Range lookups require an OrderedIndex on the field");
+
+        std::get<IDX>(indexes_).for_each_in_range(lo, hi, func);
+    }
+
+    const_iterator begin() const { return data_.cbegin(); }
+    const_iterator cbegin() const { return data_.cbegin(); }
+    const_iterator end() const { return data_.cend(); }
+    const_iterator cend() const { return data_.cend(); }
+
+    std::size_t size() const noexcept { return data_.size(); }
+
+    void clear() noexcept
+    {
+        data_.clear();
+        std::apply([](auto&... indexes) { (indexes.clear(), ...); }, indexes_);
+    }
+
+    void reserve(std::size_t n) { data_.reserve(n); }
+    std::size_t capacity() const noexcept { return data_.capacity(); }
+    void shrink_to_fit() { data_.shrink_to_fit(); }
+
+    // Returns the number of bytes allocated for pairs and indexes
+    std::size_t memory_usage() const noexcept
+    {
+        return data_.memory_usage()
+            + std::apply(
+                [](const auto&... indexes) {
+                    return (std::size_t { 0 } + ... + indexes.memory_usage());
+                },
+                indexes_);
+    }
+
+private:
+    Data data_;
+    std::tuple<typename IndexTypes::template Store<Key>...> indexes_;
+
+    void index_(Key key, const Type& value)
+    {
+        std::apply([&](auto&... indexes) { (indexes.insert(key, value), ...); },
+            indexes_);
+    }
+
+    void unindex_(Key key, const Type& value)
+    {
+        std::apply([&](auto&... indexes) { (indexes.erase(key, value), ...); },
+            indexes_);
+    }
+
+    // The position of the index on MEMBER of the given kind, or NO_INDEX
+    template <auto MEMBER, bool ORDERED>
+    static constexpr std::size_t find_index_() noexcept
+    {
+        std::size_t idx = 0;
+        std::size_t found = NO_INDEX;
+
+        ((found = (found == NO_INDEX && IndexTypes::ORDERED == ORDERED
+                      && same_member<IndexTypes::member, MEMBER>())
+                 ? idx
+                 : found,
+             ++idx),
+            ...);
+
+        return found;
+    }
+
+    template <auto MEMBER>
+    auto& equality_index_()
+    {
+        constexpr auto HASHED = find_index_<MEMBER, false>();
+        constexpr auto ORDERED = find_index_<MEMBER, true>();
+        static_assert(HASHED != NO_INDEX || ORDERED != NO_INDEX,
+            "Lookups by field require an index on the field");
+
+        return std::get<(HASHED != NO_INDEX) ? HASHED : ORDERED>(indexes_);
+    }
+};
+}
+}
+
+#endif // OKI_INDEXED_VECTOR_H
@@ -0,0 +1,270 @@
+#ifndef OKI_PARALLEL_H
+#define OKI_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+/*
+ * Conservative guess at the size of a cache line. We avoid
+ * std::hardware_destructive_interference_size because support is spotty
+ * and some compilers warn about it changing between versions.
+ */
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/*
+ * Wraps a value so that it occupies (at least) its own cache line, meaning
+ * an array of them can be written from several threads without any false
+ * sharing.
+ */
+template <typename Type>
+struct alignas(CACHE_LINE_SIZE) CacheAligned
+{
+    Type value;
+};
+
+/*
+ * Decides how many threads are worth using to process n items, given that
+ * each thread should have at least minPerWorker of them (handing work to
+ * another thread is far from free, so small inputs stay on the calling
+ * thread).
+ */
+inline std::size_t choose_num_workers(
+    std::size_t n, std::size_t minPerWorker) noexcept
+{
+    std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t useful = n / std::max<std::size_t>(1, minPerWorker);
+
+    return std::max<std::size_t>(1, std::min(hardware, useful));
+}
+
+/*
+ * A thread that runs the same task over and over, once per run(). Unlike
+ * starting a thread each time, this keeps whatever the thread holds on to
+ * between runs (e.g. its thread_scratch()).
+ *
+ * run() returns at once; wait() blocks until the task is done and rethrows
+ * whatever it threw. Destroying the Worker waits for the task, too.
+ */
+template <typename Task>
+class Worker
+{
+public:
+    explicit Worker(Task task)
+        : task_(std::move(task))
+        , thread_([this]() { this->loop_(); })
+    {
+    }
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    ~Worker()
+    {
+        {
+            std::lock_guard lock { mutex_ };
+            stopping_ = true;
+        }
+
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void run()
+    {
+        {
+            std::lock_guard lock { mutex_ };
+            pending_ = true;
+        }
+
+        wake_.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock lock { mutex_ };
+        done_.wait(lock, [this]() { return !pending_; });
+
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+private:
+    Task task_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    bool pending_ = false;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+
+    // Last, so that everything it uses exists by the time it starts
+    std::thread thread_;
+
+    void loop_()
+    {
+        std::unique_lock lock { mutex_ };
+
+        while (true) {
+            wake_.wait(lock, [this]() { return pending_ || stopping_; });
+            if (!pending_) {
+                return;
+            }
+
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                task_();
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            error_ = error;
+            pending_ = false;
+            done_.notify_all();
+        }
+    }
+};
+
+/*
+ * A few Workers shared by every parallel loop in the process, so that a
+ * loop run every frame hands its chunks to threads that already exist
+ * rather than starting (and joining) new ones each time.
+ *
+ * One loop uses the pool at a time. A loop that finds it in use (e.g. one
+ * nested in another, or on another thread) is told so and should run
+ * serially, since the pool's threads are busy already.
+ */
+class WorkerPool
+{
+public:
+    // The pool used by parallel_for_chunks()
+    static WorkerPool& shared()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    /*
+     * Calls func(task) for each task in [0, numTasks), task 0 on the
+     * calling thread and each other on a Worker of its own (started the
+     * first time it is needed). func() must not throw.
+     *
+     * Blocks until every task is done. Returns false, having called
+     * nothing, if the pool is in use.
+     */
+    template <typename Function>
+    bool try_run(std::size_t numTasks, Function& func)
+    {
+        // (Not a mutex, which the thread that holds it may not try again)
+        if (busy_.exchange(true, std::memory_order_acquire)) {
+            return false;
+        }
+
+        struct Release
+        {
+            std::atomic<bool>& busy;
+            ~Release() { busy.store(false, std::memory_order_release); }
+        } release { busy_ };
+
+        while (workers_.size() + 1 < numTasks) {
+            auto task = Task { this, workers_.size() + 1 };
+            workers_.push_back(std::make_unique<Worker<Task>>(task));
+        }
+
+        job_ = &func;
+        call_ = [](void* job, std::size_t task) {
+            (*static_cast<Function*>(job))(task);
+        };
+
+        for (std::size_t task = 1; task < numTasks; ++task) {
+            workers_[task - 1]->run();
+        }
+
+        func(std::size_t { 0 });
+
+        for (std::size_t task = 1; task < numTasks; ++task) {
+            workers_[task - 1]->wait();
+        }
+
+        return true;
+    }
+
+private:
+    struct Task
+    {
+        WorkerPool* pool;
+        std::size_t task;
+
+        void operator()() const { pool->call_(pool->job_, task); }
+    };
+
+    std::atomic<bool> busy_ { false };
+    std::vector<std::unique_ptr<Worker<Task>>> workers_;
+
+    // The current loop, which workers only read between run() and wait()
+    void* job_ = nullptr;
+    void (*call_)(void*, std::size_t) = nullptr;
+};
+
+/*
+ * Splits [0, n) into numChunks contiguous chunks of (nearly) equal size and
+ * calls func(chunkIndex, chunkBegin, chunkEnd) for each, one chunk per
+ * thread of the WorkerPool. The calling thread processes the first chunk
+ * itself. If the pool is in use, every chunk runs on the calling thread
+ * instead (still in chunks, so the results are the same).
+ *
+ * Blocks until every chunk is done. If any call throws, the first such
+ * exception (by chunk index) is rethrown once all chunks are done.
+ */
+template <typename Function>
+void parallel_for_chunks(std::size_t n, std::size_t numChunks, Function func)
+{
+    numChunks = std::max<std::size_t>(1, std::min(n, numChunks));
+
+    auto chunk_begin = [=](std::size_t chunk) { return n * chunk / numChunks; };
+
+    if (numChunks == 1) {
+        func(std::size_t { 0 }, std::size_t { 0 }, n);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(numChunks);
+
+    auto run_chunk = [&](std::size_t chunk) {
+        try {
+            func(chunk, chunk_begin(chunk), chunk_begin(chunk + 1));
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    if (!WorkerPool::shared().try_run(numChunks, run_chunk)) {
+        for (std::size_t chunk = 0; chunk != numChunks; ++chunk) {
+            run_chunk(chunk);
+        }
+    }
+
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+}
+}
+
+#endif // OKI_PARALLEL_H
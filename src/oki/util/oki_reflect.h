@@ -0,0 +1,135 @@
+#ifndef OKI_REFLECT_H
+#define OKI_REFLECT_H
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace oki {
+namespace intl_ {
+/*
+ * Just enough reflection to take a plain aggregate (like
+ * struct Vec { float x, y; }) apart field by field: num_fields() counts its
+ * fields by trying to brace-initialize it, and tie_fields() binds them to a
+ * tuple of references with structured bindings.
+ *
+ * This only works for aggregates of up to MAX_FIELDS public, non-aggregate
+ * fields (e.g. scalars); a nested aggregate would swallow several
+ * initializers through brace elision and throw the count off.
+ */
+constexpr std::size_t MAX_FIELDS = 12;
+
+namespace helper_ {
+// Converts to anything, so can stand in for any field's initializer
+struct AnyField
+{
+    template <typename Type>
+    operator Type() const;
+};
+
+template <typename Type, typename Indices, typename = void>
+struct IsBraceConstructible : std::false_type
+{ };
+
+template <typename Type, std::size_t... Is>
+struct IsBraceConstructible<Type, std::index_sequence<Is...>,
+    std::void_t<decltype(Type { ((void)Is, AnyField {})... })>>
+    : std::true_type
+{ };
+
+template <typename Type, std::size_t N>
+constexpr std::size_t count_fields()
+{
+    if constexpr (N == 0
+        || IsBraceConstructible<Type, std::make_index_sequence<N>>::value) {
+        return N;
+    } else {
+        return count_fields<Type, N - 1>();
+    }
+}
+}
+
+template <typename Type>
+constexpr std::size_t num_fields()
+{
+    static_assert(std::is_aggregate_v<Type>,
+        "Only aggregates can be taken apart into their fields");
+    static_assert(!helper_::IsBraceConstructible<Type,
+                      std::make_index_sequence<MAX_FIELDS + 1>>::value,
+        "Aggregate has too many fields to be taken apart");
+
+    return helper_::count_fields<Type, MAX_FIELDS>();
+}
+
+/*
+ * Returns a std::tuple of references to the fields of <value>, in
+ * declaration order.
+ */
+template <typename Type>
+auto tie_fields(Type& value) noexcept
+{
+    constexpr std::size_t N = num_fields<std::remove_const_t<Type>>();
+    static_assert(N != 0, "Cannot take apart an aggregate with no fields");
+
+    if constexpr (N == 1) {
+        auto& [f0] = value;
+        return std::tie(f0);
+    } else if constexpr (N == 2) {
+        auto& [f0, f1] = value;
+        return std::tie(f0, f1);
+    } else if constexpr (N == 3) {
+        auto& [f0, f1, f2] = value;
+        return std::tie(f0, f1, f2);
+    } else if constexpr (N == 4) {
+        auto& [f0, f1, f2, f3] = value;
+        return std::tie(f0, f1, f2, f3);
+    } else if constexpr (N == 5) {
+        auto& [f0, f1, f2, f3, f4] = value;
+        return std::tie(f0, f1, f2, f3, f4);
+    } else if constexpr (N == 6) {
+        auto& [f0, f1, f2, f3, f4, f5] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5);
+    } else if constexpr (N == 7) {
+        auto& [f0, f1, f2, f3, f4, f5, f6] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6);
+    } else if constexpr (N == 8) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+    } else if constexpr (N == 9) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+    } else if constexpr (N == 10) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+    } else if constexpr (N == 11) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+    } else {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+    }
+}
+
+// std::tuple<Fields&...> for an aggregate type
+template <typename Type>
+using FieldRefs = decltype(oki::intl_::tie_fields(std::declval<Type&>()));
+
+namespace helper_ {
+template <typename Refs>
+struct FieldValues;
+
+template <typename... Fields>
+struct FieldValues<std::tuple<Fields&...>>
+{
+    using type = std::tuple<Fields...>;
+};
+}
+
+// std::tuple<Fields...> for an aggregate type
+template <typename Type>
+using FieldTypes = typename helper_::FieldValues<FieldRefs<Type>>::type;
+}
+}
+
+#endif // OKI_REFLECT_H
@@ -0,0 +1,609 @@
+#ifndef OKI_SHARED_VECTOR_H
+#define OKI_SHARED_VECTOR_H
+
+#include "oki/util/oki_container.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace oki {
+namespace intl_ {
+/*
+ * The shared (see oki_shared.h) counterpart to AssocSortedVector: a sorted
+ * array of (key, slot) pairs alongside a pool holding each distinct value
+ * once, with a reference count per slot. Equal values are found through a
+ * hash table of slots (hashing and comparing the values in the pool, so
+ * that it holds no copies of its own), so inserting costs a hash lookup on
+ * top of the usual.
+ *
+ * It has the same interface as AssocSortedVector except that its
+ * iterators are proxies: dereferencing one yields a
+ * std::pair<Key, const Type&> by value, since values cannot be changed in
+ * place (only replaced with insert_or_assign()).
+ */
+template <typename Key, typename Type>
+class SharedSortedVector
+{
+    using Slot = std::uint32_t;
+    using Entries = oki::intl_::AssocSortedVector<Key, Slot>;
+
+public:
+    using key_type = Key;
+    using mapped_type = Type;
+    using value_type = std::pair<Key, Type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template <bool CONST>
+    class IteratorImpl
+    {
+        using Base = std::conditional_t<CONST, typename Entries::const_iterator,
+            typename Entries::iterator>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = SharedSortedVector::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<Key, const Type&>;
+
+        // What operator->() returns, since there is no pair to point to
+        struct pointer
+        {
+            reference pair;
+
+            reference* operator->() noexcept { return &pair; }
+        };
+
+        IteratorImpl() = default;
+
+        // Allow iterator -> const_iterator conversion
+        template <bool THAT_CONST,
+            std::enable_if_t<CONST && !THAT_CONST, int> = 0>
+        IteratorImpl(const IteratorImpl<THAT_CONST>& that)
+            : base_(that.base_)
+            , values_(that.values_)
+        {
+        }
+
+        reference operator*() const
+        {
+            return { base_->first, values_[base_->second] };
+        }
+
+        pointer operator->() const { return pointer { **this }; }
+
+        reference operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        IteratorImpl& operator++()
+        {
+            ++base_;
+            return *this;
+        }
+
+        IteratorImpl operator++(int)
+        {
+            auto old = *this;
+            ++base_;
+
+            return old;
+        }
+
+        IteratorImpl& operator--()
+        {
+            --base_;
+            return *this;
+        }
+
+        IteratorImpl operator--(int)
+        {
+            auto old = *this;
+            --base_;
+
+            return old;
+        }
+
+        IteratorImpl& operator+=(difference_type n)
+        {
+            base_ += n;
+            return *this;
+        }
+
+        IteratorImpl& operator-=(difference_type n)
+        {
+            base_ -= n;
+            return *this;
+        }
+
+        friend IteratorImpl operator+(IteratorImpl iter, difference_type n)
+        {
+            return iter += n;
+        }
+
+        friend IteratorImpl operator+(difference_type n, IteratorImpl iter)
+        {
+            return iter += n;
+        }
+
+        friend IteratorImpl operator-(IteratorImpl iter, difference_type n)
+        {
+            return iter -= n;
+        }
+
+        friend difference_type operator-(
+            const IteratorImpl& lhs, const IteratorImpl& rhs)
+        {
+            return lhs.base_ - rhs.base_;
+        }
+
+        bool operator==(const IteratorImpl& that) const
+        {
+            return base_ == that.base_;
+        }
+
+        bool operator!=(const IteratorImpl& that) const
+        {
+            return base_ != that.base_;
+        }
+
+        bool operator<(const IteratorImpl& that) const
+        {
+            return base_ < that.base_;
+        }
+
+        bool operator>(const IteratorImpl& that) const
+        {
+            return base_ > that.base_;
+        }
+
+        bool operator<=(const IteratorImpl& that) const
+        {
+            return base_ <= that.base_;
+        }
+
+        bool operator>=(const IteratorImpl& that) const
+        {
+            return base_ >= that.base_;
+        }
+
+    private:
+        Base base_ {};
+        const Type* values_ = nullptr;
+
+        IteratorImpl(Base base, const Type* values)
+            : base_(base)
+            , values_(values)
+        {
+        }
+
+        friend class SharedSortedVector;
+        friend class IteratorImpl<!CONST>;
+    };
+
+    using iterator = IteratorImpl<false>;
+    using const_iterator = IteratorImpl<true>;
+    using reference = typename iterator::reference;
+    using const_reference = typename const_iterator::reference;
+
+    /*
+     * Inserts a new key-value pair into the container, where the value is
+     * constructed from the arguments (and shared if an equal one exists).
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Key key, Args&&... args)
+    {
+        auto iter = entries_.lower_bound(key);
+        if (iter != entries_.end() && iter->first == key) {
+            return { this->wrap_(iter), false };
+        }
+
+        auto slot = this->acquire_(std::forward<Args>(args)...);
+        return { this->wrap_(entries_.emplace(key, slot).first), true };
+    }
+
+    template <typename InsertType>
+    std::pair<iterator, bool> insert(Key key, InsertType&& value)
+    {
+        return this->emplace(key, std::forward<InsertType>(value));
+    }
+
+    /*
+     * Guarantees that a pair with key value <key> holds the value <value>.
+     *
+     * Either inserts and returns an iterator to the newly inserted pair + a
+     * 'true' value, or returns an iterator the old pair and a 'false'
+     * value.
+     */
+    template <typename InsertType>
+    std::pair<iterator, bool> insert_or_assign(Key key, InsertType&& value)
+    {
+        auto slot = this->acquire_(std::forward<InsertType>(value));
+        auto iter = entries_.lower_bound(key);
+
+        if (iter != entries_.end() && iter->first == key) {
+            this->release_(iter->second);
+            iter->second = slot;
+
+            return { this->wrap_(iter), false };
+        }
+
+        return { this->wrap_(entries_.emplace(key, slot).first), true };
+    }
+
+    /*
+     * Emplaces a key-value pair under the assumption that no item with
+     * that <key> already exists in the container. Does not check.
+     *
+     * Returns an iterator to the newly inserted pair.
+     */
+    template <typename... Args>
+    iterator emplace_unchecked(Key key, Args&&... args)
+    {
+        auto slot = this->acquire_(std::forward<Args>(args)...);
+        return this->wrap_(entries_.emplace_unchecked(key, slot));
+    }
+
+    template <typename InsertType>
+    iterator insert_unchecked(Key key, InsertType&& value)
+    {
+        return this->emplace_unchecked(key, std::forward<InsertType>(value));
+    }
+
+    // See AssocSortedVector::append_unchecked()
+    template <typename... Args>
+    void append_unchecked(Key key, Args&&... args)
+    {
+        auto slot = this->acquire_(std::forward<Args>(args)...);
+        entries_.append_unchecked(key, slot);
+    }
+
+    // See AssocSortedVector::merge_appended()
+    void merge_appended(std::size_t oldSize)
+    {
+        entries_.merge_appended(oldSize);
+    }
+
+    /*
+     * Erases every pair whose key is in the sorted range [first, last) in
+     * a single pass, returning how many were erased.
+     */
+    template <typename KeyIt>
+    std::size_t erase_sorted(KeyIt first, KeyIt last)
+    {
+        // Give back the values first (searching onward from the last hit)
+        auto hint = entries_.cbegin();
+        for (auto keyIter = first; keyIter != last; ++keyIter) {
+            hint = std::as_const(entries_).lower_bound(*keyIter, hint);
+
+            if (hint != entries_.cend() && hint->first == *keyIter) {
+                this->release_(hint->second);
+            }
+        }
+
+        return entries_.erase_sorted(first, last);
+    }
+
+    /*
+     * Attempts to erase a pair with key <key>. Does nothing if <key> is not
+     * present.
+     */
+    bool erase(Key key)
+    {
+        auto iter = entries_.find(key);
+        if (iter == entries_.end()) {
+            return false;
+        }
+
+        this->release_(iter->second);
+        entries_.erase(iter);
+
+        return true;
+    }
+
+    /*
+     * Erases the pair at <pos> and returns an iterator to the pair after it.
+     */
+    iterator erase(const_iterator pos)
+    {
+        this->release_(pos.base_->second);
+        return this->wrap_(entries_.erase(pos.base_));
+    }
+
+    const_iterator find(Key key) const noexcept
+    {
+        return this->wrap_(entries_.find(key));
+    }
+
+    iterator find(Key key) noexcept { return this->wrap_(entries_.find(key)); }
+
+    const_iterator lower_bound(Key key) const noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key));
+    }
+
+    iterator lower_bound(Key key) noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key));
+    }
+
+    // See AssocSortedVector::lower_bound()
+    const_iterator lower_bound(Key key, const_iterator hint) const noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key, hint.base_));
+    }
+
+    iterator lower_bound(Key key, const_iterator hint) noexcept
+    {
+        return this->wrap_(entries_.lower_bound(key, hint.base_));
+    }
+
+    // See AssocSortedVector::lower_bound_batch()
+    template <typename KeyIt, typename OutputIt>
+    OutputIt lower_bound_batch(KeyIt first, KeyIt last, OutputIt out) const
+    {
+        return entries_.lower_bound_batch(first, last, out);
+    }
+
+    bool contains(Key key) const noexcept { return entries_.contains(key); }
+
+    /*
+     * Calls func(value, first, last) once per distinct value, where
+     * [first, last) are the (ascending) positions of the pairs that share
+     * it. Costs a counting sort of the pairs by value.
+     */
+    template <typename Callback>
+    void for_each_group(Callback& func) const
+    {
+        // Count the pairs per slot, then turn the counts into offsets
+        std::vector<std::size_t> offsets(values_.size() + 1);
+        for (auto iter = entries_.cbegin(); iter != entries_.cend(); ++iter) {
+            ++offsets[iter->second + 1];
+        }
+
+        for (std::size_t slot = 0; slot != values_.size(); ++slot) {
+            offsets[slot + 1] += offsets[slot];
+        }
+
+        std::vector<std::size_t> grouped(entries_.size());
+        auto next = offsets;
+
+        for (std::size_t pos = 0; pos != entries_.size(); ++pos) {
+            grouped[next[entries_.cbegin()[pos].second]++] = pos;
+        }
+
+        for (std::size_t slot = 0; slot != values_.size(); ++slot) {
+            if (offsets[slot] != offsets[slot + 1]) {
+                func(values_[slot], grouped.data() + offsets[slot],
+                    grouped.data() + offsets[slot + 1]);
+            }
+        }
+    }
+
+    // The number of distinct values held
+    std::size_t num_values() const noexcept { return numValues_; }
+
+    iterator begin() { return this->wrap_(entries_.begin()); }
+    const_iterator begin() const { return this->wrap_(entries_.cbegin()); }
+    const_iterator cbegin() const { return this->begin(); }
+    iterator end() { return this->wrap_(entries_.end()); }
+    const_iterator end() const { return this->wrap_(entries_.cend()); }
+    const_iterator cend() const { return this->end(); }
+
+    std::size_t size() const noexcept { return entries_.size(); }
+
+    void clear() noexcept
+    {
+        entries_.clear();
+        values_.clear();
+        refCounts_.clear();
+        hashes_.clear();
+        freeSlots_.clear();
+
+        std::fill(lookup_.begin(), lookup_.end(), NO_SLOT_);
+        numValues_ = 0;
+    }
+
+    void reserve(std::size_t n) { entries_.reserve(n); }
+    std::size_t capacity() const noexcept { return entries_.capacity(); }
+
+    void shrink_to_fit()
+    {
+        entries_.shrink_to_fit();
+        values_.shrink_to_fit();
+        refCounts_.shrink_to_fit();
+        hashes_.shrink_to_fit();
+        freeSlots_.shrink_to_fit();
+    }
+
+    /*
+     * Returns the number of bytes allocated for pairs and values (used or
+     * not), not counting memory the values own themselves.
+     */
+    std::size_t memory_usage() const noexcept
+    {
+        return entries_.memory_usage() + values_.capacity() * sizeof(Type)
+            + refCounts_.capacity() * sizeof(std::uint32_t)
+            + hashes_.capacity() * sizeof(std::size_t)
+            + freeSlots_.capacity() * sizeof(Slot)
+            + lookup_.capacity() * sizeof(Slot);
+    }
+
+private:
+    static constexpr Slot NO_SLOT_ = std::numeric_limits<Slot>::max();
+
+    // Load factor is capped at 7/8, as in FlatHashMap
+    static constexpr std::size_t MAX_LOAD_NUM_ = 7;
+    static constexpr std::size_t MAX_LOAD_DEN_ = 8;
+    static constexpr std::size_t MIN_LOOKUP_ = 8;
+
+    Entries entries_;
+
+    // The pool: a value, reference count and hash per slot (0 for a free
+    // slot, whose stale value is overwritten when it is reused)
+    std::vector<Type> values_;
+    std::vector<std::uint32_t> refCounts_;
+    std::vector<std::size_t> hashes_;
+    std::vector<Slot> freeSlots_;
+
+    // The slots in use, by the hash of their value (linear probing, with
+    // NO_SLOT_ where empty). Its size is zero or a power of two.
+    std::vector<Slot> lookup_;
+    std::size_t numValues_ = 0;
+    unsigned shift_ = 64;
+
+    template <typename Base>
+    auto wrap_(Base base) const
+    {
+        return IteratorImpl<!std::is_same_v<Base, typename Entries::iterator>> {
+            base, values_.data()
+        };
+    }
+
+    // Finds (or adds) the slot of a value and takes a reference to it
+    template <typename... Args>
+    Slot acquire_(Args&&... args)
+    {
+        Type value { std::forward<Args>(args)... };
+        auto hash = std::hash<Type> {}(value);
+
+        auto found = this->find_slot_(value, hash);
+        if (found != NO_SLOT_) {
+            ++refCounts_[found];
+            return found;
+        }
+
+        // Make room first, so that nothing below fails halfway
+        this->reserve_lookup_(numValues_ + 1);
+
+        Slot slot;
+        if (!freeSlots_.empty()) {
+            slot = freeSlots_.back();
+            values_[slot] = std::move(value);
+            hashes_[slot] = hash;
+            freeSlots_.pop_back();
+        } else {
+            slot = static_cast<Slot>(values_.size());
+            values_.push_back(std::move(value));
+            refCounts_.push_back(0);
+            hashes_.push_back(hash);
+        }
+
+        this->insert_slot_(slot);
+        refCounts_[slot] = 1;
+
+        return slot;
+    }
+
+    void release_(Slot slot)
+    {
+        if (--refCounts_[slot] == 0) {
+            this->erase_slot_(slot);
+            freeSlots_.push_back(slot);
+        }
+    }
+
+    // Fibonacci hashing, as in FlatHashMap
+    std::size_t home_(std::size_t hash) const noexcept
+    {
+        constexpr std::uint64_t GOLDEN = 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(
+            (static_cast<std::uint64_t>(hash) * GOLDEN) >> shift_);
+    }
+
+    std::size_t next_(std::size_t idx) const noexcept
+    {
+        return (idx + 1) & (lookup_.size() - 1);
+    }
+
+    // Returns the slot holding a value equal to <value>, or NO_SLOT_
+    Slot find_slot_(const Type& value, std::size_t hash) const
+    {
+        if (!numValues_) {
+            return NO_SLOT_;
+        }
+
+        for (auto idx = this->home_(hash);; idx = this->next_(idx)) {
+            auto slot = lookup_[idx];
+
+            if (slot == NO_SLOT_
+                || (hashes_[slot] == hash && values_[slot] == value)) {
+                return slot;
+            }
+        }
+    }
+
+    void reserve_lookup_(std::size_t n)
+    {
+        if (n * MAX_LOAD_DEN_ <= lookup_.size() * MAX_LOAD_NUM_) {
+            return;
+        }
+
+        auto newSize = std::max(MIN_LOOKUP_, lookup_.size() * 2);
+        auto old = std::exchange(lookup_, std::vector<Slot>(newSize, NO_SLOT_));
+
+        shift_ = 64;
+        for (auto size = newSize; size > 1; size >>= 1) {
+            --shift_;
+        }
+
+        numValues_ = 0;
+        for (auto slot : old) {
+            if (slot != NO_SLOT_) {
+                this->insert_slot_(slot);
+            }
+        }
+    }
+
+    // Assumes there is room (see reserve_lookup_())
+    void insert_slot_(Slot slot) noexcept
+    {
+        auto idx = this->home_(hashes_[slot]);
+        while (lookup_[idx] != NO_SLOT_) {
+            idx = this->next_(idx);
+        }
+
+        lookup_[idx] = slot;
+        ++numValues_;
+    }
+
+    void erase_slot_(Slot slot) noexcept
+    {
+        auto hole = this->home_(hashes_[slot]);
+        while (lookup_[hole] != slot) {
+            hole = this->next_(hole);
+        }
+
+        lookup_[hole] = NO_SLOT_;
+        --numValues_;
+
+        // Backward-shift each following slot whose home is not between the
+        // hole and where it sits, so that probing never stops short
+        auto mask = lookup_.size() - 1;
+        for (auto idx = this->next_(hole); lookup_[idx] != NO_SLOT_;
+             idx = this->next_(idx)) {
+            auto home = this->home_(hashes_[lookup_[idx]]);
+
+            if (((idx - home) & mask) >= ((idx - hole) & mask)) {
+                lookup_[hole] = std::exchange(lookup_[idx], NO_SLOT_);
+                hole = idx;
+            }
+        }
+    }
+};
+}
+}
+
+#endif // OKI_SHARED_VECTOR_H
@@ -1,14 +1,16 @@
 #ifndef OKI_TYPE_ERASURE_H
 #define OKI_TYPE_ERASURE_H
 
+#include "oki/oki_config.h"
+
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
-#include <typeindex>
-#include <typeinfo>
 #include <utility>
 
 namespace oki {
@@ -29,6 +31,8 @@ public:
         return const_cast<Type*>(std::as_const(*this).template get_ptr<Type>());
     }
 
+    const void* address() const noexcept { return buf_; }
+
     template <typename Type, typename... Args>
     void init(Args&&... args)
     {
@@ -76,27 +80,59 @@ private:
     void* ptr_;
 };
 
-template <std::size_t Size, std::size_t Align>
+/*
+ * The default (empty) set of extra type-erased operations for ErasedType.
+ *
+ * An Ops policy is a struct of function pointers, each taking a pointer to
+ * the held object (void* or const void*) as its first argument, with a
+ * static create<Type>() that fills them in for a concrete type. It ends up
+ * in the same static table as the lifetime operations, so adding slots
+ * costs no space per ErasedType.
+ */
+struct NoErasedOps
+{
+    template <typename Type>
+    static constexpr NoErasedOps create() noexcept
+    {
+        return {};
+    }
+};
+
+// Recovers the held object inside an Ops function
+template <typename Type>
+Type* erased_cast(void* ptr) noexcept
+{
+    return std::launder(static_cast<Type*>(ptr));
+}
+
+template <typename Type>
+const Type* erased_cast(const void* ptr) noexcept
+{
+    return std::launder(static_cast<const Type*>(ptr));
+}
+
+template <std::size_t Size, std::size_t Align,
+    typename Ops = oki::intl_::NoErasedOps>
 class ErasedType
 {
 public:
     ErasedType() = default;
 
-    ErasedType(const ErasedType<Size, Align>& that)
+    ErasedType(const ErasedType& that)
         : ErasedType()
     {
         this->copy_from(that);
     }
 
-    ErasedType(ErasedType<Size, Align>&& that)
+    ErasedType(ErasedType&& that)
         : ErasedType()
     {
         this->move_from(std::move(that));
     }
 
     template <typename Type,
-        std::enable_if_t<std::negation_v<std::is_same<std::decay_t<Type>,
-                             ErasedType<Size, Align>>>,
+        std::enable_if_t<
+            std::negation_v<std::is_same<std::decay_t<Type>, ErasedType>>,
             int>
         = 0>
     ErasedType(Type&& value)
@@ -108,7 +144,7 @@ public:
 
     ~ErasedType() { this->reset(); }
 
-    ErasedType<Size, Align>& operator=(ErasedType<Size, Align> that)
+    ErasedType& operator=(ErasedType that)
     {
         this->move_from(std::move(that));
         return *this;
@@ -121,26 +157,42 @@ public:
         this->reinit_<Type>(std::forward<Args>(args)...);
     }
 
-    void copy_from(const ErasedType<Size, Align>& that)
+    void copy_from(const ErasedType& that)
     {
-        if (that.copy_) {
-            (this->*that.copy_)(that);
+        if (that.vtable_) {
+            that.vtable_->copy(*this, that);
         }
     }
 
-    void move_from(ErasedType<Size, Align>&& that)
+    void move_from(ErasedType&& that)
     {
-        if (that.move_) {
-            (this->*that.move_)(std::move(that));
+        if (that.vtable_) {
+            that.vtable_->move(*this, std::move(that));
         }
     }
 
+    bool has_value() const noexcept { return vtable_; }
+
+    // The address of the held object, or nullptr if there is none
+    void* address() noexcept
+    {
+        return const_cast<void*>(std::as_const(*this).address());
+    }
+
+    const void* address() const noexcept
+    {
+        if (!vtable_) {
+            return nullptr;
+        }
+
+        return vtable_->inBuffer ? storage_.buf_.address()
+                                 : storage_.ptr_.template get_ptr<void>();
+    }
+
     template <typename Type>
     const Type& get_as() const
     {
-        if (!destroy_) {
-            throw std::runtime_error("get_as() called on empty ErasedType");
-        }
+        oki::intl_::check(vtable_, "get_as() called on empty ErasedType");
 
         if constexpr (is_sbo_<Type>()) {
             return *storage_.buf_.template get_ptr<Type>();
@@ -155,13 +207,32 @@ public:
         return const_cast<Type&>(std::as_const(*this).template get_as<Type>());
     }
 
+    /*
+     * Calls one of the Ops policy's operations on the held object, without
+     * knowing its type, e.g. erased.invoke(&Ops::size).
+     */
+    template <typename Func, typename... Args>
+    decltype(auto) invoke(Func Ops::*op, Args&&... args)
+    {
+        oki::intl_::check(vtable_, "invoke() called on empty ErasedType");
+
+        return (vtable_->ops.*op)(
+            this->address(), std::forward<Args>(args)...);
+    }
+
+    template <typename Func, typename... Args>
+    decltype(auto) invoke(Func Ops::*op, Args&&... args) const
+    {
+        oki::intl_::check(vtable_, "invoke() called on empty ErasedType");
+
+        return (vtable_->ops.*op)(
+            this->address(), std::forward<Args>(args)...);
+    }
+
     void reset()
     {
-        if (destroy_) {
-            (this->*destroy_)();
-            destroy_ = nullptr;
-            copy_ = nullptr;
-            move_ = nullptr;
+        if (vtable_) {
+            std::exchange(vtable_, nullptr)->destroy(*this);
         }
     }
 
@@ -194,29 +265,36 @@ private:
         }
     }
 
-    // Type-erased destruction
-    using DestroyFunc = void (ErasedType::*)();
-    DestroyFunc destroy_ = nullptr;
+    /*
+     * Everything we need to know about the held type, shared by every
+     * ErasedType holding it. A single pointer to this replaces what would
+     * otherwise be one (fat) member function pointer per operation.
+     */
+    struct VTable
+    {
+        void (*destroy)(ErasedType&);
+        void (*copy)(ErasedType&, const ErasedType&);
+        void (*move)(ErasedType&, ErasedType&&);
+        bool inBuffer;
+        Ops ops;
+    };
+
+    const VTable* vtable_ = nullptr;
 
+    // Type-erased destruction
     template <typename Type>
-    void destroy_inner_()
+    static void destroy_inner_(ErasedType& self)
     {
-        this->visit_storage_<Type>(
+        self.visit_storage_<Type>(
             [](auto& data) { data.template destroy<Type>(); });
     }
 
     // Type-erased construction
-    using CopyConstruct = void (ErasedType::*)(const ErasedType&);
-    CopyConstruct copy_ = nullptr;
-
-    using MoveConstruct = void (ErasedType::*)(ErasedType&&);
-    MoveConstruct move_ = nullptr;
-
     template <typename Type>
-    void copy_inner_(const ErasedType& that)
+    static void copy_inner_(ErasedType& self, const ErasedType& that)
     {
         if constexpr (std::is_copy_constructible_v<Type>) {
-            this->reinit_<Type>(that.get_as<Type>());
+            self.reinit_<Type>(that.get_as<Type>());
         } else {
             throw std::logic_error(
                 "Only use copy_from() on copy-constructible types");
@@ -224,16 +302,21 @@ private:
     }
 
     template <typename Type>
-    void move_inner_(ErasedType&& that)
+    static void move_inner_(ErasedType& self, ErasedType&& that)
     {
         if constexpr (std::is_move_constructible_v<Type>) {
-            this->reinit_<Type>(std::move(that.get_as<Type>()));
+            self.reinit_<Type>(std::move(that.get_as<Type>()));
         } else {
             throw std::logic_error(
                 "Only use move_from() on move-constructible types");
         }
     }
 
+    template <typename Type>
+    static constexpr VTable VTABLE_ { &destroy_inner_<Type>,
+        &copy_inner_<Type>, &move_inner_<Type>, is_sbo_<Type>(),
+        Ops::template create<Type>() };
+
     // Initialization
     template <typename Type, typename... Args>
     void reinit_(Args&&... args)
@@ -248,32 +331,38 @@ private:
             data.template init<Type>(std::forward<Args>(args)...);
         });
 
-        destroy_ = &ErasedType<Size, Align>::destroy_inner_<Type>;
-        copy_ = &ErasedType<Size, Align>::copy_inner_<Type>;
-        move_ = &ErasedType<Size, Align>::move_inner_<Type>;
+        vtable_ = &VTABLE_<Type>;
     }
 };
 
-template <typename Type>
-using OptimalErasedType = oki::intl_::ErasedType<sizeof(Type), alignof(Type)>;
+template <typename Type, typename Ops = oki::intl_::NoErasedOps>
+using OptimalErasedType
+    = oki::intl_::ErasedType<sizeof(Type), alignof(Type), Ops>;
 
 /*
  * An opaque class representing a type index for an associative map.
  * It is worth using this instead of std::type_index directly because
- * this can easily be replaced with a different mechanism (like some
- * pointer to a static template variable, for instance).
+ * this can easily be replaced with a different mechanism.
+ *
+ * It is currently the address of a static template variable, which is
+ * unique per type and (unlike std::type_index, which typically hashes the
+ * type's name) free to hash and compare. The usual caveat applies: types
+ * shared across shared-library boundaries may get distinct indices.
  */
 class TypeIndex
 {
 public:
-    std::size_t hash() const { return std::hash<std::type_index> {}(idx_); }
+    std::size_t hash() const { return std::hash<IndexType> {}(idx_); }
 
     bool operator==(const TypeIndex& that) const { return idx_ == that.idx_; }
 
-    bool operator<(const TypeIndex& that) const { return idx_ < that.idx_; }
+    bool operator<(const TypeIndex& that) const
+    {
+        return std::less<IndexType> {}(idx_, that.idx_);
+    }
 
 private:
-    using IndexType = std::type_index;
+    using IndexType = const void*;
     IndexType idx_;
 
     explicit TypeIndex(IndexType idx)
@@ -281,6 +370,13 @@ private:
     {
     }
 
+    // Deliberately non-const so that no two can ever be merged
+    template <typename Type>
+    struct Tag
+    {
+        static inline char id = 0;
+    };
+
     template <typename T>
     friend TypeIndex get_type();
 };
@@ -288,7 +384,9 @@ private:
 template <typename Type>
 oki::intl_::TypeIndex get_type()
 {
-    return oki::intl_::TypeIndex { typeid(std::decay_t<Type>) };
+    return oki::intl_::TypeIndex {
+        &oki::intl_::TypeIndex::Tag<std::decay_t<Type>>::id
+    };
 }
 
 template <typename Type>
@@ -296,6 +394,27 @@ oki::intl_::TypeIndex get_type(Type&& _)
 {
     return oki::intl_::get_type<std::decay_t<Type>>();
 }
+
+namespace helper_ {
+template <typename Family>
+std::size_t next_sequential_id() noexcept
+{
+    static std::atomic<std::size_t> next { 0 };
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+/*
+ * Numbers the types of a family densely (0, 1, 2...) in order of first
+ * use, so that they can index an array rather than a map. The numbers are
+ * only stable within one run of a program.
+ */
+template <typename Family, typename Type>
+std::size_t get_sequential_id() noexcept
+{
+    static const std::size_t id = helper_::next_sequential_id<Family>();
+    return id;
+}
 }
 }
 
@@ -4,11 +4,20 @@
 
 #include "catch2/catch_test_macros.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <iterator>
+#include <numeric>
 #include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 using Value = test_helper::ObjHelper;
 using TestType = oki::ComponentManager;
@@ -50,8 +59,6 @@ TEST_CASE("ComponentManager")
     SECTION(
         "can update component with reference from bind_component_unchecked()")
     {
-        compMan.bind_component(entity, 0);
-
         auto& comp = compMan.bind_component_unchecked(entity, 1);
         comp = 2;
 
@@ -266,6 +273,98 @@ TEST_CASE("ComponentManager")
             REQUIRE(std::equal(values.begin(), values.end(), expectedVals));
         }
     }
+    SECTION("can stop for_each() early by returning false")
+    {
+        for (int i = 0; i != 10; ++i) {
+            compMan.bind_component(compMan.create_entity(), i);
+        }
+
+        std::vector<int> values;
+        compMan.for_each<int>([&](oki::Entity, int i) {
+            values.push_back(i);
+            return i != 3;
+        });
+
+        REQUIRE(values == std::vector<int> { 0, 1, 2, 3 });
+    }
+    SECTION("can search for entities with any() and find_first()")
+    {
+        auto e1 = compMan.create_entity();
+        auto e2 = compMan.create_entity();
+        auto e3 = compMan.create_entity();
+
+        compMan.bind_component(e1, 1);
+        compMan.bind_component(e2, 2);
+        compMan.bind_component(e2, 'b');
+        compMan.bind_component(e3, 3);
+        compMan.bind_component(e3, 'c');
+
+        unsigned calls = 0;
+        auto found = compMan.find_first<int, char>([&](auto, int i, char) {
+            ++calls;
+            return i >= 2;
+        });
+
+        REQUIRE(found);
+        REQUIRE(compMan.get_component<int>(*found) == 2);
+        REQUIRE(calls == 1);
+
+        REQUIRE(compMan.any<int>([](auto, int i) { return i == 3; }));
+        REQUIRE_FALSE(compMan.any<int>([](auto, int i) { return i == 4; }));
+        REQUIRE_FALSE(compMan.find_first<int, float>([](auto...) {
+            return true;
+        }));
+    }
+    SECTION("can count entities without iterating")
+    {
+        auto e1 = compMan.create_entity();
+        auto e2 = compMan.create_entity();
+        auto e3 = compMan.create_entity();
+
+        compMan.bind_component(e1, 1);
+        compMan.bind_component(e1, 'a');
+        compMan.bind_component(e2, 2);
+        compMan.bind_component(e3, 3);
+        compMan.bind_component(e3, 'c');
+
+        REQUIRE(compMan.count<int>() == 3);
+        REQUIRE(compMan.count<int, char>() == 2);
+        REQUIRE(compMan.count<char, int>() == 2);
+        REQUIRE(compMan.count<int, float>() == 0);
+    }
+    SECTION("can reduce over components")
+    {
+        // Enough entities that reduce() may actually use several threads
+        constexpr std::size_t NUM_ENTITIES = 100'000;
+
+        std::size_t expected = 0;
+        for (std::size_t i = 0; i != NUM_ENTITIES; ++i) {
+            auto ent = compMan.create_entity();
+            compMan.bind_component(ent, i);
+
+            if (i % 3 == 0) {
+                compMan.bind_component(ent, 'x');
+                expected += i;
+            }
+        }
+
+        auto plus = [](std::size_t lhs, std::size_t rhs) { return lhs + rhs; };
+
+        auto total = compMan.reduce<std::size_t, char>(
+            std::size_t { 0 }, [](auto, std::size_t i, char) { return i; },
+            plus);
+        REQUIRE(total == expected);
+
+        auto view = compMan.get_component_view<std::size_t>();
+        auto count = view.reduce(
+            std::size_t { 0 }, [](auto...) { return std::size_t { 1 }; },
+            plus);
+        REQUIRE(count == NUM_ENTITIES);
+
+        REQUIRE(compMan.reduce<float>(
+                    7, [](auto...) { return 0; }, std::plus<> {})
+            == 7);
+    }
     SECTION("can check missing containers in for_each()")
     {
         compMan.for_each<int>([](auto...) {
@@ -328,6 +427,150 @@ TEST_CASE("ComponentManager")
             REQUIRE(std::equal(values.begin(), values.end(), expectedVals));
         }
     }
+    SECTION("can iterate over a view with iterators")
+    {
+        auto e1 = compMan.create_entity();
+        auto e2 = compMan.create_entity();
+        auto e3 = compMan.create_entity();
+
+        compMan.bind_component(e1, 1);
+        compMan.bind_component(e1, 1.f);
+
+        compMan.bind_component(e2, 2);
+
+        compMan.bind_component(e3, 3);
+        compMan.bind_component(e3, 3.f);
+
+        auto view = compMan.get_component_view<int, float>();
+
+        std::vector<int> values;
+        for (auto [ent, i, f] : view) {
+            CHECK(compMan.get_component<int>(ent) == i);
+            values.push_back(i);
+            f = 0.f;
+        }
+
+        REQUIRE(values == std::vector<int> { 1, 3 });
+        REQUIRE(compMan.get_component<float>(e1) == 0.f);
+        REQUIRE(compMan.get_component<float>(e3) == 0.f);
+        REQUIRE(std::distance(view.begin(), view.end()) == 2);
+    }
+    SECTION("can use single-type view iterators as random-access")
+    {
+        for (int i = 0; i != 10; ++i) {
+            compMan.bind_component(compMan.create_entity(), i);
+        }
+
+        auto view = compMan.get_component_view<int>();
+        auto begin = view.begin(), end = view.end();
+
+        REQUIRE(end - begin == 10);
+        REQUIRE(std::get<1>(begin[4]) == 4);
+        REQUIRE(std::get<1>(*(end - 1)) == 9);
+
+        auto sum = std::transform_reduce(begin, end, 0, std::plus<> {},
+            [](auto entry) { return std::get<1>(entry); });
+        REQUIRE(sum == 45);
+
+        std::for_each(begin, end, [](auto entry) { std::get<1>(entry) *= 2; });
+        REQUIRE(std::get<1>(begin[9]) == 18);
+    }
+    SECTION("can look up components through an accessor")
+    {
+        std::vector<oki::Entity> entities;
+        for (int i = 0; i != 100; ++i) {
+            auto ent = compMan.create_entity();
+            entities.push_back(ent);
+
+            compMan.bind_component(ent, i);
+            if (i % 3 == 0) {
+                compMan.bind_component(ent, static_cast<float>(i));
+            }
+        }
+
+        auto ints = compMan.get_component_accessor<int>();
+        auto floats = compMan.get_component_accessor<float>();
+
+        // In order, backwards and out of order
+        for (int i = 0; i != 100; ++i) {
+            CHECK(ints.get(entities[i]) == i);
+            CHECK(floats.has(entities[i]) == (i % 3 == 0));
+        }
+        for (int i = 99; i >= 0; --i) {
+            CHECK(ints.get(entities[i]) == i);
+        }
+        for (int i : { 50, 3, 97, 0, 42 }) {
+            CHECK(*ints.get_checked(entities[i]) == i);
+            CHECK((floats.get_checked(entities[i]) != nullptr)
+                == (i % 3 == 0));
+        }
+
+        // Still valid after the container changes under it
+        compMan.remove_component<int>(entities[0]);
+        CHECK(ints.get(entities[99]) == 99);
+        CHECK_FALSE(ints.has(entities[0]));
+
+        ints.get(entities[1]) = -1;
+        CHECK(compMan.get_component<int>(entities[1]) == -1);
+    }
+    SECTION("can look up components of many entities at once")
+    {
+        std::vector<oki::Entity> entities;
+        for (int i = 0; i != 10; ++i) {
+            auto ent = compMan.create_entity();
+            entities.push_back(ent);
+
+            compMan.bind_component(ent, i);
+            compMan.bind_component(ent, std::to_string(i));
+        }
+
+        std::vector<std::tuple<int&, std::string&>> comps;
+        compMan.get_components<int, std::string>(
+            entities.begin(), entities.end(), std::back_inserter(comps));
+
+        REQUIRE(comps.size() == 10);
+        for (int i = 0; i != 10; ++i) {
+            CHECK(std::get<0>(comps[i]) == i);
+            CHECK(std::get<1>(comps[i]) == std::to_string(i));
+        }
+
+        std::get<0>(comps[3]) = 0;
+        CHECK(compMan.get_component<int>(entities[3]) == 0);
+    }
+    SECTION("can look up components of many entities in any order")
+    {
+        std::vector<oki::Entity> entities;
+        for (int i = 0; i != 200; ++i) {
+            auto ent = compMan.create_entity();
+            entities.push_back(ent);
+
+            if (i % 2) {
+                compMan.bind_component(ent, i);
+            }
+            if (i % 3) {
+                compMan.bind_component(ent, std::to_string(i));
+            }
+        }
+
+        std::vector<oki::Entity> targets;
+        for (int i = 0; i != 200; ++i) {
+            targets.push_back(entities[(i * 7) % 200]);
+        }
+
+        std::vector<std::tuple<int*, std::string*, float*>> comps;
+        compMan.get_components_batch<int, std::string, float>(
+            targets.begin(), targets.end(), std::back_inserter(comps));
+
+        REQUIRE(comps.size() == targets.size());
+        for (int i = 0; i != 200; ++i) {
+            int idx = (i * 7) % 200;
+            auto [intPtr, strPtr, floatPtr] = comps[i];
+
+            CHECK((intPtr ? *intPtr == idx : idx % 2 == 0));
+            CHECK((strPtr ? *strPtr == std::to_string(idx) : idx % 3 == 0));
+            CHECK_FALSE(floatPtr);
+        }
+    }
     SECTION("reserve_components() does not increase num_components()")
     {
         compMan.reserve_components<int>(10);
@@ -344,9 +587,131 @@ TEST_CASE("ComponentManager")
     }
     SECTION("can destroy an entity")
     {
-        // Basically does nothing at the moment
         CHECK(compMan.destroy_entity(entity));
     }
+    SECTION("destroy_entity() erases the entity's components")
+    {
+        auto other = compMan.create_entity();
+
+        compMan.bind_component(entity, 0);
+        compMan.bind_component(entity, 'c');
+        compMan.bind_component(other, 1);
+
+        CHECK(compMan.destroy_entity(entity));
+
+        CHECK(compMan.num_components<int>() == 1);
+        CHECK(compMan.num_components<char>() == 0);
+        CHECK(compMan.get_component<int>(other) == 1);
+    }
+    SECTION("can create entities in bulk")
+    {
+        auto entities = compMan.create_entities(5);
+        REQUIRE(entities.size() == 5);
+
+        for (auto other : entities) {
+            CHECK(compMan.bind_component(other, 0).second);
+        }
+        CHECK(compMan.num_components<int>() == 5);
+        CHECK(entities.end() - entities.begin() == 5);
+    }
+    SECTION("can spawn entities with components")
+    {
+        compMan.bind_component(entity, 0);
+
+        auto entities = compMan.spawn<int, char>(3, [](std::size_t i) {
+            return std::make_tuple(static_cast<int>(i) + 1, 'a');
+        });
+
+        CHECK(compMan.num_components<int>() == 4);
+        CHECK(compMan.num_components<char>() == 3);
+        for (std::size_t i = 0; i != entities.size(); ++i) {
+            CHECK(compMan.get_component<int>(entities[i])
+                == static_cast<int>(i) + 1);
+            CHECK(compMan.get_component<char>(entities[i]) == 'a');
+        }
+
+        int visited = 0;
+        compMan.for_each<int>([&](oki::Entity, int value) {
+            CHECK(value == visited++);
+        });
+        CHECK(visited == 4);
+    }
+    SECTION("can instantiate prefabs")
+    {
+        compMan.bind_component(entity, std::string("first"));
+
+        auto prefab = compMan.create_prefab(std::string("copy"), 1);
+        prefab.get<int>() = 2;
+
+        auto one = compMan.instantiate(prefab);
+        auto many = compMan.instantiate(std::as_const(prefab), 3);
+
+        REQUIRE(one.size() == 1);
+        REQUIRE(many.size() == 3);
+        CHECK(compMan.num_components<std::string>() == 5);
+
+        for (auto other : many) {
+            CHECK(compMan.get_component<std::string>(other) == "copy");
+            CHECK(compMan.get_component<int>(other) == 2);
+        }
+        CHECK(compMan.get_component<std::string>(entity) == "first");
+        CHECK(prefab.get<std::string>() == "copy");
+    }
+    SECTION("destroy_entities() erases the entities' components")
+    {
+        auto entities = compMan.spawn<int>(10, [](std::size_t i) {
+            return std::make_tuple(static_cast<int>(i));
+        });
+        compMan.bind_component(entity, 'c');
+
+        std::vector<oki::Entity> doomed { entities[7], entity, entities[2] };
+        CHECK(compMan.destroy_entities(doomed.begin(), doomed.end()) == 3);
+
+        CHECK(compMan.num_components<char>() == 0);
+        CHECK(compMan.num_components<int>() == 8);
+        CHECK_FALSE(compMan.has_component<int>(entities[2]));
+        CHECK(compMan.get_component<int>(entities[3]) == 3);
+    }
+    SECTION("num_components() counts components of all types")
+    {
+        auto other = compMan.create_entity();
+
+        compMan.bind_component(entity, 0);
+        compMan.bind_component(entity, 'c');
+        compMan.bind_component(other, 1);
+
+        CHECK(compMan.num_components() == 3);
+    }
+    SECTION("erase_components() keeps views valid")
+    {
+        auto view = compMan.get_component_view<int>();
+        compMan.bind_component(entity, 0);
+
+        compMan.erase_components();
+        CHECK(compMan.num_components() == 0);
+        CHECK(view.begin() == view.end());
+
+        compMan.bind_component(entity, 1);
+        CHECK(std::get<1>(*view.begin()) == 1);
+    }
+    SECTION("can report and release component memory")
+    {
+        compMan.reserve_components<int>(100);
+        compMan.reserve_components<char>(100);
+        CHECK(compMan.component_memory_usage()
+            >= 100 * (sizeof(std::pair<oki::Handle, int>)
+                + sizeof(std::pair<oki::Handle, char>)));
+
+        compMan.bind_component(entity, 0);
+        compMan.reserve_components(200);
+        CHECK(compMan.component_memory_usage()
+            >= 200 * sizeof(std::pair<oki::Handle, int>));
+
+        compMan.shrink_components();
+        CHECK(compMan.component_memory_usage()
+            < 100 * sizeof(std::pair<oki::Handle, int>));
+        CHECK(compMan.get_component<int>(entity) == 0);
+    }
 
     SECTION("(lifetime management)")
     {
@@ -481,3 +846,1147 @@ TEST_CASE("ComponentManager")
         }
     }
 }
+
+namespace {
+struct UnitState
+{
+    float x, y;
+};
+
+struct UnitInfo
+{
+    std::string name;
+};
+
+using Unit = oki::Split<UnitState, UnitInfo>;
+
+// Distinct from Unit, despite having the same parts
+struct Squad : oki::Split<UnitState, UnitInfo>
+{ };
+}
+
+TEST_CASE("ComponentManager (split components)")
+{
+    oki::ComponentManager compMan;
+    auto entity = compMan.create_entity();
+
+    SECTION("can bind and retrieve the whole component")
+    {
+        auto [unit, success]
+            = compMan.bind_component(entity, Unit { { 1.f, 2.f }, { "a" } });
+
+        CHECK(success);
+        CHECK(unit.hot.x == 1.f);
+        CHECK(unit.cold.name == "a");
+
+        auto ref = compMan.get_component<Unit>(entity);
+        ref.hot.y = 3.f;
+
+        Unit copy = compMan.get_component<Unit>(entity);
+        CHECK(copy.hot.y == 3.f);
+        CHECK(copy.cold.name == "a");
+
+        CHECK(compMan.has_component<Unit>(entity));
+        CHECK(compMan.num_components<Unit>() == 1);
+    }
+    SECTION("does not overwrite in bind_component()")
+    {
+        compMan.bind_component(entity, Unit { { 1.f, 2.f }, { "a" } });
+
+        auto [unit, success]
+            = compMan.bind_component(entity, Unit { { 0.f, 0.f }, { "b" } });
+
+        CHECK_FALSE(success);
+        CHECK(unit.cold.name == "a");
+
+        compMan.bind_or_assign_component(
+            entity, Unit { { 0.f, 0.f }, { "b" } });
+        CHECK(compMan.get_component<Unit>(entity).cold.name == "b");
+    }
+    SECTION("stores the parts separately from standalone components")
+    {
+        compMan.bind_component(entity, UnitState { 5.f, 5.f });
+        compMan.emplace_component<Unit>(
+            entity, UnitState { 1.f, 2.f }, UnitInfo { "a" });
+
+        CHECK(compMan.get_component<UnitState>(entity).x == 5.f);
+        CHECK(compMan.get_component<oki::Hot<Unit>>(entity).x == 1.f);
+        CHECK(compMan.get_component<oki::Cold<Unit>>(entity).name == "a");
+
+        compMan.emplace_component<Squad>(
+            entity, UnitState { 3.f, 4.f }, UnitInfo { "b" });
+
+        Squad squad = compMan.get_component<Squad>(entity);
+        CHECK(squad.hot.x == 3.f);
+        CHECK(squad.cold.name == "b");
+        CHECK(compMan.get_component<Unit>(entity).cold.name == "a");
+    }
+    SECTION("can iterate over either part alone")
+    {
+        for (int i = 0; i != 10; ++i) {
+            compMan.bind_component(compMan.create_entity(),
+                Unit { { static_cast<float>(i), 0.f }, { std::to_string(i) } });
+        }
+
+        float sum = 0.f;
+        compMan.for_each<oki::Hot<Unit>>(
+            [&](auto, UnitState& state) { sum += state.x; });
+        CHECK(sum == 45.f);
+
+        auto view = compMan.get_component_view<oki::Cold<Unit>>();
+        CHECK(view.end() - view.begin() == 10);
+        CHECK(std::get<1>(view.begin()[3]).name == "3");
+
+        compMan.for_each<oki::Hot<Unit>, oki::Cold<Unit>>(
+            [](auto, UnitState& state, const UnitInfo& info) {
+                CHECK(state.x == std::stof(info.name));
+            });
+    }
+    SECTION("removes both parts together")
+    {
+        compMan.bind_component(entity, Unit { { 1.f, 2.f }, { "a" } });
+
+        CHECK(compMan.remove_component<Unit>(entity));
+        CHECK_FALSE(compMan.remove_component<Unit>(entity));
+
+        CHECK_FALSE(compMan.has_component<Unit>(entity));
+        CHECK(compMan.num_components<oki::Cold<Unit>>() == 0);
+    }
+    SECTION("works through get_components()")
+    {
+        compMan.bind_component(entity, 7);
+        compMan.bind_component(entity, Unit { { 1.f, 2.f }, { "a" } });
+
+        auto [num, unit] = compMan.get_components<int, Unit>(entity);
+        CHECK(num == 7);
+        CHECK(unit.cold.name == "a");
+    }
+}
+
+namespace {
+struct PhysicsVec
+{
+    float velX, velY, accX, accY;
+};
+}
+
+template <>
+struct oki::StoreAsColumns<PhysicsVec> : std::true_type
+{ };
+
+TEST_CASE("ComponentManager (column-stored components)")
+{
+    oki::ComponentManager compMan;
+    auto entity = compMan.create_entity();
+
+    SECTION("can bind and retrieve whole components")
+    {
+        auto [vec, success]
+            = compMan.bind_component(entity, PhysicsVec { 1.f, 2.f, 3.f, 4.f });
+
+        CHECK(success);
+        CHECK(vec.get<0>() == 1.f);
+        CHECK(vec.get<3>() == 4.f);
+
+        PhysicsVec copy = compMan.get_component<PhysicsVec>(entity);
+        CHECK(copy.velY == 2.f);
+        CHECK(copy.accX == 3.f);
+
+        CHECK(compMan.has_component<PhysicsVec>(entity));
+        CHECK_FALSE(compMan.bind_component(entity, PhysicsVec {}).second);
+    }
+    SECTION("can modify fields through references")
+    {
+        compMan.bind_component(entity, PhysicsVec { 1.f, 2.f, 3.f, 4.f });
+
+        auto [velX, velY, accX, accY]
+            = compMan.get_component<PhysicsVec>(entity);
+        velX += accX;
+        velY += accY;
+
+        auto vec = compMan.get_component<PhysicsVec>(entity);
+        CHECK(vec.get<0>() == 4.f);
+        CHECK(vec.get<1>() == 6.f);
+
+        vec = PhysicsVec { 0.f, 0.f, 0.f, 1.f };
+        CHECK(compMan.get_component<PhysicsVec>(entity).get<3>() == 1.f);
+
+        compMan.bind_or_assign_component(
+            entity, PhysicsVec { 5.f, 0.f, 0.f, 0.f });
+        CHECK(compMan.get_component<PhysicsVec>(entity).get<0>() == 5.f);
+        CHECK(compMan.get_component<PhysicsVec>(entity).get<3>() == 0.f);
+    }
+    SECTION("returns std::optional from get_component_checked()")
+    {
+        CHECK_FALSE(compMan.get_component_checked<PhysicsVec>(entity));
+
+        compMan.bind_component(entity, PhysicsVec { 1.f, 2.f, 3.f, 4.f });
+        auto vec = compMan.get_component_checked<PhysicsVec>(entity);
+
+        REQUIRE(vec);
+        CHECK(vec->get<2>() == 3.f);
+        CHECK_FALSE(compMan.get_component_checked<PhysicsVec>(
+            compMan.create_entity()));
+    }
+    SECTION("keeps columns in step when binding out of order")
+    {
+        std::vector<oki::Entity> entities;
+        for (int i = 0; i != 10; ++i) {
+            entities.push_back(compMan.create_entity());
+        }
+        for (int i : { 3, 9, 0, 5, 1, 8, 2, 7, 4, 6 }) {
+            auto field = static_cast<float>(i);
+            compMan.bind_component(
+                entities[i], PhysicsVec { field, -field, 0.f, 0.f });
+        }
+        compMan.remove_component<PhysicsVec>(entities[4]);
+
+        // Entities are visited in order of creation
+        std::vector<float> visited;
+        compMan.for_each<PhysicsVec>([&](oki::Entity, auto& vec) {
+            visited.push_back(vec.template get<0>());
+            CHECK(vec.template get<1>() == -visited.back());
+        });
+        CHECK(visited
+            == std::vector<float> { 0.f, 1.f, 2.f, 3.f, 5.f, 6.f, 7.f, 8.f,
+                9.f });
+
+        auto view = compMan.get_component_view<PhysicsVec>();
+        auto velY = view.column<1>();
+
+        REQUIRE(velY.size() == 9);
+        CHECK(view.end() - view.begin() == 9);
+        for (std::size_t i = 0; i != velY.size(); ++i) {
+            CHECK(velY[i] == -std::get<1>(view.begin()[i]).get<0>());
+        }
+    }
+    SECTION("can be intersected with other components")
+    {
+        for (int i = 0; i != 10; ++i) {
+            auto ent = compMan.create_entity();
+            compMan.bind_component(ent, PhysicsVec { 1.f, 0.f, 0.f, 0.f });
+            if (i % 2) {
+                compMan.bind_component(ent, i);
+            }
+        }
+
+        CHECK(compMan.count<PhysicsVec, int>() == 5);
+
+        float sum = compMan.reduce<int, PhysicsVec>(
+            0.f,
+            [](oki::Entity, int num, auto vec) {
+                return num * vec.template get<0>();
+            },
+            std::plus<float> {});
+        CHECK(sum == 25.f);
+
+        auto found = compMan.find_first<PhysicsVec, int>(
+            [](oki::Entity, auto&, int num) { return num == 3; });
+        CHECK(found.has_value());
+    }
+    SECTION("can be spawned in bulk")
+    {
+        auto entities = compMan.spawn<PhysicsVec>(4, [](std::size_t i) {
+            auto value = static_cast<float>(i);
+            return std::make_tuple(PhysicsVec { value, value, 0.f, 0.f });
+        });
+
+        auto view = compMan.get_component_view<PhysicsVec>();
+        auto velX = view.column<0>();
+        CHECK(std::vector<float>(velX.begin(), velX.end())
+            == std::vector<float> { 0.f, 1.f, 2.f, 3.f });
+        CHECK(compMan.get_component<PhysicsVec>(entities[2]).get<1>() == 2.f);
+    }
+    SECTION("can be propagated through a hierarchy")
+    {
+        auto child = compMan.create_entity();
+        compMan.bind_component(entity, PhysicsVec { 1.f, 0.f, 0.f, 0.f });
+        compMan.bind_component(child, PhysicsVec { 2.f, 0.f, 0.f, 0.f });
+        compMan.set_parent(child, entity);
+
+        compMan.propagate<PhysicsVec>([](auto, auto vec, auto parent) {
+            auto& [velX, velY, accX, accY] = vec;
+            velY = velX + (parent ? parent->template get<1>() : 0.f);
+        });
+
+        CHECK(compMan.get_component<PhysicsVec>(child).get<1>() == 3.f);
+    }
+    SECTION("can be looked up in ranges and batches")
+    {
+        std::vector<oki::Entity> entities;
+        for (int i = 0; i != 10; ++i) {
+            entities.push_back(compMan.create_entity());
+            compMan.bind_component(entities.back(),
+                PhysicsVec { static_cast<float>(i), 0.f, 0.f, 0.f });
+        }
+
+        using Ref = oki::ColumnRef<PhysicsVec>;
+        std::vector<std::tuple<Ref>> refs;
+        compMan.get_components<PhysicsVec>(
+            entities.begin(), entities.end(), std::back_inserter(refs));
+
+        using Ptr = std::optional<Ref>;
+        std::vector<std::tuple<Ptr>> ptrs;
+        compMan.get_components_batch<PhysicsVec>(
+            entities.rbegin(), entities.rend(), std::back_inserter(ptrs));
+
+        for (std::size_t i = 0; i != entities.size(); ++i) {
+            CHECK(std::get<0>(refs[i]).get<0>() == static_cast<float>(i));
+            CHECK(std::get<0>(ptrs[9 - i])->get<0>() == static_cast<float>(i));
+        }
+    }
+}
+
+namespace {
+struct Transform
+{
+    int local;
+    int world;
+};
+}
+
+TEST_CASE("ComponentManager (hierarchy)")
+{
+    oki::ComponentManager compMan;
+
+    // Each entity's int is its name
+    auto make = [&](int name) {
+        auto entity = compMan.create_entity();
+        compMan.bind_component(entity, name);
+        compMan.bind_component(entity, Transform { name, 0 });
+
+        return entity;
+    };
+    auto name_of = [&](oki::Entity entity) {
+        return compMan.get_component<int>(entity);
+    };
+    auto children_of = [&](oki::Entity parent) {
+        std::vector<int> names;
+        compMan.for_each_child(parent,
+            [&](oki::Entity child) { names.push_back(name_of(child)); });
+
+        return names;
+    };
+
+    auto root = make(1);
+    auto arm = make(10);
+    auto hand = make(100);
+    auto turret = make(1000);
+
+    compMan.set_parent(arm, root);
+    compMan.set_parent(hand, arm);
+    compMan.set_parent(turret, root);
+
+    SECTION("links parents and children")
+    {
+        CHECK_FALSE(compMan.get_parent(root));
+        CHECK(name_of(*compMan.get_parent(arm)) == 1);
+        CHECK(name_of(*compMan.get_parent(hand)) == 10);
+
+        CHECK(children_of(root) == std::vector<int> { 1000, 10 });
+        CHECK(children_of(arm) == std::vector<int> { 100 });
+        CHECK(children_of(hand).empty());
+    }
+    SECTION("can reparent and detach entities")
+    {
+        compMan.set_parent(hand, turret);
+        CHECK(name_of(*compMan.get_parent(hand)) == 1000);
+        CHECK(children_of(arm).empty());
+        CHECK(children_of(turret) == std::vector<int> { 100 });
+
+        CHECK(compMan.remove_parent(turret));
+        CHECK_FALSE(compMan.remove_parent(turret));
+        CHECK_FALSE(compMan.get_parent(turret));
+        CHECK(children_of(root) == std::vector<int> { 10 });
+    }
+    SECTION("can reparent entities in bulk")
+    {
+        std::vector<oki::Entity> limbs { arm, turret };
+        auto body = make(2);
+
+        compMan.set_parents(limbs.begin(), limbs.end(), body);
+
+        CHECK(children_of(root).empty());
+        CHECK(children_of(body) == std::vector<int> { 1000, 10 });
+        CHECK(name_of(*compMan.get_parent(hand)) == 10);
+    }
+    SECTION("rejects cycles")
+    {
+        CHECK_THROWS_AS(compMan.set_parent(root, hand), std::invalid_argument);
+        CHECK_THROWS_AS(compMan.set_parent(arm, arm), std::invalid_argument);
+
+        CHECK_FALSE(compMan.get_parent(root));
+        CHECK(name_of(*compMan.get_parent(arm)) == 1);
+    }
+    SECTION("propagates components from parents to children")
+    {
+        auto propagate = [&]() {
+            std::vector<int> order;
+            compMan.propagate<Transform>(
+                [&](oki::Entity entity, Transform& trans, Transform* parent) {
+                    trans.world = trans.local + (parent ? parent->world : 0);
+                    order.push_back(name_of(entity));
+                });
+
+            return order;
+        };
+
+        CHECK(propagate() == std::vector<int> { 1, 1000, 10, 100 });
+        CHECK(compMan.get_component<Transform>(hand).world == 111);
+        CHECK(compMan.get_component<Transform>(turret).world == 1001);
+
+        // The order follows changes to the hierarchy
+        compMan.set_parent(arm, turret);
+        CHECK(propagate() == std::vector<int> { 1, 1000, 10, 100 });
+        CHECK(compMan.get_component<Transform>(hand).world == 1111);
+
+        compMan.remove_parent(turret);
+        CHECK(propagate() == std::vector<int> { 1000, 10, 100 });
+        CHECK(compMan.get_component<Transform>(hand).world == 1110);
+    }
+    SECTION("skips parents without the component when propagating")
+    {
+        compMan.remove_component<Transform>(arm);
+
+        compMan.propagate<Transform>([&](auto, auto& trans, auto* parent) {
+            trans.world = trans.local + (parent ? parent->world : 0);
+        });
+
+        CHECK(compMan.get_component<Transform>(hand).world == 100);
+        CHECK(compMan.get_component<Transform>(turret).world == 1001);
+    }
+    SECTION("can destroy subtrees with their components")
+    {
+        auto bystander = make(5);
+
+        CHECK(compMan.destroy_subtree(arm) == 2);
+        CHECK(compMan.num_components<int>() == 3);
+        CHECK(compMan.num_components<Transform>() == 3);
+        CHECK(children_of(root) == std::vector<int> { 1000 });
+
+        CHECK(compMan.destroy_subtree(root) == 2);
+        CHECK(compMan.num_components<int>() == 1);
+        CHECK(name_of(bystander) == 5);
+
+        // An entity outside of any hierarchy is its own subtree
+        CHECK(compMan.destroy_subtree(bystander) == 1);
+        CHECK(compMan.num_components<int>() == 0);
+    }
+    SECTION("orphans the children of destroyed entities")
+    {
+        compMan.destroy_entity(arm);
+        CHECK_FALSE(compMan.get_parent(hand));
+        CHECK(children_of(root) == std::vector<int> { 1000 });
+
+        std::vector<oki::Entity> doomed { root };
+        compMan.destroy_entities(doomed.begin(), doomed.end());
+        CHECK_FALSE(compMan.get_parent(turret));
+
+        std::vector<int> visited;
+        compMan.propagate<Transform>(
+            [&](oki::Entity entity, auto&, auto*) {
+                visited.push_back(name_of(entity));
+            });
+        CHECK(visited.empty());
+    }
+}
+
+namespace {
+struct Material
+{
+    int texture;
+    float shininess;
+
+    bool operator==(const Material& that) const
+    {
+        return texture == that.texture && shininess == that.shininess;
+    }
+};
+}
+
+template <>
+struct std::hash<Material>
+{
+    std::size_t operator()(const Material& mat) const noexcept
+    {
+        return std::hash<int> {}(mat.texture)
+            ^ std::hash<float> {}(mat.shininess);
+    }
+};
+
+template <>
+struct oki::StoreShared<Material> : std::true_type
+{ };
+
+TEST_CASE("ComponentManager (shared components)")
+{
+    oki::ComponentManager compMan;
+
+    std::vector<oki::Entity> entities;
+    for (int i = 0; i != 6; ++i) {
+        entities.push_back(compMan.create_entity());
+        compMan.bind_component(entities.back(), Material { i % 2, 0.5f });
+    }
+
+    SECTION("hands out equal values as one read-only copy")
+    {
+        const Material& first = compMan.get_component<Material>(entities[0]);
+        const Material& third = compMan.get_component<Material>(entities[2]);
+
+        CHECK(&first == &third);
+        CHECK(&first != &compMan.get_component<Material>(entities[1]));
+        CHECK(first.texture == 0);
+
+        static_assert(std::is_same_v<
+            decltype(compMan.get_component<Material>(entities[0])),
+            const Material&>);
+
+        auto ptr = compMan.get_component_checked<Material>(entities[3]);
+        REQUIRE(ptr);
+        CHECK(ptr->texture == 1);
+    }
+    SECTION("reassigns one entity at a time")
+    {
+        compMan.bind_or_assign_component(entities[0], Material { 7, 1.f });
+
+        CHECK(compMan.get_component<Material>(entities[0]).texture == 7);
+        CHECK(compMan.get_component<Material>(entities[2]).texture == 0);
+        CHECK(compMan.get_component<Material>(entities[4]).texture == 0);
+    }
+    SECTION("drops values once nothing refers to them")
+    {
+        compMan.remove_component<Material>(entities[1]);
+        compMan.destroy_entity(entities[3]);
+        compMan.destroy_entity(entities[5]);
+        CHECK(compMan.count<Material>() == 3);
+
+        compMan.bind_component(compMan.create_entity(), Material { 9, 0.f });
+        compMan.bind_component(compMan.create_entity(), Material { 9, 0.f });
+
+        std::vector<int> textures;
+        compMan.for_each<Material>([&](oki::Entity, const Material& mat) {
+            textures.push_back(mat.texture);
+        });
+
+        // Destroyed handles may be reused, so the order is not fixed
+        std::sort(textures.begin(), textures.end());
+        CHECK(textures == std::vector<int> { 0, 0, 0, 9, 9 });
+    }
+    SECTION("visits entities grouped by value")
+    {
+        for (int i = 0; i != 6; i += 3) {
+            compMan.bind_component(entities[i], i);
+        }
+
+        std::vector<std::pair<int, std::vector<int>>> groups;
+        std::size_t total = 0;
+
+        compMan.for_each_group<Material, int>(
+            [&](const Material& mat, auto& group) {
+                total += group.size();
+                groups.emplace_back(mat.texture, std::vector<int> {});
+
+                group.for_each([&](oki::Entity, int& num) {
+                    groups.back().second.push_back(num);
+                    ++num;
+                });
+            });
+
+        CHECK(total == 6);
+        REQUIRE(groups.size() == 2);
+        CHECK(groups[0]
+            == std::pair<int, std::vector<int>> { 0, std::vector<int> { 0 } });
+        CHECK(groups[1]
+            == std::pair<int, std::vector<int>> { 1, std::vector<int> { 3 } });
+        CHECK(compMan.get_component<int>(entities[3]) == 4);
+    }
+    SECTION("works with batch creation and destruction")
+    {
+        auto spawned = compMan.spawn<Material>(4, [](std::size_t) {
+            return std::make_tuple(Material { 0, 0.5f });
+        });
+        CHECK(compMan.count<Material>() == 10);
+        CHECK(&compMan.get_component<Material>(spawned[3])
+            == &compMan.get_component<Material>(entities[0]));
+
+        compMan.destroy_entities(entities.begin(), entities.end());
+        CHECK(compMan.count<Material>() == 4);
+
+        std::size_t groups = 0;
+        compMan.for_each_group<Material>([&](const Material& mat, auto& group) {
+            ++groups;
+            CHECK(mat.texture == 0);
+            CHECK(group.size() == 4);
+        });
+        CHECK(groups == 1);
+    }
+}
+
+namespace {
+struct PathTag;
+using Path = oki::Blob<int, PathTag>;
+}
+
+TEST_CASE("ComponentManager (blob components)")
+{
+    oki::ComponentManager compMan;
+
+    std::vector<oki::Entity> entities;
+    for (int i = 0; i != 4; ++i) {
+        entities.push_back(compMan.create_entity());
+        compMan.bind_component(entities.back(), Path(i + 1, i));
+    }
+
+    auto contents = [](auto ref) {
+        return std::vector<int>(ref.begin(), ref.end());
+    };
+
+    SECTION("can bind, retrieve and copy out blobs")
+    {
+        auto path = compMan.get_component<Path>(entities[2]);
+        CHECK(contents(path) == std::vector<int> { 2, 2, 2 });
+
+        Path copy = compMan.get_component<Path>(entities[1]);
+        CHECK(copy.elements() == std::vector<int> { 1, 1 });
+
+        CHECK_FALSE(compMan.bind_component(entities[0], Path { 9 }).second);
+        CHECK(compMan.get_component<Path>(entities[0]).size() == 1);
+
+        compMan.bind_or_assign_component(entities[0], Path { 7, 8, 9 });
+        CHECK(contents(compMan.get_component<Path>(entities[0]))
+            == std::vector<int> { 7, 8, 9 });
+
+        auto checked = compMan.get_component_checked<Path>(entities[3]);
+        REQUIRE(checked);
+        CHECK(checked->size() == 4);
+        CHECK_FALSE(
+            compMan.get_component_checked<Path>(compMan.create_entity()));
+    }
+    SECTION("grows blobs in place")
+    {
+        compMan.for_each<Path>([](oki::Entity, auto path) {
+            path.push_back(-1);
+        });
+
+        auto path = compMan.get_component<Path>(entities[1]);
+        CHECK(contents(path) == std::vector<int> { 1, 1, -1 });
+
+        path = Path { 5 };
+        CHECK(contents(compMan.get_component<Path>(entities[1]))
+            == std::vector<int> { 5 });
+        CHECK(contents(compMan.get_component<Path>(entities[3]))
+            == std::vector<int> { 3, 3, 3, 3, -1 });
+    }
+    SECTION("lays blobs out in iteration order when defragmented")
+    {
+        compMan.get_component<Path>(entities[0]).resize(50);
+        compMan.get_component<Path>(entities[2]).resize(50);
+        compMan.defragment<Path>();
+
+        const int* expected = nullptr;
+        compMan.for_each<Path>([&](oki::Entity, auto path) {
+            CHECK((!expected || path.data() == expected));
+            expected = path.data() + path.size();
+        });
+        CHECK(contents(compMan.get_component<Path>(entities[3]))
+            == std::vector<int>(4, 3));
+    }
+    SECTION("works with batch creation and destruction")
+    {
+        auto spawned = compMan.spawn<Path, int>(3, [](std::size_t i) {
+            return std::make_tuple(Path(i, 1), static_cast<int>(i));
+        });
+
+        int total = 0;
+        compMan.for_each<Path, int>([&](oki::Entity, auto path, int& num) {
+            total += static_cast<int>(path.size()) + num;
+        });
+        CHECK(total == 6);
+
+        compMan.destroy_entities(entities.begin(), entities.end());
+        CHECK(compMan.count<Path>() == 3);
+        CHECK(contents(compMan.get_component<Path>(spawned[2]))
+            == std::vector<int> { 1, 1 });
+
+        compMan.remove_component<Path>(spawned[2]);
+        CHECK_FALSE(compMan.has_component<Path>(spawned[2]));
+    }
+}
+
+namespace {
+struct NetId
+{
+    std::uint32_t id;
+};
+
+struct Soldier
+{
+    int team;
+    float health;
+    std::string name;
+};
+}
+
+template <>
+struct oki::IndexedBy<NetId> : oki::Indexes<oki::HashIndex<&NetId::id>>
+{ };
+
+template <>
+struct oki::IndexedBy<Soldier>
+    : oki::Indexes<oki::HashIndex<&Soldier::name>,
+          oki::OrderedIndex<&Soldier::team>,
+          oki::OrderedIndex<&Soldier::health>>
+{ };
+
+TEST_CASE("ComponentManager (indexed components)")
+{
+    oki::ComponentManager compMan;
+
+    std::vector<oki::Entity> entities;
+    for (int i = 0; i != 8; ++i) {
+        entities.push_back(compMan.create_entity());
+        compMan.bind_component(
+            entities.back(), NetId { static_cast<std::uint32_t>(i) });
+        compMan.bind_component(entities.back(),
+            Soldier { i % 3, 10.f * i, "soldier" + std::to_string(i) });
+    }
+
+    // Entities are told apart by their NetId (or -1 for none)
+    auto id_of = [&](std::optional<oki::Entity> entity) {
+        if (!entity) {
+            return -1;
+        }
+
+        return static_cast<int>(compMan.get_component<NetId>(*entity).id);
+    };
+    auto ids_of = [&](const std::vector<oki::Entity>& found) {
+        std::vector<int> ids;
+        for (auto entity : found) {
+            ids.push_back(id_of(entity));
+        }
+
+        return ids;
+    };
+    auto team = [&](int number) {
+        std::vector<oki::Entity> found;
+        compMan.find_all_by<&Soldier::team>(number, std::back_inserter(found));
+        return ids_of(found);
+    };
+    auto health_between = [&](float lo, float hi) {
+        std::vector<oki::Entity> found;
+        compMan.find_range_by<&Soldier::health>(
+            lo, hi, std::back_inserter(found));
+        return ids_of(found);
+    };
+
+    SECTION("finds entities by equal field values")
+    {
+        CHECK(id_of(compMan.find_by<&NetId::id>(3)) == 3);
+        CHECK_FALSE(compMan.find_by<&NetId::id>(42));
+        CHECK(id_of(compMan.find_by<&Soldier::name>("soldier5")) == 5);
+
+        CHECK(team(1) == std::vector<int> { 1, 4, 7 });
+        CHECK(id_of(compMan.find_by<&Soldier::team>(2)) == 2);
+        CHECK(team(3).empty());
+
+        static_assert(
+            std::is_same_v<decltype(compMan.get_component<NetId>(entities[0])),
+                const NetId&>);
+    }
+    SECTION("finds entities by field ranges")
+    {
+        CHECK(health_between(15.f, 45.f) == std::vector<int> { 2, 3, 4 });
+        CHECK(health_between(70.f, 1000.f) == std::vector<int> { 7 });
+        CHECK(health_between(1.f, 5.f).empty());
+    }
+    SECTION("follows assignments and removals")
+    {
+        compMan.bind_or_assign_component(
+            entities[1], Soldier { 2, 5.f, "renamed" });
+        compMan.remove_component<Soldier>(entities[3]);
+        compMan.destroy_entity(entities[4]);
+
+        CHECK_FALSE(compMan.find_by<&NetId::id>(4));
+        CHECK(id_of(compMan.find_by<&NetId::id>(5)) == 5);
+
+        CHECK_FALSE(compMan.find_by<&Soldier::name>("soldier1"));
+        CHECK(id_of(compMan.find_by<&Soldier::name>("renamed")) == 1);
+        CHECK(team(0) == std::vector<int> { 0, 6 });
+        CHECK(team(1) == std::vector<int> { 7 });
+        CHECK(team(2) == std::vector<int> { 1, 2, 5 });
+
+        // Changing a value and changing it back leaves a single entry
+        compMan.bind_or_assign_component(
+            entities[7], Soldier { 0, 70.f, "soldier7" });
+        compMan.bind_or_assign_component(
+            entities[7], Soldier { 1, 70.f, "soldier7" });
+        CHECK(team(1) == std::vector<int> { 7 });
+
+        CHECK(health_between(0.f, 20.f) == std::vector<int> { 0, 1 });
+    }
+    SECTION("works with batch creation and destruction")
+    {
+        auto spawned = compMan.spawn<NetId>(3, [](std::size_t i) {
+            return std::make_tuple(NetId { static_cast<std::uint32_t>(i + 8) });
+        });
+        CHECK(id_of(compMan.find_by<&NetId::id>(10)) == 10);
+
+        compMan.destroy_entities(entities.begin() + 2, entities.end());
+        CHECK(team(0) == std::vector<int> { 0 });
+        CHECK_FALSE(compMan.find_by<&NetId::id>(7));
+        CHECK(id_of(compMan.find_by<&NetId::id>(1)) == 1);
+
+        compMan.erase_components<Soldier>();
+        CHECK(team(1).empty());
+        CHECK_FALSE(compMan.find_by<&Soldier::name>("soldier0"));
+        CHECK(id_of(compMan.find_by<&NetId::id>(spawned.size() + 7)) == 10);
+    }
+}
+
+TEST_CASE("ComponentManager (destroying repeated entities)")
+{
+    oki::ComponentManager compMan;
+
+    std::vector<oki::Entity> entities;
+    for (int i = 0; i != 4; ++i) {
+        entities.push_back(compMan.create_entity());
+        compMan.bind_component(entities.back(), Material { 5, 0.f });
+        compMan.bind_component(entities.back(), Path(i + 1, i));
+        compMan.bind_component(entities.back(),
+            Soldier { 0, 10.f * i, "soldier" + std::to_string(i) });
+    }
+
+    std::vector<oki::Entity> repeats { entities[0], entities[0], entities[2],
+        entities[2], entities[2] };
+    CHECK(compMan.destroy_entities(repeats.begin(), repeats.end()) == 2);
+    CHECK_FALSE(compMan.has_component<Material>(entities[0]));
+    CHECK(compMan.count<Material>() == 2);
+    CHECK(compMan.count<Path>() == 2);
+
+    // Had the value been released more than once, this would take its slot
+    compMan.bind_component(compMan.create_entity(), Material { 9, 0.f });
+    CHECK(compMan.get_component<Material>(entities[1]).texture == 5);
+    CHECK(compMan.get_component<Material>(entities[3]).texture == 5);
+
+    // Likewise, the blobs' arena would lose count of what it holds, which
+    // laying them out again relies on
+    auto contents = [](auto ref) {
+        return std::vector<int>(ref.begin(), ref.end());
+    };
+    compMan.defragment<Path>();
+    CHECK(contents(compMan.get_component<Path>(entities[1]))
+        == std::vector<int> { 1, 1 });
+    CHECK(contents(compMan.get_component<Path>(entities[3]))
+        == std::vector<int> { 3, 3, 3, 3 });
+
+    // And unindexing a component twice would drop another's entry
+    std::vector<oki::Entity> found;
+    compMan.find_all_by<&Soldier::team>(0, std::back_inserter(found));
+
+    std::vector<float> healths;
+    for (auto each : found) {
+        healths.push_back(compMan.get_component<Soldier>(each).health);
+    }
+    CHECK(healths == std::vector<float> { 10.f, 30.f });
+    CHECK(compMan.find_by<&Soldier::name>("soldier3"));
+    CHECK_FALSE(compMan.find_by<&Soldier::name>("soldier2"));
+}
+
+namespace {
+// Counts copies, to tell what a publish copied
+struct Sprite
+{
+    int frame;
+
+    static inline std::size_t copies = 0;
+
+    Sprite(int value)
+        : frame(value)
+    {
+    }
+
+    Sprite(const Sprite& that)
+        : frame(that.frame)
+    {
+        ++copies;
+    }
+
+    Sprite& operator=(const Sprite& that)
+    {
+        frame = that.frame;
+        ++copies;
+
+        return *this;
+    }
+};
+}
+
+template <>
+struct oki::StoreBuffered<Sprite> : std::true_type
+{ };
+
+TEST_CASE("ComponentManager (buffered components)")
+{
+    oki::ComponentManager compMan;
+    oki::ComponentManager::TripleBuffer<Sprite> buffer;
+    auto entity = compMan.create_entity();
+
+    SECTION("can publish components to a triple buffer")
+    {
+        CHECK(buffer.acquire().empty());
+
+        compMan.bind_component(entity, Sprite { 1 });
+        compMan.publish_components(buffer);
+
+        auto front = buffer.acquire();
+        compMan.get_component<Sprite>(entity).frame = 2;
+        auto other = compMan.create_entity();
+        compMan.bind_component(other, Sprite { 3 });
+
+        // Unaffected until published and acquired again
+        REQUIRE(front.size() == 1);
+        CHECK(front.get(entity).frame == 1);
+        CHECK(buffer.acquire().get(entity).frame == 1);
+
+        compMan.publish_components(buffer);
+        compMan.get_component<Sprite>(entity).frame = 4;
+        compMan.publish_components(buffer);
+
+        front = buffer.acquire();
+        CHECK(front.size() == 2);
+        CHECK(front.get(entity).frame == 4);
+
+        int sum = 0;
+        front.for_each(
+            [&](oki::Entity, const Sprite& sprite) { sum += sprite.frame; });
+        CHECK(sum == 4 + 3);
+
+        compMan.destroy_entity(other);
+        compMan.publish_components(buffer);
+        CHECK_FALSE(buffer.acquire().contains(other));
+    }
+    SECTION("publishes only the components that changed")
+    {
+        std::vector<oki::Entity> entities { entity };
+        for (int i = 0; i != 999; ++i) {
+            entities.push_back(compMan.create_entity());
+        }
+        for (auto each : entities) {
+            compMan.bind_component(each, Sprite { 0 });
+        }
+
+        // The first publish to each of the three copies copies everything
+        for (int i = 0; i != 3; ++i) {
+            compMan.publish_components(buffer);
+            buffer.acquire();
+        }
+
+        // Here, each publish copies what changed over the last 3 frames
+        Sprite::copies = 0;
+        for (int frame = 1; frame != 11; ++frame) {
+            compMan.get_component<Sprite>(entities[frame]).frame = frame;
+            CHECK(compMan.count<Sprite>() == 1000);
+
+            compMan.publish_components(buffer);
+            CHECK(buffer.acquire().get(entities[frame]).frame == frame);
+        }
+        CHECK(Sprite::copies <= 10 * 3);
+
+        // Iterating over an intersection only counts the matches
+        compMan.bind_component(entities[500], 0);
+        compMan.for_each<Sprite, int>(
+            [](oki::Entity, Sprite& sprite, int) { sprite.frame = 500; });
+
+        Sprite::copies = 0;
+        compMan.publish_components(buffer);
+        CHECK(Sprite::copies <= 3);
+        CHECK(buffer.acquire().get(entities[500]).frame == 500);
+    }
+    SECTION("publishes everything after access from several threads")
+    {
+        for (int i = 0; i != 10; ++i) {
+            compMan.bind_component(compMan.create_entity(), Sprite { 0 });
+        }
+        compMan.publish_components(buffer);
+
+        compMan.reduce<Sprite>(
+            0,
+            [](oki::Entity, Sprite& sprite) {
+                sprite.frame = 1;
+                return 0;
+            },
+            [](int lhs, int rhs) { return lhs + rhs; });
+
+        compMan.publish_components(buffer);
+
+        int sum = 0;
+        buffer.acquire().for_each(
+            [&](oki::Entity, const Sprite& sprite) { sum += sprite.frame; });
+        CHECK(sum == 10);
+    }
+    SECTION("can read a triple buffer while publishing")
+    {
+        constexpr int FRAMES = 2'000;
+
+        std::vector<oki::Entity> entities { entity };
+        for (int i = 0; i != 99; ++i) {
+            entities.push_back(compMan.create_entity());
+        }
+
+        std::atomic<bool> done = false;
+        std::size_t torn = 0;
+
+        // Every published frame has the same value for each entity
+        std::thread reader([&]() {
+            while (!done) {
+                std::set<int> values;
+                buffer.acquire().for_each([&](oki::Entity, const Sprite& s) {
+                    values.insert(s.frame);
+                });
+
+                torn += values.size() > 1;
+            }
+        });
+
+        for (int frame = 0; frame != FRAMES; ++frame) {
+            for (auto other : entities) {
+                compMan.bind_or_assign_component(other, Sprite { frame });
+            }
+
+            compMan.publish_components(buffer);
+        }
+
+        done = true;
+        reader.join();
+
+        CHECK(torn == 0);
+        CHECK(buffer.acquire().get(entity).frame == FRAMES - 1);
+    }
+}
+
+#if OKI_CONCURRENT_HANDLES
+TEST_CASE("ComponentManager (concurrent handles)")
+{
+    oki::ComponentManager compMan;
+
+    SECTION("creates distinct entities from many threads")
+    {
+        constexpr std::size_t PER_THREAD = 1'000;
+        std::array<std::vector<oki::Entity>, 4> created;
+
+        std::vector<std::thread> threads;
+        for (auto& entities : created) {
+            threads.emplace_back([&compMan, &entities]() {
+                for (std::size_t i = 0; i != PER_THREAD; ++i) {
+                    entities.push_back(compMan.create_entity());
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // Components are bound after joining; each entity gets its own
+        int next = 0;
+        for (const auto& entities : created) {
+            for (auto entity : entities) {
+                REQUIRE(compMan.bind_component(entity, next++).second);
+            }
+        }
+
+        CHECK(compMan.num_components<int>() == created.size() * PER_THREAD);
+    }
+    SECTION("reuses entities destroyed by the same thread")
+    {
+        std::vector<oki::Entity> entities;
+        for (int i = 0; i != 3; ++i) {
+            entities.push_back(compMan.create_entity());
+            compMan.bind_component(entities.back(), i);
+        }
+
+        compMan.destroy_entity(entities[1]);
+        auto reused = compMan.create_entity();
+        CHECK_FALSE(compMan.get_component_checked<int>(reused));
+
+        compMan.bind_component(reused, 7);
+        CHECK(compMan.get_component<int>(entities[1]) == 7);
+    }
+}
+#endif
+
+#if OKI_CHECKED
+TEST_CASE("ComponentManager (checked)")
+{
+    oki::ComponentManager compMan;
+    auto entity = compMan.create_entity();
+
+#if !OKI_CONCURRENT_HANDLES
+    // (Concurrent handles cannot tell destroyed ones apart, see
+    // oki_config.h)
+    SECTION("rejects destroyed entities")
+    {
+        compMan.bind_component(entity, 0);
+        compMan.destroy_entity(entity);
+
+        REQUIRE_THROWS_AS(compMan.bind_component(entity, 1), std::logic_error);
+        REQUIRE_THROWS_AS(compMan.get_component<int>(entity), std::logic_error);
+        REQUIRE_FALSE(compMan.destroy_entity(entity));
+    }
+#endif
+    SECTION("rejects missing components in get_component()")
+    {
+        REQUIRE_THROWS_AS(compMan.get_component<int>(entity), std::logic_error);
+
+        compMan.bind_component(compMan.create_entity(), 0);
+        REQUIRE_THROWS_AS(compMan.get_component<int>(entity), std::logic_error);
+        auto accessor = compMan.get_component_accessor<int>();
+        REQUIRE_THROWS_AS(accessor.get(entity), std::logic_error);
+    }
+    SECTION("rejects duplicate components in bind_component_unchecked()")
+    {
+        compMan.bind_component(entity, 0);
+
+        REQUIRE_THROWS_AS(
+            compMan.bind_component_unchecked(entity, 1), std::logic_error);
+        CHECK(compMan.get_component<int>(entity) == 0);
+    }
+    SECTION("rejects adding or removing components of an iterated type")
+    {
+        auto other = compMan.create_entity();
+        compMan.bind_component(entity, 0);
+
+        compMan.for_each<int>([&](auto, auto) {
+            CHECK_THROWS_AS(compMan.bind_component(other, 1), std::logic_error);
+            CHECK_THROWS_AS(
+                compMan.remove_component<int>(entity), std::logic_error);
+            CHECK_THROWS_AS(compMan.destroy_entity(entity), std::logic_error);
+            CHECK_THROWS_AS(compMan.erase_components(), std::logic_error);
+        });
+
+        auto view = compMan.get_component_view<int>();
+        view.for_each([&](auto, auto) {
+            CHECK_THROWS_AS(
+                compMan.erase_components<int>(), std::logic_error);
+        });
+
+        CHECK(compMan.num_components<int>() == 1);
+    }
+    SECTION("allows changes that leave the iterated types alone")
+    {
+        compMan.bind_component(entity, 0);
+
+        compMan.for_each<int>([&](auto ent, auto) {
+            compMan.bind_component(ent, 'c');
+            compMan.bind_or_assign_component(ent, 1);
+            compMan.remove_component<float>(ent);
+        });
+
+        CHECK(compMan.get_component<char>(entity) == 'c');
+        CHECK(compMan.get_component<int>(entity) == 1);
+
+        // Iteration is over, so this is fine again
+        CHECK(compMan.destroy_entity(entity));
+    }
+}
+#endif
@@ -1,5 +1,11 @@
+#include "oki/oki_blob.h"
 #include "oki/oki_handle.h"
+#include "oki/util/oki_blob_vector.h"
+#include "oki/util/oki_column_vector.h"
 #include "oki/util/oki_container.h"
+#include "oki/util/oki_field_index.h"
+#include "oki/util/oki_indexed_vector.h"
+#include "oki/util/oki_shared_vector.h"
 
 #include "oki_test_util.h"
 
@@ -74,6 +80,36 @@ TEST_CASE("AssocSortedVector", "[logic][ecs][container]")
         REQUIRE(iter->first == 2);
         REQUIRE(iter->second == "2");
     }
+    SECTION("can append in bulk, then merge")
+    {
+        map.insert(7, "7");
+
+        auto oldSize = map.size();
+        for (oki::Handle key : { 1, 4, 9 }) {
+            map.append_unchecked(key, std::to_string(key));
+        }
+        map.merge_appended(oldSize);
+
+        std::vector<oki::Handle> keys;
+        for (const auto& [key, value] : map) {
+            CHECK(value == std::to_string(key));
+            keys.push_back(key);
+        }
+        CHECK(keys == std::vector<oki::Handle> { 1, 2, 4, 7, 9 });
+    }
+    SECTION("can erase sorted keys in bulk")
+    {
+        for (oki::Handle key : { 1, 3, 4, 5 }) {
+            map.insert(key, std::to_string(key));
+        }
+
+        std::vector<oki::Handle> erase { 0, 2, 4, 5, 6 };
+        CHECK(map.erase_sorted(erase.begin(), erase.end()) == 3);
+
+        REQUIRE(map.size() == 2);
+        CHECK(map.begin()[0].second == "1");
+        CHECK(map.begin()[1].second == "3");
+    }
     SECTION("does change values via insert_or_assign()")
     {
         auto [iter, success] = map.insert_or_assign(2, "0");
@@ -141,6 +177,48 @@ TEST_CASE("AssocSortedVector", "[logic][ecs][container]")
         map.clear();
         CHECK(map.size() == 0);
     }
+    SECTION("agrees with lower_bound() in batches")
+    {
+        std::vector<oki::Handle> keys;
+        for (oki::Handle key = 0; key <= 202; ++key) {
+            keys.push_back((key * 37) % 203);
+        }
+
+        std::vector<std::size_t> found;
+        for (std::size_t size : { 0, 1, 2, 3, 100 }) {
+            map.clear();
+            for (oki::Handle key = 1; key <= size; ++key) {
+                map.insert(key * 2, std::to_string(key));
+            }
+
+            found.clear();
+            map.lower_bound_batch(
+                keys.begin(), keys.end(), std::back_inserter(found));
+
+            REQUIRE(found.size() == keys.size());
+            for (std::size_t i = 0; i != keys.size(); ++i) {
+                CHECK(map.begin() + found[i] == map.lower_bound(keys[i]));
+            }
+        }
+    }
+    SECTION("agrees with lower_bound() from any hint")
+    {
+        map.clear();
+        for (oki::Handle key = 2; key <= 200; key += 2) {
+            map.insert(key, std::to_string(key));
+        }
+
+        const auto& cMap = map;
+        for (oki::Handle key = 0; key <= 202; ++key) {
+            for (auto hint = cMap.cbegin();; ++hint) {
+                CHECK(map.lower_bound(key, hint) == map.lower_bound(key));
+
+                if (hint == cMap.cend()) {
+                    break;
+                }
+            }
+        }
+    }
 
     SECTION("(lifetime management)")
     {
@@ -229,6 +307,447 @@ TEST_CASE("AssocSortedVector", "[logic][ecs][container]")
     }
 }
 
+namespace {
+struct Particle
+{
+    int x;
+    double y;
+    char tag;
+};
+}
+
+TEST_CASE("ColumnSortedVector", "[logic][ecs][container]")
+{
+    oki::intl_::ColumnSortedVector<oki::Handle, Particle> map;
+    for (oki::Handle key : { 6, 2, 8, 4 }) {
+        map.emplace(key, static_cast<int>(key), key * 0.5, 'a');
+    }
+
+    SECTION("keeps every column sorted by key")
+    {
+        REQUIRE(map.size() == 4);
+
+        oki::Handle expected = 2;
+        for (auto [key, ref] : map) {
+            CHECK(key == expected);
+            CHECK(ref.get<0>() == static_cast<int>(key));
+            CHECK(ref.get<1>() == key * 0.5);
+
+            expected += 2;
+        }
+
+        auto xs = map.column<0>();
+        CHECK(std::vector<int>(xs.begin(), xs.end())
+            == std::vector<int> { 2, 4, 6, 8 });
+    }
+    SECTION("does not overwrite in emplace(), but does in insert_or_assign()")
+    {
+        CHECK_FALSE(map.emplace(4, 0, 0.0, 'b').second);
+        CHECK(map.find(4)->second.get<2>() == 'a');
+
+        CHECK_FALSE(map.insert_or_assign(4, Particle { 0, 0.0, 'b' }).second);
+        CHECK(map.find(4)->second.get<2>() == 'b');
+
+        CHECK(map.insert_or_assign(5, Particle { 5, 2.5, 'c' }).second);
+        CHECK(static_cast<Particle>(map.begin()[2].second).tag == 'c');
+    }
+    SECTION("erases from every column")
+    {
+        CHECK(map.erase(4));
+        CHECK_FALSE(map.erase(4));
+        CHECK_FALSE(map.contains(4));
+
+        CHECK(map.column<1>().size() == 3);
+        CHECK(map.column<2>().size() == 3);
+        CHECK(map.begin()[1].second.get<0>() == 6);
+    }
+    SECTION("can append and erase in bulk")
+    {
+        auto oldSize = map.size();
+        for (oki::Handle key : { 1, 5, 9 }) {
+            map.append_unchecked(key, static_cast<int>(key), key * 0.5, 'b');
+        }
+        map.merge_appended(oldSize);
+
+        auto xs = map.column<0>();
+        CHECK(std::vector<int>(xs.begin(), xs.end())
+            == std::vector<int> { 1, 2, 4, 5, 6, 8, 9 });
+        CHECK(map.find(5)->second.get<1>() == 2.5);
+
+        std::vector<oki::Handle> erase { 1, 4, 8, 10 };
+        CHECK(map.erase_sorted(erase.begin(), erase.end()) == 3);
+
+        auto tags = map.column<2>();
+        CHECK(std::vector<char>(tags.begin(), tags.end())
+            == std::vector<char> { 'a', 'b', 'a', 'b' });
+        CHECK(map.begin()[3].first == 9);
+        CHECK(map.begin()[3].second.get<0>() == 9);
+    }
+    SECTION("agrees with AssocSortedVector on lower_bound()")
+    {
+        map.clear();
+
+        oki::intl_::AssocSortedVector<oki::Handle, int> reference;
+        for (oki::Handle key = 0; key <= 100; key += 3) {
+            map.insert_or_assign(key, Particle {});
+            reference.insert_or_assign(key, 0);
+        }
+
+        std::vector<oki::Handle> keys;
+        for (oki::Handle key = 0; key <= 102; ++key) {
+            keys.push_back((key * 37) % 103);
+        }
+
+        std::vector<std::size_t> found, expected;
+        map.lower_bound_batch(
+            keys.begin(), keys.end(), std::back_inserter(found));
+        reference.lower_bound_batch(
+            keys.begin(), keys.end(), std::back_inserter(expected));
+        CHECK(found == expected);
+
+        auto hint = map.cbegin() + 10;
+        for (auto key : keys) {
+            auto iter = map.lower_bound(key, hint);
+
+            CHECK(iter == map.lower_bound(key));
+            CHECK(iter - map.begin()
+                == reference.lower_bound(key) - reference.begin());
+        }
+    }
+}
+
+TEST_CASE("SharedSortedVector", "[logic][ecs][container]")
+{
+    oki::intl_::SharedSortedVector<oki::Handle, std::string> map;
+    for (oki::Handle key : { 6, 2, 8, 4 }) {
+        map.emplace(key, (key % 4) ? "odd" : "even");
+    }
+
+    SECTION("stores each distinct value once")
+    {
+        REQUIRE(map.size() == 4);
+        CHECK(map.num_values() == 2);
+        CHECK(&map.find(4)->second == &map.find(8)->second);
+
+        oki::Handle expected = 2;
+        for (auto [key, value] : map) {
+            CHECK(key == expected);
+            CHECK(value == ((key % 4) ? "odd" : "even"));
+
+            expected += 2;
+        }
+    }
+    SECTION("does not overwrite in emplace(), but does in insert_or_assign()")
+    {
+        CHECK_FALSE(map.emplace(4, "new").second);
+        CHECK(map.find(4)->second == "even");
+        CHECK(map.num_values() == 2);
+
+        CHECK_FALSE(map.insert_or_assign(4, "new").second);
+        CHECK(map.find(4)->second == "new");
+        CHECK(map.find(8)->second == "even");
+        CHECK(map.num_values() == 3);
+
+        CHECK(map.insert_or_assign(5, "new").second);
+        CHECK(map.num_values() == 3);
+    }
+    SECTION("drops values once no key refers to them")
+    {
+        CHECK(map.erase(2));
+        CHECK_FALSE(map.erase(2));
+        CHECK(map.num_values() == 2);
+
+        map.erase(map.find(6));
+        CHECK(map.num_values() == 1);
+
+        std::vector<oki::Handle> erase { 1, 4, 8, 10 };
+        CHECK(map.erase_sorted(erase.begin(), erase.end()) == 2);
+        CHECK(map.num_values() == 0);
+        CHECK(map.size() == 0);
+
+        map.insert(3, "third");
+        map.insert(5, "fifth");
+        CHECK(map.num_values() == 2);
+        CHECK(map.find(3)->second == "third");
+        CHECK(map.find(5)->second == "fifth");
+    }
+    SECTION("can append in bulk")
+    {
+        auto oldSize = map.size();
+        for (oki::Handle key : { 1, 5, 9 }) {
+            map.append_unchecked(key, "odd");
+        }
+        map.merge_appended(oldSize);
+
+        std::vector<oki::Handle> keys;
+        for (auto [key, value] : map) {
+            keys.push_back(key);
+        }
+        CHECK(keys == std::vector<oki::Handle> { 1, 2, 4, 5, 6, 8, 9 });
+        CHECK(map.num_values() == 2);
+    }
+    SECTION("groups keys by value")
+    {
+        std::map<std::string, std::vector<oki::Handle>> groups;
+        auto collect = [&](const std::string& value, const std::size_t* first,
+                           const std::size_t* last) {
+            CHECK(groups.count(value) == 0);
+            for (; first != last; ++first) {
+                groups[value].push_back(map.begin()[*first].first);
+            }
+        };
+        map.for_each_group(collect);
+
+        CHECK(groups.size() == 2);
+        CHECK(groups["odd"] == std::vector<oki::Handle> { 2, 6 });
+        CHECK(groups["even"] == std::vector<oki::Handle> { 4, 8 });
+    }
+}
+
+TEST_CASE("BlobSortedVector", "[logic][ecs][container]")
+{
+    using Blob = oki::Blob<int>;
+
+    oki::intl_::BlobSortedVector<oki::Handle, Blob> map;
+    for (oki::Handle key : { 6, 2, 8, 4 }) {
+        map.emplace(key, Blob(key, static_cast<int>(key)));
+    }
+
+    auto contents = [](auto ref) {
+        return std::vector<int>(ref.begin(), ref.end());
+    };
+
+    SECTION("keeps each blob's elements together")
+    {
+        REQUIRE(map.size() == 4);
+        CHECK(map.num_elements() == 20);
+
+        oki::Handle expected = 2;
+        for (auto [key, blob] : map) {
+            CHECK(key == expected);
+            CHECK(contents(blob)
+                == std::vector<int>(key, static_cast<int>(key)));
+
+            expected += 2;
+        }
+
+        // Until compacted, blobs are laid out in order of insertion
+        auto first = map.find(6)->second;
+        CHECK(first.data() + first.size() == map.find(2)->second.data());
+    }
+    SECTION("does not overwrite in emplace(), but does in insert_or_assign()")
+    {
+        CHECK_FALSE(map.emplace(4, Blob { 1 }).second);
+        CHECK(map.find(4)->second.size() == 4);
+
+        CHECK_FALSE(map.insert_or_assign(4, Blob { 1, 2 }).second);
+        CHECK(contents(map.find(4)->second) == std::vector<int> { 1, 2 });
+        CHECK(contents(map.find(6)->second) == std::vector<int>(6, 6));
+
+        CHECK(map.insert_or_assign(5, Blob { 5 }).second);
+        CHECK(contents(map.begin()[2].second) == std::vector<int> { 5 });
+    }
+    SECTION("grows blobs in place or by moving them")
+    {
+        auto last = map.find(8)->second;
+        last.push_back(9);
+        CHECK(last.size() == 9);
+        CHECK(last[8] == 9);
+
+        auto inner = map.find(4)->second;
+        std::vector<int> tail { 1, 2, 3 };
+        inner.append(tail.begin(), tail.end());
+        inner.resize(9);
+        CHECK(contents(inner)
+            == std::vector<int> { 4, 4, 4, 4, 1, 2, 3, 0, 0 });
+        CHECK(inner.capacity() >= 9);
+
+        // Others are untouched, even though the arena may have moved
+        CHECK(contents(map.find(6)->second) == std::vector<int>(6, 6));
+        CHECK(contents(last) == std::vector<int> { 8, 8, 8, 8, 8, 8, 8, 8, 9 });
+
+        inner.resize(2);
+        CHECK(contents(inner) == std::vector<int> { 4, 4 });
+        CHECK(map.num_elements() == 19);
+    }
+    SECTION("grows capacity geometrically, moving blobs only to grow it")
+    {
+        auto inner = map.find(4)->second;
+        auto capacity = inner.capacity();
+        auto* data = inner.data();
+
+        for (int i = 0; i != 100; ++i) {
+            inner.push_back(i);
+
+            if (inner.capacity() != capacity) {
+                CHECK(inner.capacity() >= capacity * 2);
+                capacity = inner.capacity();
+                data = inner.data();
+            }
+            CHECK(inner.data() == data);
+        }
+        CHECK(inner.size() == 104);
+        CHECK(contents(map.find(6)->second) == std::vector<int>(6, 6));
+    }
+    SECTION("restores key order when compacted")
+    {
+        map.find(2)->second.resize(100);
+        map.find(6)->second.clear();
+        map.compact();
+
+        std::size_t offset = 0;
+        for (auto [key, blob] : map) {
+            CHECK(blob.data() == map.begin()->second.data() + offset);
+            CHECK(blob.capacity() == blob.size());
+            offset += blob.size();
+        }
+        CHECK(offset == 112);
+        CHECK(contents(map.find(4)->second) == std::vector<int>(4, 4));
+    }
+    SECTION("erases and compacts once mostly holes")
+    {
+        for (oki::Handle key = 10; key != 20; ++key) {
+            map.emplace(key, Blob(500, 1));
+        }
+        auto usage = map.memory_usage();
+
+        CHECK(map.erase(4));
+        CHECK_FALSE(map.erase(4));
+
+        std::vector<oki::Handle> erase { 2, 10, 11, 12, 13, 14, 15, 16, 17 };
+        CHECK(map.erase_sorted(erase.begin(), erase.end()) == 9);
+        CHECK(map.num_elements() == 1014);
+
+        map.shrink_to_fit();
+        CHECK(map.memory_usage() < usage / 4);
+        CHECK(contents(map.find(18)->second) == std::vector<int>(500, 1));
+        CHECK(contents(map.find(8)->second) == std::vector<int>(8, 8));
+    }
+}
+
+namespace {
+struct Unit
+{
+    int team;
+    std::string name;
+};
+}
+
+template <>
+struct oki::IndexedBy<Unit>
+    : oki::Indexes<oki::HashIndex<&Unit::name>, oki::OrderedIndex<&Unit::team>>
+{ };
+
+TEST_CASE("IndexedSortedVector", "[logic][ecs][container]")
+{
+    oki::intl_::IndexedSortedVector<oki::Handle, Unit> map;
+    for (oki::Handle key : { 6, 2, 8, 4 }) {
+        map.emplace(
+            key, Unit { static_cast<int>(key % 4), std::to_string(key) });
+    }
+
+    auto team = [&](int number) {
+        std::vector<oki::Handle> found;
+        auto collect = [&](oki::Handle key) { found.push_back(key); };
+        map.for_each_equal<&Unit::team>(number, collect);
+
+        return found;
+    };
+    auto named = [&](const std::string& name) {
+        auto key = map.find_first<&Unit::name>(name);
+        return key ? static_cast<int>(*key) : -1;
+    };
+
+    SECTION("unindexes the keys erased by erase_sorted()")
+    {
+        std::vector<oki::Handle> erase { 2, 4 };
+        CHECK(map.erase_sorted(erase.begin(), erase.end()) == 2);
+
+        CHECK(team(2) == std::vector<oki::Handle> { 6 });
+        CHECK(team(0) == std::vector<oki::Handle> { 8 });
+        CHECK(named("2") == -1);
+        CHECK(named("6") == 6);
+
+        map.emplace(2, Unit { 2, "2" });
+        CHECK(team(2) == std::vector<oki::Handle> { 2, 6 });
+        CHECK(named("2") == 2);
+    }
+    SECTION("passes over unmatched removals in the ordered index")
+    {
+        oki::intl_::OrderedFieldIndex<oki::Handle, &Unit::team> index;
+        for (auto [key, unit] : map) {
+            index.insert(key, unit);
+        }
+
+        // The repeat matches nothing once the first has been applied
+        index.erase(2, map.find(2)->second);
+        index.erase(2, map.find(2)->second);
+        index.erase(8, map.find(8)->second);
+
+        std::vector<oki::Handle> found;
+        auto collect = [&](oki::Handle key) { found.push_back(key); };
+        index.for_each_in_range(0, 3, collect);
+        CHECK(found == std::vector<oki::Handle> { 4, 6 });
+    }
+    SECTION("keeps a value's keys in order as the lowest are taken off")
+    {
+        oki::intl_::HashFieldIndex<oki::Handle, &Unit::name> index;
+        Unit unit { 0, "shared" };
+        for (oki::Handle key = 0; key != 10; ++key) {
+            index.insert(key, unit);
+        }
+
+        auto keys = [&]() {
+            std::vector<oki::Handle> found;
+            auto collect = [&](oki::Handle key) { found.push_back(key); };
+            index.for_each_equal("shared", collect);
+
+            return found;
+        };
+
+        // As destroying entities in order does
+        for (oki::Handle key = 0; key != 4; ++key) {
+            index.erase(key, unit);
+        }
+        CHECK(*index.find_first("shared") == 4);
+
+        index.insert(1, unit);
+        index.insert(0, unit);
+        index.erase(7, unit);
+        CHECK(keys() == std::vector<oki::Handle> { 0, 1, 4, 5, 6, 8, 9 });
+
+        for (oki::Handle key : { 0, 1, 4, 5, 6, 8 }) {
+            index.erase(key, unit);
+        }
+        CHECK(keys() == std::vector<oki::Handle> { 9 });
+
+        index.erase(9, unit);
+        CHECK_FALSE(index.find_first("shared"));
+    }
+    SECTION("bounds the ordered index's queued changes without lookups")
+    {
+        oki::intl_::OrderedFieldIndex<oki::Handle, &Unit::team> index;
+        for (auto [key, unit] : map) {
+            index.insert(key, unit);
+        }
+
+        // Reassigning a component unindexes its old value and indexes
+        // the new one
+        Unit unit = map.find(2)->second;
+        for (int i = 0; i != 10'000; ++i) {
+            index.erase(2, unit);
+            unit.team = i;
+            index.insert(2, unit);
+        }
+        CHECK(index.memory_usage() < 1'000 * sizeof(std::pair<int, int>));
+
+        std::vector<oki::Handle> found;
+        auto collect = [&](oki::Handle key) { found.push_back(key); };
+        index.for_each_in_range(0, 10'000, collect);
+        CHECK(found == std::vector<oki::Handle> { 4, 8, 6, 2 });
+    }
+}
+
 namespace test_helper {
 template <typename Type>
 class IntersectionHelper
@@ -300,6 +819,37 @@ TEST_CASE("variadic_set_intersection()", "[logic][ecs][algorithm]")
 
         helper.do_test({}, map1, map2);
     }
+    SECTION("stops early when the callback returns false")
+    {
+        auto map1 = helper.create_map({ 1, 2, 3, 4, 5 });
+        auto map2 = helper.create_map({ 1, 3, 4, 5 });
+
+        std::vector<oki::Handle> keys;
+        oki::intl_::variadic_set_intersection(
+            [&](auto& pair, auto&) {
+                keys.push_back(pair.first);
+                return pair.first < 3;
+            },
+            std::make_pair(map1.begin(), map1.end()),
+            std::make_pair(map2.begin(), map2.end()));
+
+        REQUIRE(keys == std::vector<oki::Handle> { 1, 3 });
+    }
+    SECTION("counts matches the same way it iterates them")
+    {
+        auto map1 = helper.create_map({ 1, 2, 3, 4, 6, 7, 8, 9 });
+        auto map2 = helper.create_map({ 0, 2, 3, 5, 7, 9 });
+        auto map3 = helper.create_map({ 0, 2, 3, 6, 7, 8, 9 });
+
+        REQUIRE(oki::intl_::count_set_intersection(
+                    std::make_pair(map1.cbegin(), map1.cend()))
+            == 8);
+        REQUIRE(oki::intl_::count_set_intersection(
+                    std::make_pair(map1.cbegin(), map1.cend()),
+                    std::make_pair(map2.cbegin(), map2.cend()),
+                    std::make_pair(map3.cbegin(), map3.cend()))
+            == 4);
+    }
     SECTION("can intersect any ordered map of pairs")
     {
         std::map<oki::Handle, unsigned int> map1;
@@ -311,3 +861,48 @@ TEST_CASE("variadic_set_intersection()", "[logic][ecs][algorithm]")
         helper.do_test({ 1, 2, 8 }, map1, map2);
     }
 }
+
+TEST_CASE("IntersectionIterator", "[logic][ecs][algorithm]")
+{
+    using Map = oki::intl_::AssocSortedVector<oki::Handle, unsigned int>;
+    using Iterator = oki::intl_::IntersectionIterator<Map::iterator,
+        Map::iterator>;
+
+    auto map1 = test_helper::IntersectionHelper<unsigned int>::create_map(
+        { 1, 3, 4, 5, 8, 9, 10 });
+    auto map2 = test_helper::IntersectionHelper<unsigned int>::create_map(
+        { 2, 3, 4, 7, 8, 9 });
+
+    Iterator begin { std::make_pair(map1.begin(), map1.end()),
+        std::make_pair(map2.begin(), map2.end()) };
+    Iterator end { std::make_pair(map1.end(), map1.end()),
+        std::make_pair(map2.end(), map2.end()) };
+
+    SECTION("visits the same keys as variadic_set_intersection()")
+    {
+        std::vector<unsigned int> values;
+        for (auto iter = begin; iter != end; ++iter) {
+            auto [pair1, pair2] = *iter;
+
+            CHECK(pair1.first == pair2.first);
+            values.push_back(pair1.second);
+        }
+
+        REQUIRE(values == std::vector<unsigned int> { 3, 4, 8, 9 });
+    }
+    SECTION("yields references into the underlying ranges")
+    {
+        std::get<1>(*begin).second = 0;
+        REQUIRE(map2.find(3)->second == 0);
+    }
+    SECTION("compares equal to end when a range is empty")
+    {
+        Map empty;
+        Iterator emptyBegin { std::make_pair(map1.begin(), map1.end()),
+            std::make_pair(empty.begin(), empty.end()) };
+        Iterator emptyEnd { std::make_pair(map1.end(), map1.end()),
+            std::make_pair(empty.end(), empty.end()) };
+
+        REQUIRE(emptyBegin == emptyEnd);
+    }
+}
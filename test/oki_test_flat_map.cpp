@@ -0,0 +1,153 @@
+#include "oki/util/oki_flat_map.h"
+#include "oki/util/oki_type_erasure.h"
+
+#include "oki_test_util.h"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+using Value = test_helper::ObjHelper;
+
+TEST_CASE("FlatHashMap", "[logic][ecs][container]")
+{
+    oki::intl_::FlatHashMap<std::uint64_t, std::string> map;
+
+    SECTION("can insert and find values")
+    {
+        auto [iter, success] = map.emplace(1, "1");
+
+        REQUIRE(success);
+        REQUIRE(iter->first == 1);
+        REQUIRE(iter->second == "1");
+
+        REQUIRE(map.find(1) != map.end());
+        REQUIRE(map.find(1)->second == "1");
+        REQUIRE(map.contains(1));
+        REQUIRE(map.size() == 1);
+    }
+    SECTION("does not overwrite present keys")
+    {
+        map.emplace(1, "1");
+        auto [iter, success] = map.emplace(1, "2");
+
+        REQUIRE_FALSE(success);
+        REQUIRE(iter->second == "1");
+        REQUIRE(map.size() == 1);
+    }
+    SECTION("rejects absent keys")
+    {
+        REQUIRE(map.find(1) == map.end());
+        REQUIRE_FALSE(map.contains(1));
+
+        map.emplace(1, "1");
+        REQUIRE(map.find(2) == map.end());
+        REQUIRE_FALSE(map.contains(2));
+    }
+    SECTION("can erase keys")
+    {
+        map.emplace(1, "1");
+        map.emplace(2, "2");
+
+        REQUIRE(map.erase(1) == 1);
+        REQUIRE(map.erase(1) == 0);
+
+        REQUIRE_FALSE(map.contains(1));
+        REQUIRE(map.find(2)->second == "2");
+        REQUIRE(map.size() == 1);
+    }
+    SECTION("can clear and be reused")
+    {
+        map.emplace(1, "1");
+        map.clear();
+
+        REQUIRE(map.empty());
+        REQUIRE(map.begin() == map.end());
+
+        map.emplace(1, "2");
+        REQUIRE(map.find(1)->second == "2");
+    }
+    SECTION("behaves like std::map under many random operations")
+    {
+        std::map<std::uint64_t, std::string> reference;
+        std::mt19937_64 rng { 1234 };
+
+        for (int i = 0; i != 20'000; ++i) {
+            // Small key range so that we get plenty of collisions + erasures
+            auto key = rng() % 2048;
+
+            if (rng() % 3) {
+                auto value = std::to_string(i);
+                CHECK(map.emplace(key, value).second
+                    == reference.emplace(key, value).second);
+            } else {
+                CHECK(map.erase(key) == reference.erase(key));
+            }
+        }
+
+        REQUIRE(map.size() == reference.size());
+
+        std::size_t visited = 0;
+        for (const auto& [key, value] : map) {
+            auto refIter = reference.find(key);
+
+            REQUIRE(refIter != reference.end());
+            REQUIRE(refIter->second == value);
+            ++visited;
+        }
+
+        REQUIRE(visited == reference.size());
+    }
+    SECTION("can be copied and moved")
+    {
+        for (std::uint64_t i = 0; i != 100; ++i) {
+            map.emplace(i, std::to_string(i));
+        }
+
+        auto copy = map;
+        auto moved = std::move(map);
+
+        REQUIRE(copy.size() == 100);
+        REQUIRE(moved.size() == 100);
+        REQUIRE(map.empty());
+
+        for (std::uint64_t i = 0; i != 100; ++i) {
+            REQUIRE(copy.find(i)->second == std::to_string(i));
+            REQUIRE(moved.find(i)->second == std::to_string(i));
+        }
+    }
+    SECTION("can be keyed on oki::intl_::TypeIndex")
+    {
+        oki::intl_::FlatHashMap<oki::intl_::TypeIndex, int> types;
+
+        types.emplace(oki::intl_::get_type<int>(), 1);
+        types.emplace(oki::intl_::get_type<float>(), 2);
+
+        REQUIRE(types.find(oki::intl_::get_type<int>())->second == 1);
+        REQUIRE(types.find(oki::intl_::get_type<const float&>())->second == 2);
+        REQUIRE_FALSE(types.contains(oki::intl_::get_type<char>()));
+    }
+    SECTION("(lifetime management)")
+    {
+        Value::reset();
+
+        {
+            oki::intl_::FlatHashMap<int, Value> values;
+            for (int i = 0; i != 100; ++i) {
+                values.emplace(i, i);
+            }
+            for (int i = 0; i != 100; i += 2) {
+                values.erase(i);
+            }
+
+            REQUIRE(values.size() == 50);
+            REQUIRE(values.find(51)->second.value_ == 51);
+        }
+
+        Value::test();
+    }
+}
@@ -6,7 +6,10 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 /*
  * We know that (for this implementation) the handle generators will create the
@@ -17,7 +20,9 @@
  */
 TEMPLATE_TEST_CASE("All handle generators", "[logic][ecs][handle]",
     (oki::intl_::LinearHandleGenerator<>), (oki::intl_::ReuseHandleGenerator<>),
-    (oki::intl_::DebugHandleGenerator<>))
+    (oki::intl_::DebugHandleGenerator<>),
+    (oki::intl_::GenerationalHandleGenerator<>),
+    (oki::intl_::ConcurrentHandleGenerator<>))
 {
     // Generate 15 handles to check against our requirements
     TestType handleGen;
@@ -47,7 +52,9 @@ TEMPLATE_TEST_CASE("All handle generators", "[logic][ecs][handle]",
 // Guarantees specific to the OKI handle generators go in this test case
 TEMPLATE_TEST_CASE("OKI handle generators", "[logic][ecs][handle]",
     (oki::intl_::LinearHandleGenerator<>), (oki::intl_::ReuseHandleGenerator<>),
-    (oki::intl_::DebugHandleGenerator<>))
+    (oki::intl_::DebugHandleGenerator<>),
+    (oki::intl_::GenerationalHandleGenerator<>),
+    (oki::intl_::ConcurrentHandleGenerator<>))
 {
     // Generate 15 handle to check against our requirements (just as before)
     TestType handleGen;
@@ -88,7 +95,8 @@ TEMPLATE_TEST_CASE("OKI handle generators", "[logic][ecs][handle]",
 
 // Extra verification guarantees provided by the two tracking generators
 TEMPLATE_TEST_CASE("OKI tracking handle generators", "[logic][ecs][handle]",
-    (oki::intl_::ReuseHandleGenerator<>), (oki::intl_::DebugHandleGenerator<>))
+    (oki::intl_::ReuseHandleGenerator<>), (oki::intl_::DebugHandleGenerator<>),
+    (oki::intl_::GenerationalHandleGenerator<>))
 {
     TestType handleGen;
     auto handle = handleGen.create_handle();
@@ -133,4 +141,172 @@ TEST_CASE("DebugHandleGenerator", "[logic][ecs][handle]")
         handleGen.reset();
         CHECK_FALSE(handleGen.destroy_handle(handle));
     }
+    SECTION("tracks deletions across pages, and releases full ones")
+    {
+        using Generator = oki::intl_::DebugHandleGenerator<>;
+        handleGen.reset();
+
+        std::vector<oki::Handle> handles;
+        while (handles.size() != 3 * Generator::PAGE_SIZE) {
+            handles.push_back(handleGen.create_handle());
+        }
+
+        // Leave the first page's first handle and most of the last page
+        // alive, so only the middle page is full
+        std::size_t destroyed = 0;
+        for (std::size_t i = 1; i != 2 * Generator::PAGE_SIZE + 1; ++i) {
+            destroyed += handleGen.destroy_handle(handles[i]);
+        }
+        CHECK(destroyed == 2 * Generator::PAGE_SIZE);
+        CHECK(handleGen.memory_usage() < 3 * Generator::PAGE_SIZE / 8);
+
+        std::size_t wrong = 0;
+        for (std::size_t i = 0; i != handles.size(); ++i) {
+            bool alive = i == 0 || i > 2 * Generator::PAGE_SIZE;
+            wrong += handleGen.verify_handle(handles[i]) != alive;
+        }
+        CHECK(wrong == 0);
+        CHECK_FALSE(handleGen.destroy_handle(handles[Generator::PAGE_SIZE]));
+    }
+}
+
+TEMPLATE_TEST_CASE("GenerationalHandleGenerator", "[logic][ecs][handle]",
+    std::uint32_t, std::uint64_t)
+{
+    using Generator = oki::intl_::GenerationalHandleGenerator<TestType>;
+
+    Generator handleGen;
+    auto handle = handleGen.create_handle();
+    handleGen.create_handle();
+
+    SECTION("reuses indices under a new generation")
+    {
+        handleGen.destroy_handle(handle);
+        auto reused = handleGen.create_handle();
+
+        REQUIRE(reused != handle);
+        REQUIRE((reused & Generator::MAX_INDEX)
+            == (handle & Generator::MAX_INDEX));
+
+        CHECK(handleGen.verify_handle(reused));
+        CHECK_FALSE(handleGen.verify_handle(handle));
+        CHECK_FALSE(handleGen.destroy_handle(handle));
+    }
+    SECTION("correctly identifies a double-delete")
+    {
+        REQUIRE(handleGen.destroy_handle(handle));
+        REQUIRE_FALSE(handleGen.destroy_handle(handle));
+    }
+    SECTION("retires indices whose generations are exhausted")
+    {
+        for (TestType i = 0; i != Generator::MAX_GENERATION; ++i) {
+            REQUIRE(handleGen.destroy_handle(handle));
+            handle = handleGen.create_handle();
+        }
+
+        handleGen.destroy_handle(handle);
+        auto fresh = handleGen.create_handle();
+
+        CHECK((fresh & Generator::MAX_INDEX)
+            != (handle & Generator::MAX_INDEX));
+        CHECK_FALSE(handleGen.verify_handle(handle));
+    }
+}
+
+TEST_CASE("ConcurrentHandleGenerator", "[logic][ecs][handle]")
+{
+    using Generator = oki::intl_::ConcurrentHandleGenerator<>;
+    Generator handleGen;
+
+    SECTION("reuses deleted handles")
+    {
+        auto handle = handleGen.create_handle();
+        handleGen.destroy_handle(handle);
+
+        REQUIRE(handleGen.create_handle() == handle);
+    }
+    SECTION("reuses handles within a cache, then shares them when flushed")
+    {
+        Generator::Cache cache { handleGen };
+
+        auto handle = cache.create_handle();
+        cache.destroy_handle(handle);
+        CHECK(cache.create_handle() == handle);
+
+        cache.destroy_handle(handle);
+        cache.flush();
+
+        std::unordered_set<oki::Handle> reused;
+        for (std::size_t i = 0; i != Generator::BLOCK_SIZE; ++i) {
+            reused.insert(handleGen.create_handle());
+        }
+        CHECK(reused.count(handle));
+    }
+    SECTION("gives each thread its own cache")
+    {
+        auto* mainCache = &handleGen.thread_cache();
+        CHECK(&handleGen.thread_cache() == mainCache);
+
+        Generator::Cache* workerCache = nullptr;
+        std::thread([&]() { workerCache = &handleGen.thread_cache(); }).join();
+        CHECK(workerCache != mainCache);
+
+        // A handle destroyed through the cache is reused by this thread
+        auto handle = mainCache->create_handle();
+        mainCache->destroy_handle(handle);
+        CHECK(handleGen.thread_cache().create_handle() == handle);
+    }
+    SECTION("keeps thread caches apart from other (and dead) generators")
+    {
+        auto first = oki::intl_::get_first_valid_handle<>();
+
+        std::vector<oki::Handle> handles;
+        for (std::size_t i = 0; i != Generator::THREAD_CACHES * 2; ++i) {
+            Generator other;
+            CHECK(other.thread_cache().create_handle() == first);
+
+            handles.push_back(handleGen.thread_cache().create_handle());
+        }
+
+        // handleGen's cache survived, so kept issuing from its block
+        for (std::size_t i = 0; i != handles.size(); ++i) {
+            CHECK(handles[i] == first + i);
+        }
+    }
+    SECTION("generates distinct handles from many threads")
+    {
+        constexpr std::size_t PER_THREAD = 5'000;
+        std::array<std::vector<oki::Handle>, 4> created;
+
+        std::vector<std::thread> threads;
+        for (auto& handles : created) {
+            threads.emplace_back([&handleGen, &handles]() {
+                Generator::Cache cache { handleGen };
+
+                // Destroy (and so reuse) every third handle
+                for (std::size_t i = 0; i != PER_THREAD; ++i) {
+                    auto handle = cache.create_handle();
+                    if (i % 3 == 0) {
+                        cache.destroy_handle(handle);
+                    } else {
+                        handles.push_back(handle);
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::unordered_set<oki::Handle> distinct;
+        for (const auto& handles : created) {
+            for (auto handle : handles) {
+                CHECK(handleGen.verify_handle(handle));
+                distinct.insert(handle);
+            }
+        }
+
+        CHECK(distinct.size() == created.size() * (PER_THREAD * 2 / 3));
+    }
 }
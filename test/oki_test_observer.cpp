@@ -4,6 +4,7 @@
 #include "catch2/catch_test_macros.hpp"
 
 #include <numeric>
+#include <optional>
 #include <vector>
 
 template <typename Subject>
@@ -129,6 +130,66 @@ TEMPLATE_TEST_CASE("SubjectPipe", "[logic][ecs][system]",
     }
 }
 
+TEST_CASE("SubjectPipe (reentrancy)", "[logic][ecs][system]")
+{
+    oki::SubjectPipe<int> pipe;
+
+    // Disconnects another observer the first time it observes something
+    class Disconnector : public oki::Observer<int>
+    {
+    public:
+        Disconnector(oki::SubjectPipe<int>& pipe)
+            : pipe_(pipe)
+        {
+        }
+
+        void observe(int value, oki::ObserverOptions&) override
+        {
+            values_.push_back(value);
+
+            if (target_) {
+                pipe_.disconnect(*target_);
+                target_.reset();
+            }
+        }
+
+        std::vector<int> values_;
+        std::optional<oki::Handle> target_;
+
+    private:
+        oki::SubjectPipe<int>& pipe_;
+    };
+
+    Observer<int> before, after;
+    Disconnector disconnector { pipe };
+
+    auto beforeHandle = pipe.connect(before);
+    pipe.connect(disconnector);
+    auto afterHandle = pipe.connect(after);
+
+    SECTION("can disconnect an earlier observer during send()")
+    {
+        disconnector.target_ = beforeHandle;
+
+        pipe.send(1);
+        pipe.send(2);
+
+        REQUIRE(before.values_ == std::vector<int> { 1 });
+        REQUIRE(disconnector.values_ == std::vector<int> { 1, 2 });
+        REQUIRE(after.values_ == std::vector<int> { 1, 2 });
+    }
+    SECTION("can disconnect a later observer during send()")
+    {
+        disconnector.target_ = afterHandle;
+
+        pipe.send(1);
+
+        REQUIRE(before.values_ == std::vector<int> { 1 });
+        REQUIRE(disconnector.values_ == std::vector<int> { 1 });
+        REQUIRE(after.values_.empty());
+    }
+}
+
 TEST_CASE("SignalManager")
 {
     oki::SignalManager sigMan;
@@ -0,0 +1,142 @@
+#include "oki/util/oki_parallel.h"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallel_for_chunks()", "[logic][parallel]")
+{
+    SECTION("covers the whole range exactly once")
+    {
+        constexpr std::size_t NUM_ITEMS = 1000, NUM_CHUNKS = 7;
+
+        std::vector<int> visits(NUM_ITEMS, 0);
+        std::vector<std::size_t> chunkSizes(NUM_CHUNKS, 0);
+
+        oki::intl_::parallel_for_chunks(NUM_ITEMS, NUM_CHUNKS,
+            [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                chunkSizes[chunk] = end - begin;
+
+                for (auto i = begin; i != end; ++i) {
+                    ++visits[i];
+                }
+            });
+
+        REQUIRE(std::vector<int>(NUM_ITEMS, 1) == visits);
+        for (auto size : chunkSizes) {
+            CHECK((size == NUM_ITEMS / NUM_CHUNKS
+                || size == NUM_ITEMS / NUM_CHUNKS + 1));
+        }
+    }
+    SECTION("never uses more chunks than items")
+    {
+        std::vector<int> visits(3, 0);
+        oki::intl_::parallel_for_chunks(3, 8,
+            [&](std::size_t, std::size_t begin, std::size_t end) {
+                CHECK(end - begin == 1);
+                ++visits[begin];
+            });
+
+        REQUIRE(std::vector<int>(3, 1) == visits);
+    }
+    SECTION("rethrows exceptions from worker threads")
+    {
+        REQUIRE_THROWS_AS(
+            oki::intl_::parallel_for_chunks(100, 4,
+                [](std::size_t chunk, std::size_t, std::size_t) {
+                    if (chunk == 2) {
+                        throw std::runtime_error("chunk failed");
+                    }
+                }),
+            std::runtime_error);
+    }
+    SECTION("reuses the same threads on every call")
+    {
+        auto collect_threads = [](std::set<std::thread::id>& ids) {
+            std::mutex mutex;
+            oki::intl_::parallel_for_chunks(4, 4,
+                [&](std::size_t, std::size_t, std::size_t) {
+                    std::lock_guard lock { mutex };
+                    ids.insert(std::this_thread::get_id());
+                });
+        };
+
+        std::set<std::thread::id> first, second;
+        collect_threads(first);
+        collect_threads(second);
+
+        CHECK(first.size() == 4);
+        CHECK(first == second);
+    }
+    SECTION("runs nested loops serially")
+    {
+        std::vector<int> visits(16, 0);
+        oki::intl_::parallel_for_chunks(4, 4,
+            [&](std::size_t, std::size_t outer, std::size_t) {
+                auto calledOn = std::this_thread::get_id();
+
+                oki::intl_::parallel_for_chunks(4, 4,
+                    [&](std::size_t, std::size_t inner, std::size_t) {
+                        CHECK(std::this_thread::get_id() == calledOn);
+                        ++visits[outer * 4 + inner];
+                    });
+            });
+
+        REQUIRE(std::vector<int>(16, 1) == visits);
+    }
+}
+
+TEST_CASE("CacheAligned", "[logic][parallel]")
+{
+    SECTION("keeps each value on its own cache line")
+    {
+        std::vector<oki::intl_::CacheAligned<int>> values(2);
+
+        REQUIRE(sizeof(values[0]) >= oki::intl_::CACHE_LINE_SIZE);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(&values[1])
+                - reinterpret_cast<std::uintptr_t>(&values[0])
+            >= oki::intl_::CACHE_LINE_SIZE);
+    }
+}
+
+TEST_CASE("Worker", "[logic][parallel]")
+{
+    std::vector<std::thread::id> ranOn;
+    bool shouldThrow = false;
+
+    oki::intl_::Worker worker([&]() {
+        ranOn.push_back(std::this_thread::get_id());
+        if (shouldThrow) {
+            throw std::runtime_error("");
+        }
+    });
+
+    SECTION("runs the task on the same thread every time")
+    {
+        for (int i = 0; i != 3; ++i) {
+            worker.run();
+            worker.wait();
+        }
+
+        REQUIRE(ranOn.size() == 3);
+        CHECK(ranOn[0] != std::this_thread::get_id());
+        CHECK(ranOn[1] == ranOn[0]);
+        CHECK(ranOn[2] == ranOn[0]);
+    }
+    SECTION("rethrows exceptions from the task, once")
+    {
+        shouldThrow = true;
+        worker.run();
+        CHECK_THROWS_AS(worker.wait(), std::runtime_error);
+
+        shouldThrow = false;
+        worker.run();
+        CHECK_NOTHROW(worker.wait());
+    }
+}
@@ -0,0 +1,116 @@
+#include "oki/oki_ecs.h"
+#include "oki/oki_resource.h"
+
+#include "oki_test_util.h"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+struct Config
+{
+    int width, height;
+};
+
+struct Timer
+{
+    double elapsed = 0.;
+};
+}
+
+TEST_CASE("ResourceManager")
+{
+    oki::ResourceManager resMan;
+
+    SECTION("can add and retrieve resources")
+    {
+        auto& config = resMan.emplace_resource<Config>(640, 480);
+        resMan.emplace_resource<Timer>();
+
+        CHECK(&resMan.resource<Config>() == &config);
+        CHECK(resMan.resource<Config>().height == 480);
+        CHECK(resMan.resource<const Config&>().width == 640);
+
+        resMan.resource<Timer>().elapsed = 2.;
+        CHECK(std::as_const(resMan).resource<Timer>().elapsed == 2.);
+    }
+    SECTION("replaces existing resources")
+    {
+        resMan.emplace_resource<std::string>("old");
+        resMan.emplace_resource<std::string>("new");
+
+        CHECK(resMan.resource<std::string>() == "new");
+    }
+    SECTION("can check for and remove resources")
+    {
+        CHECK_FALSE(resMan.has_resource<Config>());
+        CHECK_FALSE(resMan.try_resource<Config>());
+
+        resMan.emplace_resource<Config>(1, 2);
+        CHECK(resMan.has_resource<Config>());
+        CHECK(resMan.try_resource<Config>()->height == 2);
+
+        CHECK(resMan.remove_resource<Config>());
+        CHECK_FALSE(resMan.remove_resource<Config>());
+        CHECK_FALSE(resMan.has_resource<Config>());
+    }
+    SECTION("destroys its resources")
+    {
+        using Value = test_helper::ObjHelper;
+        Value::reset();
+
+        {
+            oki::ResourceManager scoped;
+            scoped.emplace_resource<Value>(5);
+            scoped.emplace_resource<Value>(6);
+
+            CHECK(Value::numDestructs == 1);
+        }
+
+        Value::test();
+    }
+#if OKI_CHECKED
+    SECTION("rejects missing resources")
+    {
+        CHECK_THROWS_AS(resMan.resource<Config>(), std::logic_error);
+    }
+#endif
+    SECTION("is part of the Engine")
+    {
+        oki::Engine engine;
+        engine.emplace_resource<Timer>().elapsed = 1.;
+
+        CHECK(engine.resource<Timer>().elapsed == 1.);
+    }
+}
+
+TEST_CASE("ResourceAccess")
+{
+    auto physics = oki::ResourceAccess().reads<Config>().writes<Timer>();
+    auto render = oki::ResourceAccess().reads<Config, std::string>();
+
+    SECTION("records reads and writes")
+    {
+        CHECK(physics.will_read<Config>());
+        CHECK_FALSE(physics.will_write<Config>());
+        CHECK(physics.will_read<Timer>());
+        CHECK(physics.will_write<Timer>());
+        CHECK_FALSE(render.will_read<Timer>());
+    }
+    SECTION("allows shared reads")
+    {
+        CHECK_FALSE(physics.conflicts_with(render));
+        CHECK_FALSE(render.conflicts_with(physics));
+    }
+    SECTION("rejects reads and writes of a written resource")
+    {
+        render.reads<Timer>();
+        CHECK(physics.conflicts_with(render));
+        CHECK(render.conflicts_with(physics));
+
+        CHECK(physics.conflicts_with(physics));
+        CHECK_FALSE(render.conflicts_with(render));
+    }
+}
@@ -0,0 +1,160 @@
+#include "oki/oki_scratch.h"
+#include "oki/oki_system.h"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+TEST_CASE("ScratchArena")
+{
+    oki::ScratchArena arena;
+
+    SECTION("allocates aligned, distinct memory")
+    {
+        auto* first = static_cast<char*>(arena.allocate(3, 1));
+        auto* second = arena.allocate(16, 16);
+        auto* third = arena.allocate(8, 8);
+
+        CHECK(reinterpret_cast<std::uintptr_t>(second) % 16 == 0);
+        CHECK(reinterpret_cast<std::uintptr_t>(third) % 8 == 0);
+        CHECK(static_cast<char*>(second) >= first + 3);
+        CHECK(static_cast<char*>(third) >= static_cast<char*>(second) + 16);
+    }
+    SECTION("reuses memory after a reset")
+    {
+        auto* first = arena.allocate(64, 8);
+        arena.reset();
+
+        CHECK(arena.allocate(64, 8) == first);
+    }
+    SECTION("gives back the latest allocation")
+    {
+        auto* first = arena.allocate(64, 8);
+        arena.deallocate(first, 64);
+        CHECK(arena.allocate(32, 8) == first);
+
+        // Anything older than that stays put
+        auto* second = arena.allocate(32, 8);
+        arena.deallocate(first, 32);
+        CHECK(arena.allocate(32, 8) != second);
+    }
+    SECTION("grows past a block and stops growing after a reset")
+    {
+        constexpr auto SIZE = oki::ScratchArena::BLOCK_SIZE / 4;
+
+        for (int i = 0; i < 10; ++i) {
+            arena.allocate(SIZE, 8);
+        }
+
+        auto capacity = arena.capacity();
+        REQUIRE(capacity >= 10 * SIZE);
+
+        arena.reset();
+        for (int i = 0; i < 10; ++i) {
+            arena.allocate(SIZE, 8);
+        }
+
+        CHECK(arena.capacity() == capacity);
+    }
+    SECTION("fits allocations larger than a block")
+    {
+        constexpr auto SIZE = oki::ScratchArena::BLOCK_SIZE * 3;
+
+        auto* ptr = static_cast<std::byte*>(arena.allocate(SIZE, 64));
+        ptr[0] = ptr[SIZE - 1] = std::byte { 1 };
+
+        CHECK(reinterpret_cast<std::uintptr_t>(ptr) % 64 == 0);
+        CHECK(arena.capacity() >= SIZE);
+    }
+}
+
+TEST_CASE("ScratchAllocator")
+{
+    oki::ScratchArena arena;
+
+    SECTION("backs standard containers")
+    {
+        oki::ScratchVector<int> vec(arena);
+        for (int i = 0; i < 1000; ++i) {
+            vec.push_back(i);
+        }
+
+        std::map<int, int, std::less<int>,
+            oki::ScratchAllocator<std::pair<const int, int>>>
+            map(arena);
+        for (auto value : vec) {
+            map.emplace(value, value * 2);
+        }
+
+        CHECK(vec.size() == 1000);
+        CHECK(vec[999] == 999);
+        CHECK(map.at(500) == 1000);
+    }
+    SECTION("compares equal when sharing an arena")
+    {
+        oki::ScratchArena other;
+        oki::ScratchAllocator<int> ints(arena);
+        oki::ScratchAllocator<double> doubles(ints);
+
+        CHECK(ints == doubles);
+        CHECK(ints != oki::ScratchAllocator<int>(other));
+    }
+}
+
+TEST_CASE("SystemOptions::scratch()")
+{
+    oki::SystemManager sysMan;
+    void* stepMemory[2] = {};
+    int stepIdx = 0;
+
+    auto funcSys = oki::create_functional_system(
+        [&](auto&, oki::SystemOptions& opts) {
+            // Never given back, so only a reset can make it available
+            stepMemory[stepIdx++] = opts.scratch().allocate(128, 8);
+            CHECK(&opts.scratch() == &oki::thread_scratch());
+        });
+
+    sysMan.add_system(*funcSys);
+    oki::thread_scratch().reset();
+
+    // Reset after each step, so the same memory is handed out again
+    sysMan.step();
+    sysMan.step();
+
+    CHECK(stepMemory[0] == stepMemory[1]);
+}
+
+TEST_CASE("SystemOptions::scratch() (pipelined)")
+{
+    oki::SystemManager sysMan;
+    std::vector<oki::ScratchArena*> arenas;
+    std::vector<void*> stepMemory;
+
+    auto simulate = oki::create_functional_system(
+        [&](auto&, oki::SystemOptions& opts) {
+            arenas.push_back(&opts.scratch());
+            stepMemory.push_back(opts.scratch().allocate(128, 8));
+        });
+    auto extract = oki::create_functional_system(
+        [&](auto&, oki::SystemOptions& opts) {
+            if (arenas.size() == 4) {
+                opts.exit();
+            }
+        });
+
+    sysMan.add_staged_system(oki::SystemStage::SIMULATE, *simulate);
+    sysMan.add_staged_system(oki::SystemStage::EXTRACT, *extract);
+    sysMan.run_pipelined();
+
+    // The first frame is simulated on this thread, the rest on one other
+    // thread whose arena is reset (not replaced) every frame
+    REQUIRE(arenas.size() == 4);
+    CHECK(arenas[1] != arenas[0]);
+    CHECK(arenas[2] == arenas[1]);
+    CHECK(arenas[3] == arenas[1]);
+    CHECK(stepMemory[2] == stepMemory[1]);
+    CHECK(stepMemory[3] == stepMemory[1]);
+}
@@ -0,0 +1,107 @@
+#include "oki/oki_config.h"
+
+// Sharding carves shards out of 64-bit handles (see oki_sharded.h)
+#if OKI_HANDLE_BITS == 64
+#include "oki/oki_sharded.h"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("ShardedComponentManager")
+{
+    oki::ShardedComponentManager sharded(4);
+
+    SECTION("rejects invalid numbers of shards")
+    {
+        CHECK_THROWS_AS(oki::ShardedComponentManager(0), std::logic_error);
+        CHECK_THROWS_AS(
+            oki::ShardedComponentManager(
+                oki::ShardedComponentManager::MAX_SHARDS + 1),
+            std::logic_error);
+    }
+    SECTION("keeps entities of different shards apart")
+    {
+        auto first = sharded.shard(0);
+        auto last = sharded.shard(3);
+
+        auto entity0 = first.create_entity();
+        auto entity3 = last.create_entity();
+
+        first.bind_component(entity0, 0);
+        last.bind_component(entity3, 3);
+
+        CHECK(sharded.shard_of(entity0).index() == 0);
+        CHECK(sharded.shard_of(entity3).index() == 3);
+        CHECK(sharded.shard_of(entity3).get_component<int>(entity3) == 3);
+        CHECK(first.get_component<int>(entity0) == 0);
+
+        CHECK(last.remove_component<int>(entity3));
+        CHECK(sharded.num_components<int>() == 1);
+        CHECK(first.has_component<int>(entity0));
+    }
+    SECTION("iterates over every shard")
+    {
+        for (std::size_t idx = 0; idx != sharded.num_shards(); ++idx) {
+            auto shard = sharded.shard(idx);
+            auto entity = shard.create_entity();
+
+            shard.bind_component(entity, static_cast<int>(idx));
+            shard.bind_component(entity, 'c');
+        }
+
+        int sum = 0;
+        sharded.for_each<int, char>([&](oki::Entity entity, int value, char) {
+            CHECK(sharded.shard_of(entity).index()
+                == static_cast<std::size_t>(value));
+            sum += value;
+        });
+        CHECK(sum == 0 + 1 + 2 + 3);
+        CHECK(sharded.count<int, char>() == 4);
+
+        int visited = 0;
+        sharded.for_each<int>([&](oki::Entity, int) { return ++visited < 2; });
+        CHECK(visited == 2);
+    }
+    SECTION("allows structural changes on distinct shards in parallel")
+    {
+        constexpr std::size_t PER_SHARD = 1'000;
+
+        std::vector<std::thread> threads;
+        for (std::size_t idx = 0; idx != sharded.num_shards(); ++idx) {
+            threads.emplace_back([&sharded, idx]() {
+                auto shard = sharded.shard(idx);
+
+                for (std::size_t i = 0; i != PER_SHARD; ++i) {
+                    auto entity = shard.create_entity();
+                    shard.bind_component(entity, static_cast<int>(i));
+
+                    if (i % 2) {
+                        shard.destroy_entity(entity);
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        CHECK(sharded.num_components<int>()
+            == sharded.num_shards() * PER_SHARD / 2);
+
+        // (Catch2 assertions are not thread-safe, so count instead)
+        std::atomic<std::size_t> visited = 0, odd = 0;
+        sharded.for_each_parallel<int>([&](oki::Entity, int value) {
+            odd += value % 2;
+            ++visited;
+        });
+        CHECK(visited == sharded.num_components<int>());
+        CHECK(odd == 0);
+    }
+}
+#endif
@@ -3,6 +3,9 @@
 
 #include "catch2/catch_test_macros.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <vector>
 
 struct TestSystem : public oki::System
@@ -151,4 +154,145 @@ TEST_CASE("SystemManager")
         sysMan.remove_system(handle);
         CHECK_FALSE(sysMan.get_system(handle));
     }
+    SECTION("runs stages in order")
+    {
+        std::vector<oki::SystemStage> callOrder;
+        auto staged_func_sys = [&callOrder](oki::SystemStage stage) {
+            return oki::create_functional_system(
+                [=, &callOrder](auto&...) { callOrder.push_back(stage); });
+        };
+
+        auto present = staged_func_sys(oki::SystemStage::PRESENT);
+        auto extract = staged_func_sys(oki::SystemStage::EXTRACT);
+        auto simulate = staged_func_sys(oki::SystemStage::SIMULATE);
+
+        sysMan.add_staged_system(oki::SystemStage::PRESENT, *present, 30);
+        sysMan.add_staged_system(oki::SystemStage::EXTRACT, *extract, 20);
+        sysMan.add_staged_system(oki::SystemStage::SIMULATE, *simulate);
+
+        sysMan.step();
+        CHECK(system.numCalls == 1);
+        REQUIRE(callOrder
+            == std::vector<oki::SystemStage> { oki::SystemStage::SIMULATE,
+                oki::SystemStage::EXTRACT, oki::SystemStage::PRESENT });
+    }
+    SECTION("presents extracted frames when pipelined")
+    {
+        std::atomic<int> simulated = 0;
+        int extracted = 0;
+        std::vector<int> presented;
+
+        auto simulate = oki::create_functional_system(
+            [&](auto&...) { ++simulated; });
+        auto extract = oki::create_functional_system(
+            [&](auto&...) { extracted = simulated; });
+        auto present = oki::create_functional_system(
+            [&](auto&, oki::SystemOptions& opts) {
+                presented.push_back(extracted);
+                if (presented.size() == 4) {
+                    opts.exit(2);
+                }
+            });
+
+        sysMan.add_staged_system(oki::SystemStage::SIMULATE, *simulate);
+        sysMan.add_staged_system(oki::SystemStage::EXTRACT, *extract);
+        sysMan.add_staged_system(oki::SystemStage::PRESENT, *present);
+
+        REQUIRE(sysMan.run_pipelined() == 2);
+        CHECK(presented == std::vector<int> { 1, 2, 3, 4 });
+
+        // The fifth frame was simulated while the fourth was presented
+        CHECK(simulated == 5);
+        CHECK(system.numCalls == 5);
+    }
+    SECTION("overlaps presenting with simulating when pipelined")
+    {
+        std::atomic<int> simulated = 0;
+        int extracted = 0;
+        int numOverlapped = 0;
+
+        auto simulate = oki::create_functional_system(
+            [&](auto&...) { ++simulated; });
+        auto extract = oki::create_functional_system(
+            [&](auto&...) { extracted = simulated; });
+        auto present = oki::create_functional_system(
+            [&](auto&, oki::SystemOptions& opts) {
+                // Would time out if the next frame waited for this one
+                auto deadline = std::chrono::steady_clock::now()
+                    + std::chrono::seconds(10);
+
+                while (simulated == extracted
+                    && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::yield();
+                }
+
+                numOverlapped += (simulated > extracted);
+                if (extracted == 3) {
+                    opts.exit();
+                }
+            });
+
+        sysMan.add_staged_system(oki::SystemStage::SIMULATE, *simulate);
+        sysMan.add_staged_system(oki::SystemStage::EXTRACT, *extract);
+        sysMan.add_staged_system(oki::SystemStage::PRESENT, *present);
+
+        sysMan.run_pipelined();
+        CHECK(numOverlapped == 3);
+    }
+    SECTION("can remove presenting systems when pipelined")
+    {
+        unsigned int numCalls = 0;
+        auto present = oki::create_functional_system(
+            [&](auto&, oki::SystemOptions& opts) {
+                ++numCalls;
+                opts.remove_me();
+            });
+
+        auto presentHandle
+            = sysMan.add_staged_system(oki::SystemStage::PRESENT, *present);
+        REQUIRE(sysMan.remove_system(handle));
+
+        REQUIRE(sysMan.run_pipelined() == 0);
+        CHECK(numCalls == 1);
+        CHECK_FALSE(sysMan.get_system(presentHandle));
+    }
+    SECTION("defers changes to systems made while pipelined")
+    {
+        REQUIRE(sysMan.remove_system(handle));
+
+        TestSystem added;
+        oki::Handle addedHandle {};
+        int simulated = 0;
+
+        auto simulate = oki::create_functional_system(
+            [&](oki::SystemManager& manager, oki::SystemOptions& opts) {
+                // The second frame is simulated while the first is presented
+                if (++simulated == 2) {
+                    addedHandle = manager.add_staged_system(
+                        oki::SystemStage::PRESENT, added);
+                    opts.remove_me();
+                }
+            });
+        auto simulateHandle
+            = sysMan.add_staged_system(oki::SystemStage::SIMULATE, *simulate);
+
+        std::vector<bool> found;
+        auto present = oki::create_functional_system(
+            [&](oki::SystemManager& manager, oki::SystemOptions& opts) {
+                found.push_back(manager.get_system(simulateHandle));
+                if (found.size() == 3) {
+                    opts.exit();
+                }
+            });
+        sysMan.add_staged_system(oki::SystemStage::PRESENT, *present);
+
+        sysMan.run_pipelined();
+
+        // Both changes applied once the first overlapped frames were done
+        CHECK(simulated == 2);
+        CHECK(found == std::vector<bool> { found[0], false, false });
+        CHECK(added.numCalls == 1);
+        CHECK(sysMan.get_system(addedHandle) == &added);
+        CHECK_FALSE(sysMan.get_system(simulateHandle));
+    }
 }
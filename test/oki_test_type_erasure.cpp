@@ -194,3 +194,67 @@ TEMPLATE_TEST_CASE("ErasedType", "[logic][ecs][type]",
         Value::test_max_num_copies(0);
     }
 }
+
+namespace {
+struct TestOps
+{
+    std::size_t (*get)(const void*);
+    void (*set)(void*, std::size_t);
+
+    template <typename Type>
+    static constexpr TestOps create() noexcept
+    {
+        return { [](const void* obj) {
+                    return oki::intl_::erased_cast<Type>(obj)->value_;
+                },
+            [](void* obj, std::size_t value) {
+                oki::intl_::erased_cast<Type>(obj)->value_ = value;
+            } };
+    }
+};
+}
+
+TEMPLATE_TEST_CASE("ErasedType (operations)", "[logic][ecs][type]",
+    (oki::intl_::ErasedType<sizeof(Value), alignof(Value), TestOps>),
+    (oki::intl_::ErasedType<1, 1, TestOps>))
+{
+    SECTION("is no larger than its buffer and a pointer")
+    {
+        STATIC_REQUIRE(sizeof(oki::intl_::ErasedType<8, 8>) == 16);
+        STATIC_REQUIRE(sizeof(oki::intl_::ErasedType<8, 8, TestOps>) == 16);
+    }
+    SECTION("can invoke operations without knowing the type")
+    {
+        TestType value = Value(1u);
+        const auto& constValue = value;
+
+        CHECK(constValue.invoke(&TestOps::get) == 1);
+
+        value.invoke(&TestOps::set, 2);
+        CHECK(value.template get_as<Value>().value_ == 2);
+    }
+    SECTION("carries operations through copies and moves")
+    {
+        TestType value1 = Value(1u);
+        TestType value2 = value1;
+        TestType value3 = std::move(value1);
+
+        CHECK(value2.invoke(&TestOps::get) == 1);
+        CHECK(value3.invoke(&TestOps::get) == 1);
+    }
+    SECTION("knows whether it is empty")
+    {
+        TestType value;
+
+        CHECK_FALSE(value.has_value());
+        if constexpr (oki::intl_::CHECKED) {
+            REQUIRE_THROWS(value.invoke(&TestOps::get));
+        }
+
+        value = Value(1u);
+        CHECK(value.has_value());
+
+        value.reset();
+        CHECK_FALSE(value.has_value());
+    }
+}